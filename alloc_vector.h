@@ -0,0 +1,567 @@
+/* alloc_vector.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `alloc_vector`, a vector whose elements are constructed, relocated, and
+ * destroyed using the uses-allocator construction facilities in
+ * `uses_allocator.h`, so that the container's allocator is passed to its
+ * elements (and to the members of `pair` and `tuple` elements) without the
+ * need for `scoped_allocator_adaptor` (extension).
+ */
+
+#ifndef INCLUDED_ALLOC_VECTOR_DOT_H
+#define INCLUDED_ALLOC_VECTOR_DOT_H
+
+#include <uses_allocator.h>
+#include <memory_resource.h>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// Assign allocator `from` to `to` if the propagation trait is true.
+template <class Alloc>
+inline void propagate_assign(true_type, Alloc& to, const Alloc& from)
+{
+    to = from;
+}
+
+template <class Alloc>
+inline void propagate_assign(false_type, Alloc&, const Alloc&) { }
+
+// Swap allocators `a` and `b` if the propagation trait is true.
+template <class Alloc>
+inline void propagate_swap(true_type, Alloc& a, Alloc& b)
+{
+    using std::swap;
+    swap(a, b);
+}
+
+template <class Alloc>
+inline void propagate_swap(false_type, Alloc&, Alloc&) { }
+
+} // close namespace internal
+
+// A sequence container with the interface of `std::vector` whose elements
+// are constructed with `uninitialized_construct_using_allocator` using the
+// container's allocator.  Elements are relocated with `memcpy` if
+// `is_trivially_relocatable<T>` is true, and otherwise moved if the
+// allocator-extended move selected by uses-allocator construction is
+// `noexcept` and copied if not.  The allocator must use raw pointers.
+template <class T, class Alloc = allocator<T>>
+class alloc_vector
+{
+    typedef allocator_traits<Alloc> AT;
+
+    static_assert(is_same<typename AT::pointer, T*>::value,
+                  "alloc_vector requires an allocator with raw pointers");
+
+    Alloc m_alloc;
+    T*    m_begin;
+    T*    m_end;
+    T*    m_cap;
+
+    typedef is_trivially_relocatable<T> trivially_relocatable;
+
+    // Return the capacity to grow to so that at least `n` more elements fit.
+    size_t grow_capacity(size_t n) const {
+        const size_t sz = size();
+        if (max_size() - sz < n)
+            throw length_error("alloc_vector");
+        size_t cap = capacity() ? 2 * capacity() : 1;
+        if (cap < sz + n || cap > max_size())
+            cap = sz + n;
+        return cap;
+    }
+
+    // Replace the storage with a new block of `cap` elements, relocating the
+    // existing elements.
+    void reallocate(size_t cap) {
+        const size_t sz = size();
+        T* p = AT::allocate(m_alloc, cap);
+        try {
+            uninitialized_relocate_using_allocator(m_begin, m_end, p,
+                                                   m_alloc, m_alloc);
+        }
+        catch (...) {
+            AT::deallocate(m_alloc, p, cap);
+            throw;
+        }
+        deallocate_storage();
+        m_begin = p;
+        m_end = p + sz;
+        m_cap = p + cap;
+    }
+
+    // Grow the storage to `cap` elements and construct a new element from
+    // `args` at index `pos`, relocating the existing elements around it.
+    // The new element is constructed first, since `args` may refer to an
+    // existing element.  If an exception is thrown, `*this` is unchanged.
+    template <class... Args>
+    T* reallocate_emplace(size_t cap, size_t pos, Args&&... args) {
+        using internal::relocate_construct_n;
+        const size_t sz = size();
+        T* p = AT::allocate(m_alloc, cap);
+        T* elem = p + pos;
+        try {
+            Cpp20::uninitialized_construct_using_allocator(
+                elem, m_alloc, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            AT::deallocate(m_alloc, p, cap);
+            throw;
+        }
+        try {
+            relocate_construct_n(trivially_relocatable(), m_begin, pos, p,
+                                 m_alloc);
+            try {
+                relocate_construct_n(trivially_relocatable(), m_begin + pos,
+                                     sz - pos, elem + 1, m_alloc);
+            }
+            catch (...) {
+                internal::relocate_destroy_n(trivially_relocatable(), p, pos);
+                throw;
+            }
+        }
+        catch (...) {
+            elem->~T();
+            AT::deallocate(m_alloc, p, cap);
+            throw;
+        }
+        internal::relocate_destroy_n(trivially_relocatable(), m_begin, sz);
+        deallocate_storage();
+        m_begin = p;
+        m_end = p + sz + 1;
+        m_cap = p + cap;
+        return elem;
+    }
+
+    void deallocate_storage() noexcept {
+        if (m_begin)
+            AT::deallocate(m_alloc, m_begin, capacity());
+    }
+
+    // Construct copies of `[first, last)` at the end, which must have room.
+    template <class InputIt>
+    void construct_at_end(InputIt first, InputIt last) {
+        m_end = uninitialized_copy_using_allocator(first, last, m_end,
+                                                   m_alloc);
+    }
+
+    void destroy_from(T* p) noexcept {
+        destroy_using_allocator(p, m_end, m_alloc);
+        m_end = p;
+    }
+
+    // Take over the storage of `other`, leaving it empty.
+    void steal(alloc_vector& other) noexcept {
+        m_begin = other.m_begin;
+        m_end = other.m_end;
+        m_cap = other.m_cap;
+        other.m_begin = other.m_end = other.m_cap = nullptr;
+    }
+
+public:
+    typedef T                                     value_type;
+    typedef Alloc                                 allocator_type;
+    typedef size_t                                size_type;
+    typedef ptrdiff_t                             difference_type;
+    typedef T&                                    reference;
+    typedef const T&                              const_reference;
+    typedef T*                                    pointer;
+    typedef const T*                              const_pointer;
+    typedef T*                                    iterator;
+    typedef const T*                              const_iterator;
+    typedef std::reverse_iterator<iterator>       reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    alloc_vector() noexcept(noexcept(Alloc())) : alloc_vector(Alloc()) { }
+
+    explicit alloc_vector(const Alloc& a) noexcept
+        : m_alloc(a), m_begin(nullptr), m_end(nullptr), m_cap(nullptr) { }
+
+    explicit alloc_vector(size_t n, const Alloc& a = Alloc())
+        : alloc_vector(a) {
+        reserve(n);
+        m_end = uninitialized_construct_n_using_allocator(m_begin, n, m_alloc);
+    }
+
+    alloc_vector(size_t n, const T& value, const Alloc& a = Alloc())
+        : alloc_vector(a) {
+        reserve(n);
+        m_end = uninitialized_construct_n_using_allocator(m_begin, n, m_alloc,
+                                                          value);
+    }
+
+    template <class InputIt, class = typename
+              iterator_traits<InputIt>::iterator_category>
+    alloc_vector(InputIt first, InputIt last, const Alloc& a = Alloc())
+        : alloc_vector(a) {
+        assign(first, last);
+    }
+
+    alloc_vector(initializer_list<T> il, const Alloc& a = Alloc())
+        : alloc_vector(il.begin(), il.end(), a) { }
+
+    alloc_vector(const alloc_vector& other)
+        : alloc_vector(other,
+                    AT::select_on_container_copy_construction(other.m_alloc))
+        { }
+
+    alloc_vector(const alloc_vector& other, const Alloc& a)
+        : alloc_vector(a) {
+        reserve(other.size());
+        construct_at_end(other.begin(), other.end());
+    }
+
+    alloc_vector(alloc_vector&& other) noexcept
+        : m_alloc(std::move(other.m_alloc)) {
+        steal(other);
+    }
+
+    // Move-construct with allocator `a`.  If `a` differs from the allocator
+    // of `other`, the elements are moved one by one so that they use `a`.
+    alloc_vector(alloc_vector&& other, const Alloc& a)
+        : alloc_vector(a) {
+        if (m_alloc == other.m_alloc)
+            steal(other);
+        else {
+            reserve(other.size());
+            m_end = uninitialized_move_using_allocator(other.m_begin,
+                                                       other.m_end, m_end,
+                                                       m_alloc);
+        }
+    }
+
+    ~alloc_vector() {
+        destroy_using_allocator(m_begin, m_end, m_alloc);
+        deallocate_storage();
+    }
+
+    alloc_vector& operator=(const alloc_vector& rhs) {
+        if (this != &rhs) {
+            if (AT::propagate_on_container_copy_assignment::value &&
+                m_alloc != rhs.m_alloc) {
+                destroy_from(m_begin);
+                deallocate_storage();
+                m_begin = m_end = m_cap = nullptr;
+            }
+            internal::propagate_assign(
+                typename AT::propagate_on_container_copy_assignment(),
+                m_alloc, rhs.m_alloc);
+            assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    alloc_vector& operator=(alloc_vector&& rhs)
+        noexcept(AT::propagate_on_container_move_assignment::value ||
+                 AT::is_always_equal::value) {
+        if (this == &rhs)
+            return *this;
+        if (AT::propagate_on_container_move_assignment::value ||
+            m_alloc == rhs.m_alloc) {
+            destroy_from(m_begin);
+            deallocate_storage();
+            internal::propagate_assign(
+                typename AT::propagate_on_container_move_assignment(),
+                m_alloc, rhs.m_alloc);
+            steal(rhs);
+        }
+        else {
+            // Unequal allocators that don't propagate: move element-wise.
+            assign(make_move_iterator(rhs.begin()),
+                   make_move_iterator(rhs.end()));
+        }
+        return *this;
+    }
+
+    alloc_vector& operator=(initializer_list<T> il) {
+        assign(il.begin(), il.end());
+        return *this;
+    }
+
+    // Replace the contents with copies of `[first, last)`, assigning to
+    // existing elements and constructing or destroying the remainder.
+    template <class InputIt, class = typename
+              iterator_traits<InputIt>::iterator_category>
+    void assign(InputIt first, InputIt last) {
+        assign_imp(first, last,
+                   typename iterator_traits<InputIt>::iterator_category());
+    }
+
+    void assign(size_t n, const T& value) {
+        if (n > capacity()) {
+            alloc_vector tmp(n, value, m_alloc);
+            swap(tmp);
+            return;
+        }
+        const size_t common = std::min(n, size());
+        std::fill_n(m_begin, common, value);
+        if (n > size())
+            m_end = uninitialized_construct_n_using_allocator(m_end,
+                                                  n - size(), m_alloc, value);
+        else
+            destroy_from(m_begin + n);
+    }
+
+    void assign(initializer_list<T> il) { assign(il.begin(), il.end()); }
+
+    allocator_type get_allocator() const noexcept { return m_alloc; }
+
+    // Iterators
+    iterator begin() noexcept { return m_begin; }
+    const_iterator begin() const noexcept { return m_begin; }
+    const_iterator cbegin() const noexcept { return m_begin; }
+    iterator end() noexcept { return m_end; }
+    const_iterator end() const noexcept { return m_end; }
+    const_iterator cend() const noexcept { return m_end; }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept
+        { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept
+        { return const_reverse_iterator(begin()); }
+
+    // Capacity
+    bool empty() const noexcept { return m_begin == m_end; }
+    size_t size() const noexcept { return size_t(m_end - m_begin); }
+    size_t capacity() const noexcept { return size_t(m_cap - m_begin); }
+    size_t max_size() const noexcept { return AT::max_size(m_alloc); }
+
+    void reserve(size_t n) {
+        if (n > max_size())
+            throw length_error("alloc_vector::reserve");
+        if (n > capacity())
+            reallocate(n);
+    }
+
+    void shrink_to_fit() {
+        if (m_end == m_begin) {
+            deallocate_storage();
+            m_begin = m_end = m_cap = nullptr;
+        }
+        else if (m_end != m_cap)
+            reallocate(size());
+    }
+
+    // Element access
+    T& operator[](size_t i) { return m_begin[i]; }
+    const T& operator[](size_t i) const { return m_begin[i]; }
+
+    T& at(size_t i) {
+        if (i >= size())
+            throw out_of_range("alloc_vector::at");
+        return m_begin[i];
+    }
+
+    const T& at(size_t i) const {
+        if (i >= size())
+            throw out_of_range("alloc_vector::at");
+        return m_begin[i];
+    }
+
+    T& front() { return *m_begin; }
+    const T& front() const { return *m_begin; }
+    T& back() { return m_end[-1]; }
+    const T& back() const { return m_end[-1]; }
+    T* data() noexcept { return m_begin; }
+    const T* data() const noexcept { return m_begin; }
+
+    // Modifiers
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (m_end == m_cap)
+            return *reallocate_emplace(grow_capacity(1), size(),
+                                       std::forward<Args>(args)...);
+        Cpp20::uninitialized_construct_using_allocator(
+            m_end, m_alloc, std::forward<Args>(args)...);
+        return *m_end++;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() { (--m_end)->~T(); }
+
+    template <class... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        const size_t i = size_t(pos - m_begin);
+        if (m_end == m_cap)
+            return reallocate_emplace(grow_capacity(1), i,
+                                      std::forward<Args>(args)...);
+        if (m_begin + i == m_end) {
+            Cpp20::uninitialized_construct_using_allocator(
+                m_end, m_alloc, std::forward<Args>(args)...);
+            return m_end++;
+        }
+
+        // Construct the new value first, since `args` may refer to an
+        // element that is about to be moved.
+        T tmp(Cpp20::make_obj_using_allocator<T>(
+                  m_alloc, std::forward<Args>(args)...));
+        Cpp20::uninitialized_construct_using_allocator(
+            m_end, m_alloc, std::move(m_end[-1]));
+        ++m_end;
+        T* p = m_begin + i;
+        std::move_backward(p, m_end - 2, m_end - 1);
+        *p = std::move(tmp);
+        return p;
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+        { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value)
+        { return emplace(pos, std::move(value)); }
+
+    iterator insert(const_iterator pos, size_t n, const T& value) {
+        const size_t i = size_t(pos - m_begin);
+        if (n > size_t(m_cap - m_end)) {
+            // `value` may refer to an element, so copy it before growing.
+            T tmp(Cpp20::make_obj_using_allocator<T>(m_alloc, value));
+            reserve(grow_capacity(n));
+            m_end = uninitialized_construct_n_using_allocator(m_end, n,
+                                                              m_alloc, tmp);
+        }
+        else
+            m_end = uninitialized_construct_n_using_allocator(m_end, n,
+                                                              m_alloc, value);
+        std::rotate(m_begin + i, m_end - n, m_end);
+        return m_begin + i;
+    }
+
+    // Insert copies of `[first, last)` before `pos`.  The new elements are
+    // constructed at the end and then rotated into place.
+    template <class InputIt, class = typename
+              iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        const size_t i = size_t(pos - m_begin);
+        const size_t oldSize = size();
+        for (; first != last; ++first)
+            emplace_back(*first);
+        std::rotate(m_begin + i, m_begin + oldSize, m_end);
+        return m_begin + i;
+    }
+
+    iterator insert(const_iterator pos, initializer_list<T> il)
+        { return insert(pos, il.begin(), il.end()); }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        T* p = m_begin + (first - m_begin);
+        if (first != last)
+            destroy_from(std::move(p + (last - first), m_end, p));
+        return p;
+    }
+
+    void clear() noexcept { destroy_from(m_begin); }
+
+    void resize(size_t n) {
+        if (n <= size())
+            destroy_from(m_begin + n);
+        else {
+            if (n > capacity())
+                reserve(grow_capacity(n - size()));
+            m_end = uninitialized_construct_n_using_allocator(m_end,
+                                                        n - size(), m_alloc);
+        }
+    }
+
+    void resize(size_t n, const T& value) {
+        if (n <= size())
+            destroy_from(m_begin + n);
+        else
+            insert(end(), n - size(), value);
+    }
+
+    void swap(alloc_vector& other)
+        noexcept(AT::propagate_on_container_swap::value ||
+                 AT::is_always_equal::value) {
+        using std::swap;
+        internal::propagate_swap(typename AT::propagate_on_container_swap(),
+                                 m_alloc, other.m_alloc);
+        swap(m_begin, other.m_begin);
+        swap(m_end, other.m_end);
+        swap(m_cap, other.m_cap);
+    }
+
+private:
+    template <class InputIt>
+    void assign_imp(InputIt first, InputIt last, input_iterator_tag) {
+        T* p = m_begin;
+        for (; first != last && p != m_end; ++first, ++p)
+            *p = *first;
+        if (p != m_end)
+            destroy_from(p);
+        else
+            for (; first != last; ++first)
+                emplace_back(*first);
+    }
+
+    template <class FwdIt>
+    void assign_imp(FwdIt first, FwdIt last, forward_iterator_tag) {
+        const size_t n = size_t(std::distance(first, last));
+        if (n > capacity()) {
+            alloc_vector tmp(m_alloc);
+            tmp.reserve(n);
+            tmp.construct_at_end(first, last);
+            swap(tmp);
+            return;
+        }
+        assign_imp(first, last, input_iterator_tag());
+    }
+};
+
+template <class T, class Alloc>
+inline bool operator==(const alloc_vector<T, Alloc>& a,
+                       const alloc_vector<T, Alloc>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <class T, class Alloc>
+inline bool operator!=(const alloc_vector<T, Alloc>& a,
+                       const alloc_vector<T, Alloc>& b)
+{
+    return ! (a == b);
+}
+
+template <class T, class Alloc>
+inline bool operator<(const alloc_vector<T, Alloc>& a,
+                      const alloc_vector<T, Alloc>& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(),
+                                        b.begin(), b.end());
+}
+
+template <class T, class Alloc>
+inline void swap(alloc_vector<T, Alloc>& a, alloc_vector<T, Alloc>& b)
+    noexcept(noexcept(a.swap(b)))
+{
+    a.swap(b);
+}
+
+} // close namespace Cpp20
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+template <class T>
+using alloc_vector = Cpp20::alloc_vector<T, polymorphic_allocator<T>>;
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_ALLOC_VECTOR_DOT_H)
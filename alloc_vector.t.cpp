@@ -0,0 +1,474 @@
+/* alloc_vector.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <alloc_vector.h>
+
+#include <stats_resource.h>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware test type that takes a polymorphic allocator as a trailing
+// constructor argument.  Like a standard container, its copy constructor
+// does not propagate the allocator.
+class PmrType
+{
+    pmr::polymorphic_allocator<> m_alloc;
+    int                          m_value;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static int s_copies;
+    static int s_moves;
+
+    explicit PmrType(int v = 0) : m_value(v) { }
+    explicit PmrType(const allocator_type& a) : m_alloc(a), m_value(0) { }
+    PmrType(int v, const allocator_type& a) : m_alloc(a), m_value(v) { }
+    PmrType(const PmrType& other) : m_value(other.m_value) { ++s_copies; }
+    PmrType(const PmrType& other, const allocator_type& a)
+        : m_alloc(a), m_value(other.m_value) { ++s_copies; }
+    PmrType(PmrType&& other) noexcept
+        : m_alloc(other.m_alloc), m_value(other.m_value) { ++s_moves; }
+    PmrType(PmrType&& other, const allocator_type& a) noexcept
+        : m_alloc(a), m_value(other.m_value) { ++s_moves; }
+
+    PmrType& operator=(const PmrType& rhs)
+        { m_value = rhs.m_value; return *this; }
+
+    allocator_type get_allocator() const { return m_alloc; }
+    pmr::memory_resource* resource() const { return m_alloc.resource(); }
+    int value() const { return m_value; }
+
+    static void resetCounts() { s_copies = s_moves = 0; }
+};
+
+int PmrType::s_copies = 0;
+int PmrType::s_moves = 0;
+
+bool operator==(const PmrType& a, const PmrType& b)
+{
+    return a.value() == b.value();
+}
+
+// Type whose move constructor may throw, so it is copied on relocation.
+struct CopyOnRelocate
+{
+    static int s_copies;
+    int m_value;
+
+    CopyOnRelocate(int v) : m_value(v) { }
+    CopyOnRelocate(const CopyOnRelocate& o) : m_value(o.m_value)
+        { ++s_copies; }
+    CopyOnRelocate(CopyOnRelocate&& o) : m_value(o.m_value) { }
+    CopyOnRelocate& operator=(const CopyOnRelocate&) = default;
+};
+
+int CopyOnRelocate::s_copies = 0;
+
+// Allocator-aware type whose move constructor may throw but whose
+// allocator-extended move constructor, which relocation uses, cannot.
+class MoveWithAlloc
+{
+    pmr::polymorphic_allocator<> m_alloc;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static int s_copies;
+    static int s_moves;
+
+    int m_value;
+
+    MoveWithAlloc(int v, const allocator_type& a) : m_alloc(a), m_value(v) { }
+    MoveWithAlloc(const MoveWithAlloc& o, const allocator_type& a)
+        : m_alloc(a), m_value(o.m_value) { ++s_copies; }
+    MoveWithAlloc(MoveWithAlloc&& o) : m_alloc(o.m_alloc), m_value(o.m_value)
+        { ++s_moves; }
+    MoveWithAlloc(MoveWithAlloc&& o, const allocator_type& a) noexcept
+        : m_alloc(a), m_value(o.m_value) { ++s_moves; }
+};
+
+int MoveWithAlloc::s_copies = 0;
+int MoveWithAlloc::s_moves = 0;
+
+// Allocator-aware type whose move constructor cannot throw but whose
+// allocator-extended move constructor may.
+class ThrowingMoveWithAlloc
+{
+    pmr::polymorphic_allocator<> m_alloc;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static int s_copies;
+
+    int m_value;
+
+    ThrowingMoveWithAlloc(int v, const allocator_type& a)
+        : m_alloc(a), m_value(v) { }
+    ThrowingMoveWithAlloc(const ThrowingMoveWithAlloc& o)
+        : m_alloc(o.m_alloc), m_value(o.m_value) { ++s_copies; }
+    ThrowingMoveWithAlloc(const ThrowingMoveWithAlloc& o,
+                          const allocator_type& a)
+        : m_alloc(a), m_value(o.m_value) { ++s_copies; }
+    ThrowingMoveWithAlloc(ThrowingMoveWithAlloc&& o) noexcept
+        : m_alloc(o.m_alloc), m_value(o.m_value) { }
+    ThrowingMoveWithAlloc(ThrowingMoveWithAlloc&& o, const allocator_type& a)
+        : m_alloc(a), m_value(o.m_value) { }
+};
+
+int ThrowingMoveWithAlloc::s_copies = 0;
+
+// Type that is not trivially copyable but is declared trivially
+// relocatable, so that relocation doesn't call its constructors.
+struct Relocatable
+{
+    static int s_constructions;
+    int m_value;
+
+    Relocatable(int v) : m_value(v) { ++s_constructions; }
+    Relocatable(const Relocatable& o) : m_value(o.m_value)
+        { ++s_constructions; }
+    Relocatable& operator=(const Relocatable&) = default;
+    ~Relocatable() { }
+};
+
+int Relocatable::s_constructions = 0;
+
+namespace std {
+inline namespace Cpp20 {
+template <> struct is_trivially_relocatable<Relocatable> : true_type { };
+}
+}
+
+// Type whose constructor throws after a set number of constructions.
+struct Throwing
+{
+    static int s_live;
+    static int s_constructionsBeforeThrow;
+    int m_value;
+
+    Throwing(int v) : m_value(v) { check(); }
+    Throwing(const Throwing& o) : m_value(o.m_value) { check(); }
+    Throwing& operator=(const Throwing&) = default;
+    ~Throwing() { --s_live; }
+
+    void check() {
+        if (0 == s_constructionsBeforeThrow--)
+            throw 1;
+        ++s_live;
+    }
+};
+
+int Throwing::s_live = 0;
+int Throwing::s_constructionsBeforeThrow = -1;
+
+int main()
+{
+    using exp::alloc_vector;
+
+    // Basic operations with the default allocator
+    {
+        alloc_vector<int> v;
+        TEST_ASSERT(v.empty());
+        TEST_ASSERT(0 == v.capacity());
+
+        for (int i = 0; i < 10; ++i)
+            v.push_back(i);
+        TEST_ASSERT(10 == v.size());
+        TEST_ASSERT(v.capacity() >= 10);
+        TEST_ASSERT(0 == v.front());
+        TEST_ASSERT(9 == v.back());
+        TEST_ASSERT(5 == v[5]);
+        TEST_ASSERT(5 == v.at(5));
+
+        bool caught = false;
+        try {
+            v.at(10);
+        }
+        catch (std::out_of_range&) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+
+        v.insert(v.begin() + 2, 100);
+        TEST_ASSERT(11 == v.size());
+        TEST_ASSERT(1 == v[1] && 100 == v[2] && 2 == v[3]);
+
+        v.insert(v.begin(), 3, -1);
+        TEST_ASSERT(14 == v.size());
+        TEST_ASSERT(-1 == v[0] && -1 == v[2] && 0 == v[3]);
+
+        v.erase(v.begin(), v.begin() + 3);
+        v.erase(v.begin() + 2);
+        TEST_ASSERT((alloc_vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 } == v));
+
+        int extra[] = { 10, 11 };
+        v.insert(v.end(), extra, extra + 2);
+        TEST_ASSERT(12 == v.size());
+        TEST_ASSERT(11 == v.back());
+
+        // Inserting a copy of an element of the vector itself
+        v.shrink_to_fit();
+        TEST_ASSERT(v.size() == v.capacity());
+        v.insert(v.begin(), v.back());
+        TEST_ASSERT(11 == v.front());
+        v.emplace(v.begin() + 1, v[0]);
+        TEST_ASSERT(11 == v[1]);
+        v.push_back(v[0]);
+        TEST_ASSERT(11 == v.back());
+
+        v.resize(3);
+        TEST_ASSERT((alloc_vector<int>{ 11, 11, 0 } == v));
+        v.resize(5);
+        TEST_ASSERT(0 == v[3] && 0 == v[4]);
+        v.resize(7, 4);
+        TEST_ASSERT(4 == v[5] && 4 == v[6]);
+
+        v.assign({ 1, 2 });
+        TEST_ASSERT((alloc_vector<int>{ 1, 2 } == v));
+        v.assign(4, 9);
+        TEST_ASSERT((alloc_vector<int>(4, 9) == v));
+        TEST_ASSERT((alloc_vector<int>{ 1, 2 } < v));
+
+        v.pop_back();
+        TEST_ASSERT(3 == v.size());
+        v.clear();
+        TEST_ASSERT(v.empty());
+        v.shrink_to_fit();
+        TEST_ASSERT(0 == v.capacity());
+    }
+
+    // The container's resource is passed to its elements
+    {
+        pmr::stats_resource sr;
+        pmr::polymorphic_allocator<PmrType> a(&sr);
+        pmr::alloc_vector<PmrType> v(a);
+
+        v.emplace_back(1);
+        v.push_back(PmrType(2));
+        v.insert(v.begin(), PmrType(0));
+        v.resize(5);
+        v.insert(v.begin() + 1, 2, PmrType(7));
+        TEST_ASSERT(7 == v.size());
+        for (const PmrType& e : v)
+            TEST_ASSERT(&sr == e.resource());
+        TEST_ASSERT(0 == v[0].value() && 7 == v[1].value());
+
+        // Elements keep the resource across growth
+        for (int i = 0; i < 100; ++i)
+            v.emplace_back(i);
+        for (const PmrType& e : v)
+            TEST_ASSERT(&sr == e.resource());
+
+        // Only the vector's own storage comes from the resource
+        TEST_ASSERT(v.capacity() * sizeof(PmrType) ==
+                    sr.snapshot().live_bytes);
+    }
+
+    // Nested pairs and tuples get the container's resource
+    {
+        pmr::stats_resource sr;
+        typedef std::pair<PmrType, std::pair<int, PmrType>> Pair;
+        typedef std::tuple<PmrType, int, PmrType>           Tuple;
+
+        pmr::alloc_vector<Pair> vp(&sr);
+        vp.emplace_back(1, std::make_pair(2, 3));
+        vp.emplace_back();
+        vp.emplace_back(std::piecewise_construct, std::make_tuple(4),
+                        std::make_tuple(5, 6));
+        for (const Pair& p : vp) {
+            TEST_ASSERT(&sr == p.first.resource());
+            TEST_ASSERT(&sr == p.second.second.resource());
+        }
+        TEST_ASSERT(4 == vp[2].first.value());
+        TEST_ASSERT(6 == vp[2].second.second.value());
+
+        pmr::alloc_vector<Tuple> vt(&sr);
+        vt.emplace_back(1, 2, 3);
+        vt.emplace_back();
+        vt.push_back(vt[0]);
+        for (const Tuple& t : vt) {
+            TEST_ASSERT(&sr == std::get<0>(t).resource());
+            TEST_ASSERT(&sr == std::get<2>(t).resource());
+        }
+        TEST_ASSERT(3 == std::get<2>(vt[2]).value());
+    }
+
+    // Relocation moves elements with noexcept moves...
+    {
+        pmr::alloc_vector<PmrType> v;
+        v.reserve(4);
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+        PmrType::resetCounts();
+        v.reserve(8);
+        TEST_ASSERT(0 == PmrType::s_copies);
+        TEST_ASSERT(4 == PmrType::s_moves);
+    }
+
+    // ...copies those whose moves may throw...
+    {
+        alloc_vector<CopyOnRelocate> v;
+        v.reserve(4);
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+        CopyOnRelocate::s_copies = 0;
+        v.reserve(8);
+        TEST_ASSERT(4 == CopyOnRelocate::s_copies);
+        TEST_ASSERT(3 == v[3].m_value);
+    }
+
+    // The allocator-extended move constructor, not the plain one, decides
+    // whether an element is moved...
+    {
+        pmr::alloc_vector<MoveWithAlloc> v;
+        v.reserve(4);
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+        MoveWithAlloc::s_copies = MoveWithAlloc::s_moves = 0;
+        v.reserve(8);
+        TEST_ASSERT(0 == MoveWithAlloc::s_copies);
+        TEST_ASSERT(4 == MoveWithAlloc::s_moves);
+        TEST_ASSERT(3 == v[3].m_value);
+    }
+
+    // ...or copied...
+    {
+        pmr::alloc_vector<ThrowingMoveWithAlloc> v;
+        v.reserve(4);
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+        ThrowingMoveWithAlloc::s_copies = 0;
+        v.reserve(8);
+        TEST_ASSERT(4 == ThrowingMoveWithAlloc::s_copies);
+        TEST_ASSERT(3 == v[3].m_value);
+    }
+
+    // ...and copies the bytes of trivially relocatable ones.
+    {
+        alloc_vector<Relocatable> v;
+        for (int i = 0; i < 100; ++i)
+            v.emplace_back(i);
+        TEST_ASSERT(100 == Relocatable::s_constructions);
+        for (int i = 0; i < 100; ++i)
+            TEST_ASSERT(i == v[i].m_value);
+        v.insert(v.begin() + 50, Relocatable(-1));
+        TEST_ASSERT(-1 == v[50].m_value);
+        TEST_ASSERT(50 == v[51].m_value);
+    }
+
+    // Exceptions during growth leave the vector unchanged
+    {
+        alloc_vector<Throwing> v;
+        v.reserve(4);
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back(i);
+        TEST_ASSERT(4 == Throwing::s_live);
+
+        // Throw while copying the existing elements into new storage
+        Throwing::s_constructionsBeforeThrow = 3;
+        bool caught = false;
+        try {
+            v.emplace_back(4);
+        }
+        catch (int) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(4 == v.size());
+        TEST_ASSERT(4 == v.capacity());
+        TEST_ASSERT(4 == Throwing::s_live);
+        TEST_ASSERT(3 == v[3].m_value);
+
+        // Throw while constructing the new element
+        Throwing::s_constructionsBeforeThrow = 1;
+        caught = false;
+        try {
+            v.insert(v.begin(), Throwing(9));
+        }
+        catch (int) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(4 == v.size());
+        TEST_ASSERT(4 == Throwing::s_live);
+
+        Throwing::s_constructionsBeforeThrow = -1;
+        v.emplace_back(4);
+        TEST_ASSERT(5 == v.size());
+        TEST_ASSERT(5 == Throwing::s_live);
+    }
+    TEST_ASSERT(0 == Throwing::s_live);
+
+    // Copy, move, and assignment with polymorphic allocators
+    {
+        pmr::stats_resource r1, r2;
+        pmr::alloc_vector<PmrType> v1({ PmrType(1), PmrType(2) }, &r1);
+        TEST_ASSERT(&r1 == v1[0].resource());
+
+        // Copy construction does not propagate the resource
+        pmr::alloc_vector<PmrType> c(v1);
+        TEST_ASSERT(pmr::new_delete_resource() ==
+                    c.get_allocator().resource());
+        TEST_ASSERT(pmr::new_delete_resource() == c[1].resource());
+        TEST_ASSERT(c == v1);
+
+        pmr::alloc_vector<PmrType> c2(v1, &r2);
+        TEST_ASSERT(&r2 == c2[0].resource());
+
+        // Moving steals the storage...
+        const PmrType* data = c2.data();
+        pmr::alloc_vector<PmrType> m(std::move(c2));
+        TEST_ASSERT(data == m.data());
+        TEST_ASSERT(c2.empty());
+
+        // ...unless a different resource is requested
+        pmr::alloc_vector<PmrType> m2(std::move(m), &r1);
+        TEST_ASSERT(data != m2.data());
+        TEST_ASSERT(&r1 == m2[0].resource());
+        TEST_ASSERT(2 == m2[1].value());
+
+        // Assignment keeps the target's resource
+        pmr::alloc_vector<PmrType> t(&r2);
+        t = v1;
+        TEST_ASSERT(&r2 == t.get_allocator().resource());
+        TEST_ASSERT(&r2 == t[0].resource());
+        TEST_ASSERT(t == v1);
+
+        pmr::alloc_vector<PmrType> t2(&r2);
+        t2.emplace_back(5);
+        t2 = std::move(t);
+        TEST_ASSERT(&r2 == t2[0].resource());
+        TEST_ASSERT(t2 == v1);
+
+        t2 = std::move(m2);  // Different resource: element-wise move
+        TEST_ASSERT(&r2 == t2[0].resource());
+        TEST_ASSERT(t2 == v1);
+
+        pmr::alloc_vector<PmrType> s(&r1);
+        s.swap(v1);
+        TEST_ASSERT(2 == s.size());
+        TEST_ASSERT(v1.empty());
+    }
+
+    // Non-allocator-aware elements ignore the allocator
+    {
+        pmr::stats_resource sr;
+        pmr::alloc_vector<std::string> v(&sr);
+        v.emplace_back("hello");
+        v.emplace_back(3, 'x');
+        TEST_ASSERT("hello" == v[0]);
+        TEST_ASSERT("xxx" == v[1]);
+    }
+
+    return errorCount();
+}
@@ -0,0 +1,206 @@
+/* bench.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016  Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Utilities used by the micro-benchmark drivers (`*.bench.cpp`).
+ *
+ * Each benchmark reports one line of comma-separated values on `stdout`:
+ *
+ *     suite,name,ns_per_op,copies_per_op,moves_per_op
+ *
+ * preceded by a single header line, so that results can be compared between
+ * releases with ordinary text tools.
+ */
+
+#ifndef INCLUDED_BENCH_DOT_H
+#define INCLUDED_BENCH_DOT_H
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+namespace bench {
+
+// Prevent the optimizer from discarding the computation of `value`.
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Prevent the optimizer from assuming anything about the contents of memory.
+inline void clobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+// Counters for copy and move operations performed by instrumented types.
+class OpCounts
+{
+    static long& copiesRef() {
+        // Header-only static variable
+        static long copies = 0;
+        return copies;
+    }
+
+    static long& movesRef() {
+        // Header-only static variable
+        static long moves = 0;
+        return moves;
+    }
+
+public:
+    static long copies() { return copiesRef(); }
+    static long moves()  { return movesRef(); }
+
+    static void countCopy() { ++copiesRef(); }
+    static void countMove() { ++movesRef(); }
+
+    static void reset() { copiesRef() = movesRef() = 0; }
+};
+
+// Number of iterations in each timed run.  Can be overridden by the first
+// command-line argument of a benchmark driver.
+inline long& iterations()
+{
+    // Header-only static
+    static long iterations = 2000000;
+    return iterations;
+}
+
+inline void parseArgs(int argc, char *argv[])
+{
+    if (argc > 1)
+        iterations() = std::atol(argv[1]);
+}
+
+inline void printHeader()
+{
+    std::cout << "suite,name,ns_per_op,copies_per_op,moves_per_op"
+              << std::endl;
+}
+
+// Return the best time in nanoseconds per call of `f(i)` over several runs
+// of `iterations()` calls each.
+template <class F>
+double nsPerOp(F&& f, int repetitions = 5)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const long n = iterations();
+    double best = 0.0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        Clock::time_point start = Clock::now();
+        for (long i = 0; i < n; ++i) {
+            f(i);
+            clobberMemory();
+        }
+        Clock::time_point end = Clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start)
+                    .count() / (n ? n : 1);
+        if (0 == rep || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+// Time `f` and count the copies and moves performed by a single call, then
+// print the result as one CSV line.
+template <class F>
+void run(const char* suite, const char* name, F&& f)
+{
+    OpCounts::reset();
+    f(0L);
+    long copies = OpCounts::copies();
+    long moves  = OpCounts::moves();
+
+    double ns = nsPerOp(f);
+
+    std::cout << suite << ',' << name << ',' << ns << ','
+              << copies << ',' << moves << std::endl;
+}
+
+// Run `f(thread, i)` for `iterations()` values of `i` on each of
+// `numThreads` threads concurrently, and return the best wall-clock time in
+// nanoseconds divided by the total number of calls over all threads.
+// Perfect scaling leaves the result inversely proportional to `numThreads`.
+template <class F>
+double nsPerOpThreads(int numThreads, F&& f, int repetitions = 3)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const long n = iterations();
+    const long calls = n * numThreads;
+    double best = 0.0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        std::vector<std::thread> threads;
+        Clock::time_point start = Clock::now();
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&f, t, n]() {
+                for (long i = 0; i < n; ++i) {
+                    f(t, i);
+                    clobberMemory();
+                }
+            });
+        }
+        for (std::thread& th : threads)
+            th.join();
+        Clock::time_point end = Clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start)
+                    .count() / (calls > 0 ? calls : 1);
+        if (0 == rep || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+// Time `f` on `numThreads` threads and print the result as one CSV line.
+// Copies and moves are not counted (reported as 0).
+template <class F>
+void runThreads(const char* suite, const char* name, int numThreads, F&& f)
+{
+    double ns = nsPerOpThreads(numThreads, f);
+    std::cout << suite << ',' << name << ',' << ns << ",0,0" << std::endl;
+}
+
+// Return the best time in nanoseconds per element of `f()`, which processes
+// `batchSize` elements, over several calls.  `reset()` is called, untimed,
+// after each call of `f()`.
+template <class F, class R>
+double nsPerBatchElement(long batchSize, F&& f, R&& reset,
+                         int repetitions = 3)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double best = 0.0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        Clock::time_point start = Clock::now();
+        f();
+        clobberMemory();
+        Clock::time_point end = Clock::now();
+        reset();
+        double ns = std::chrono::duration<double, std::nano>(end - start)
+                    .count() / (batchSize ? batchSize : 1);
+        if (0 == rep || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+// Time `f`, which processes `batchSize` elements, and print the time per
+// element as one CSV line.  Copies and moves are not counted (reported as
+// 0).
+template <class F, class R>
+void runBatch(const char* suite, const char* name, long batchSize, F&& f,
+              R&& reset)
+{
+    double ns = nsPerBatchElement(batchSize, f, reset);
+    std::cout << suite << ',' << name << ',' << ns << ",0,0" << std::endl;
+}
+
+} // close namespace bench
+
+#endif // ! defined(INCLUDED_BENCH_DOT_H)
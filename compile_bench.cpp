@@ -0,0 +1,295 @@
+/* compile_bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Compile-time benchmark for `uses_allocator.h` and
+ * `copy_swap_transaction.h`.
+ *
+ * For each configuration, a translation unit is generated that
+ *   - constructs `N` distinct allocator-aware types (cycling through the
+ *     no-allocator, prefix, and suffix protocols) with
+ *     `make_obj_using_allocator` and
+ *     `uninitialized_construct_using_allocator`,
+ *   - constructs `std::pair`s nested to depth `D`, and
+ *   - runs a `copy_swap_transaction` over `K` objects.
+ * The translation unit is compiled with the compiler command given on the
+ * command line and one CSV line is written to `stdout`:
+ *
+ *     N,D,K,wall_ms,max_rss_kb,instantiations,object_bytes,debug_info_bytes
+ *
+ * `instantiations` is the number of functions emitted into the object file.
+ * Compile with `-O0 -fno-inline` (as `make compile-bench` does) so that
+ * every instantiated function template is emitted; the generated code
+ * contains only one non-template function.  `debug_info_bytes` is the size
+ * of the `.debug_info` section, which is 0 unless `-g` is given.
+ *
+ * Usage:
+ *     compile_bench [N D K] -- <compiler> <flags>...
+ * If `N D K` are omitted, a default sweep over each parameter is run.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+const char *const k_SOURCE = "compile_bench_gen.cpp";
+const char *const k_OBJECT = "compile_bench_gen.o";
+
+struct Config {
+    int d_numTypes;     // N
+    int d_pairDepth;    // D
+    int d_txnObjects;   // K
+};
+
+// Write the translation unit for `cfg` to `path`.
+void generate(const Config& cfg, const char *path)
+{
+    std::ofstream out(path);
+
+    out << "#include <uses_allocator.h>\n"
+           "#include <copy_swap_transaction.h>\n\n"
+           "template <class T> struct Alloc {\n"
+           "    typedef T value_type;\n"
+           "    Alloc() { }\n"
+           "    template <class U> Alloc(const Alloc<U>&) { }\n"
+           "    T* allocate(std::size_t) { return nullptr; }\n"
+           "    void deallocate(T*, std::size_t) { }\n"
+           "};\n"
+           "template <class T, class U>\n"
+           "bool operator==(const Alloc<T>&, const Alloc<U>&) "
+           "{ return true; }\n\n";
+
+    // N distinct types, cycling through the three protocols.
+    const int n = cfg.d_numTypes > 0 ? cfg.d_numTypes : 1;
+    for (int i = 0; i < n; ++i) {
+        out << "struct T" << i << " {\n"
+               "    int v;\n";
+        switch (i % 3) {
+          case 0:  // No allocator
+            out << "    T" << i << "(int x = 0) : v(x) { }\n";
+            break;
+          case 1:  // Prefix allocator
+            out << "    typedef Alloc<int> allocator_type;\n"
+                   "    T" << i << "(int x = 0) : v(x) { }\n"
+                   "    T" << i << "(std::allocator_arg_t, "
+                   "const allocator_type&, int x = 0) : v(x) { }\n"
+                   "    T" << i << "(std::allocator_arg_t, "
+                   "const allocator_type&, const T" << i << "& o)"
+                   " : v(o.v) { }\n"
+                   "    allocator_type get_allocator() const "
+                   "{ return {}; }\n";
+            break;
+          case 2:  // Suffix allocator
+            out << "    typedef Alloc<int> allocator_type;\n"
+                   "    T" << i << "(int x = 0) : v(x) { }\n"
+                   "    T" << i << "(const allocator_type&) : v(0) { }\n"
+                   "    T" << i << "(int x, const allocator_type&)"
+                   " : v(x) { }\n"
+                   "    T" << i << "(const T" << i << "& o, "
+                   "const allocator_type&) : v(o.v) { }\n"
+                   "    allocator_type get_allocator() const "
+                   "{ return {}; }\n";
+            break;
+        }
+        out << "    T" << i << "(const T" << i << "&) = default;\n"
+               "};\n"
+               "void swap(T" << i << "& a, T" << i << "& b) "
+               "{ std::swap(a.v, b.v); }\n\n";
+    }
+
+    // Pairs nested to depth D: P0 = T0, Pd = pair<P(d-1), T(d % N)>
+    out << "typedef T0 P0;\n";
+    for (int d = 1; d <= cfg.d_pairDepth; ++d)
+        out << "typedef std::pair<P" << d - 1 << ", T" << d % n
+            << "> P" << d << ";\n";
+    out << "\n";
+
+    out << "void run(const Alloc<int>& a, void *buf)\n{\n";
+    for (int i = 0; i < n; ++i) {
+        out << "    { T" << i << " x = std::make_obj_using_allocator<T" << i
+            << ">(a, " << i << "); (void) x;\n"
+               "      std::uninitialized_construct_using_allocator("
+               "static_cast<T" << i << "*>(buf), a, " << i << "); }\n";
+    }
+    out << "    { P" << cfg.d_pairDepth
+        << " p = std::make_obj_using_allocator<P" << cfg.d_pairDepth
+        << ">(a); (void) p;\n"
+           "      std::uninitialized_construct_using_allocator("
+           "static_cast<P" << cfg.d_pairDepth << "*>(buf), a); }\n";
+
+    if (cfg.d_txnObjects > 0) {
+        out << "    {\n";
+        for (int k = 0; k < cfg.d_txnObjects; ++k)
+            out << "        T" << k % n << " x" << k << "(" << k << ");\n";
+        out << "        std::experimental::copy_swap_transaction(";
+        for (int k = 0; k < cfg.d_txnObjects; ++k)
+            out << "x" << k << ", ";
+        out << "[](auto&...) { });\n"
+               "    }\n";
+    }
+    out << "}\n";
+}
+
+// Run `argv` as a child process.  Set `wallMs` and `maxRssKb` to the wall
+// time and peak memory of the child.  Return the child's exit status.
+int runProcess(const std::vector<std::string>& args,
+               double *wallMs, long *maxRssKb)
+{
+    std::vector<char*> argv;
+    for (const std::string& a : args)
+        argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0)
+        return -1;
+    if (0 == pid) {
+        execvp(argv[0], argv.data());
+        std::perror(argv[0]);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    wait4(pid, &status, 0, &usage);
+    auto end = std::chrono::steady_clock::now();
+
+    *wallMs = std::chrono::duration<double, std::milli>(end - start).count();
+    *maxRssKb = usage.ru_maxrss;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Return the number of functions defined in the object file `path`, or -1 if
+// `nm` cannot be run.
+long countInstantiations(const char *path)
+{
+    std::string cmd = std::string("nm ") + path;
+    FILE *nm = popen(cmd.c_str(), "r");
+    if (! nm)
+        return -1;
+
+    long count = 0;
+    char line[4096];
+    while (std::fgets(line, sizeof(line), nm)) {
+        // Format: "<address> <type> <name>"
+        const char *type = std::strchr(line, ' ');
+        if (type && type[1] && std::strchr("TtWw", type[1]))
+            ++count;
+    }
+    return 0 == pclose(nm) ? count : -1;
+}
+
+// Return the size of the section named `section` in the object file `path`,
+// 0 if there is no such section, or -1 if `size` cannot be run.
+long sectionSize(const char *path, const char *section)
+{
+    std::string cmd = std::string("size -A ") + path;
+    FILE *size = popen(cmd.c_str(), "r");
+    if (! size)
+        return -1;
+
+    long ret = 0;
+    char line[4096];
+    while (std::fgets(line, sizeof(line), size)) {
+        // Format: "<section> <size> <address>"
+        char name[4096];
+        long bytes = 0;
+        if (2 == std::sscanf(line, "%4095s %ld", name, &bytes) &&
+            0 == std::strcmp(name, section))
+            ret = bytes;
+    }
+    return 0 == pclose(size) ? ret : -1;
+}
+
+long fileSize(const char *path)
+{
+    struct stat st;
+    return 0 == stat(path, &st) ? long(st.st_size) : -1L;
+}
+
+// Generate, compile, and measure one configuration.  Return false if
+// compilation failed.
+bool runConfig(const Config& cfg, const std::vector<std::string>& compiler)
+{
+    generate(cfg, k_SOURCE);
+
+    std::vector<std::string> cmd(compiler);
+    cmd.push_back("-c");
+    cmd.push_back(k_SOURCE);
+    cmd.push_back("-o");
+    cmd.push_back(k_OBJECT);
+
+    double wallMs = 0;
+    long maxRssKb = 0;
+    if (0 != runProcess(cmd, &wallMs, &maxRssKb)) {
+        std::cerr << "compile_bench: compilation failed for N="
+                  << cfg.d_numTypes << " D=" << cfg.d_pairDepth
+                  << " K=" << cfg.d_txnObjects << std::endl;
+        return false;
+    }
+
+    std::cout << cfg.d_numTypes << ',' << cfg.d_pairDepth << ','
+              << cfg.d_txnObjects << ',' << wallMs << ',' << maxRssKb << ','
+              << countInstantiations(k_OBJECT) << ','
+              << fileSize(k_OBJECT) << ','
+              << sectionSize(k_OBJECT, ".debug_info") << std::endl;
+    return true;
+}
+
+} // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<Config> configs;
+    std::vector<std::string> compiler;
+
+    int i = 1;
+    if (i + 2 < argc && 0 != std::strcmp(argv[i], "--")) {
+        configs.push_back(Config{ std::atoi(argv[i]), std::atoi(argv[i + 1]),
+                                  std::atoi(argv[i + 2]) });
+        i += 3;
+    }
+    if (i >= argc || 0 != std::strcmp(argv[i], "--") || i + 1 >= argc) {
+        std::cerr << "usage: " << argv[0]
+                  << " [N D K] -- <compiler> <flags>..." << std::endl;
+        return 2;
+    }
+    for (++i; i < argc; ++i)
+        compiler.push_back(argv[i]);
+
+    if (configs.empty()) {
+        // Vary each parameter in turn, holding the others small.
+        for (int n : { 1, 10, 50, 100 })
+            configs.push_back(Config{ n, 1, 1 });
+        for (int d : { 2, 4, 8, 16 })
+            configs.push_back(Config{ 3, d, 1 });
+        for (int k : { 2, 4, 8, 16 })
+            configs.push_back(Config{ 3, 1, k });
+    }
+
+    std::cout << "N,D,K,wall_ms,max_rss_kb,instantiations,object_bytes,"
+                 "debug_info_bytes" << std::endl;
+
+    bool ok = true;
+    for (const Config& cfg : configs)
+        ok = runConfig(cfg, compiler) && ok;
+
+    std::remove(k_SOURCE);
+    std::remove(k_OBJECT);
+    return ok ? 0 : 1;
+}
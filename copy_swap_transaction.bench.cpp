@@ -0,0 +1,110 @@
+/* copy_swap_transaction.bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Micro-benchmarks of `swap_assign` from an rvalue.  The `deep_copy` rows
+ * reproduce the behavior of `swap_assign` before it checked allocator
+ * equality (always construct with the target's allocator, then swap) and
+ * serve as the baseline.  Every copy counted in the `copies_per_op` column
+ * is a deep copy that allocates one buffer; constructing the source object
+ * allocates one more buffer per operation in every row.
+ */
+
+#include <copy_swap_transaction.h>
+
+#include <bench.h>
+#include <pool_resource.h>
+#include <algorithm>
+#include <utility>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware type owning a buffer of `k_SIZE` ints, like a small
+// container.  Allocator-extended construction is a deep copy; moves steal
+// the buffer.
+class Buffer
+{
+    pmr::polymorphic_allocator<int> m_alloc;
+    int*                            m_data;
+
+    static constexpr std::size_t k_SIZE = 64;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    Buffer(int v, const allocator_type& a)
+        : m_alloc(a), m_data(m_alloc.allocate(k_SIZE)) {
+        std::fill(m_data, m_data + k_SIZE, v);
+    }
+
+    Buffer(Buffer&& other)
+        : m_alloc(other.m_alloc), m_data(other.m_data) {
+        other.m_data = nullptr;
+        bench::OpCounts::countMove();
+    }
+
+    // Allocator-extended copy.  There is no allocator-extended move, so
+    // uses-allocator construction from an rvalue also comes here.
+    Buffer(const Buffer& other, const allocator_type& a)
+        : m_alloc(a), m_data(m_alloc.allocate(k_SIZE)) {
+        std::copy(other.m_data, other.m_data + k_SIZE, m_data);
+        bench::OpCounts::countCopy();
+    }
+
+    ~Buffer() {
+        if (m_data)
+            m_alloc.deallocate(m_data, k_SIZE);
+    }
+
+    friend void swap(Buffer& a, Buffer& b) noexcept {
+        // Allocators are not propagated on swap.
+        std::swap(a.m_data, b.m_data);
+    }
+
+    allocator_type get_allocator() const { return m_alloc; }
+    int value() const { return m_data[0]; }
+};
+
+// The unconditional allocator-extended construction `swap_assign` used to
+// perform, whether or not the allocators compare equal.
+void deepCopyAssign(Buffer& lhs, Buffer&& rhs)
+{
+    Buffer tmp(exp::make_obj_using_allocator<Buffer>(lhs.get_allocator(),
+                                                     std::move(rhs)));
+    swap(lhs, tmp);
+}
+
+// Run the benchmarks assigning to an object allocated from `target` from
+// temporaries allocated from `source`.
+void runSuite(const char* suite, pmr::memory_resource* target,
+              pmr::memory_resource* source)
+{
+    using std::experimental::swap_assign;
+
+    Buffer lhs(0, target);
+
+    bench::run(suite, "deep_copy", [&](long i) {
+            deepCopyAssign(lhs, Buffer(int(i), source));
+            bench::doNotOptimize(lhs.value());
+        });
+
+    bench::run(suite, "swap_assign", [&](long i) {
+            swap_assign(lhs, Buffer(int(i), source));
+            bench::doNotOptimize(lhs.value());
+        });
+}
+
+int main(int argc, char *argv[])
+{
+    bench::parseArgs(argc, argv);
+    bench::printHeader();
+
+    pmr::unsynchronized_pool_resource r1, r2;
+
+    runSuite("swap_assign_equal_alloc", &r1, &r1);
+    runSuite("swap_assign_unequal_alloc", &r1, &r2);
+
+    return 0;
+}
@@ -19,13 +19,6 @@
 
 namespace std {
 
-inline namespace Cpp17 {
-
-enum class byte : unsigned char { };
-
-} // close namespace Cpp17
-
-
 namespace experimental {
 inline namespace fundamentals_v3 {
 
@@ -71,19 +64,47 @@ inline
 remove_reference_t<T> copy_swap_helper(T&& other)
 {
     using TT = remove_reference_t<T>;
-    return make_using_allocator<TT>(get_allocator(other), other);
+    return Cpp20::make_obj_using_allocator<TT>(get_allocator(other), other);
 }
 #endif
 
+namespace internal {
+
+// Return a copy of `rhs` suitable for swapping with `lhs`, moved from `rhs`
+// without regard to allocators.  Used when the allocator propagates on move
+// assignment or when all allocators of the type compare equal.
+template <class T>
+inline
+T swap_assign_source(true_type, T&, T&& rhs)
+{
+    return T(std::move(rhs));
+}
+
+// Return a copy of `rhs` suitable for swapping with `lhs`, using `lhs`s
+// allocator.  If the allocators of `lhs` and `rhs` compare equal, `rhs` is
+// simply moved; otherwise, the result is constructed using `lhs`s
+// allocator, which typically copies the contents of `rhs`.
+template <class T>
+inline
+T swap_assign_source(false_type, T& lhs, T&& rhs)
+{
+    if (get_allocator(lhs) == get_allocator(rhs))
+        return T(std::move(rhs));
+    return Cpp20::make_obj_using_allocator<T>(get_allocator(lhs),
+                                              std::move(rhs));
+}
+
+} // close namespace internal
+
 template <class T>
 inline
 T& swap_assign(T& lhs, decay_t<T>&& rhs)
 {
     using Alloc = decltype(get_allocator(lhs));
-    constexpr bool pocma =
-        allocator_traits<Alloc>::propagate_on_container_move_assignment::value;
-    T R = (pocma ? T(std::move(rhs)) :
-           make_using_allocator<T>(get_allocator(lhs), std::move(rhs)));
+    using AT = allocator_traits<Alloc>;
+    constexpr bool pocma = AT::propagate_on_container_move_assignment::value;
+    integral_constant<bool, pocma || AT::is_always_equal::value> move_ok;
+    T R = internal::swap_assign_source(move_ok, lhs, std::move(rhs));
     using std::swap;
     // If pocma, assume pocs (propagate_on_container_swap)
     swap(lhs, R);
@@ -97,7 +118,8 @@ T& swap_assign(T& lhs, decay_t<T> const& rhs)
     using Alloc = decltype(get_allocator(lhs));
     constexpr bool pocca =
         allocator_traits<Alloc>::propagate_on_container_copy_assignment::value;
-    T R = make_using_allocator<T>(get_allocator(pocca ? rhs : lhs), rhs);
+    T R = Cpp20::make_obj_using_allocator<T>(
+        get_allocator(pocca ? rhs : lhs), rhs);
     using std::swap;
     // If pocca, assume pocs (propagate_on_container_swap)
     swap(lhs, R);
@@ -129,7 +151,7 @@ copy_swap_transaction_imp(integral_constant<size_t, N>, T& t, Rest&&... rest)
     // Make a copy of `t` using `t`s allocator, even if `T` doesn't usually
     // propagate it's allocator on copy construction. If `T` doesn't use an
     // allocator, then `copy_swap_helper(t)` simply returns `t`.
-    T tprime(make_using_allocator<T>(get_allocator(t), t));
+    T tprime(Cpp20::make_obj_using_allocator<T>(get_allocator(t), t));
 
     // Remove `t` from front of argument list and add rotate left by adding
     // `tprime` to the end of the list, then recurse.
@@ -241,6 +241,79 @@ void swap(TestType<Alloc, Prefix>& a, TestType<Alloc, Prefix>& b) noexcept
     a.swap(b);
 }
 
+// STL-style stateless test allocator whose instances always compare equal,
+// but which does not propagate on move assignment.
+template <class T>
+class MyStatelessAlloc
+{
+public:
+    typedef T value_type;
+    typedef std::true_type is_always_equal;
+
+    MyStatelessAlloc() { }
+    template <class U> MyStatelessAlloc(const MyStatelessAlloc<U>&) { }
+
+    T* allocate(std::size_t) { throw std::bad_alloc(); }
+    void deallocate(T*, std::size_t) { }
+};
+
+template <class T>
+inline bool operator==(const MyStatelessAlloc<T>&, const MyStatelessAlloc<T>&)
+{
+    return true;
+}
+
+template <class T>
+inline bool operator!=(const MyStatelessAlloc<T>&, const MyStatelessAlloc<T>&)
+{
+    return false;
+}
+
+// Allocator-aware test type that counts plain and allocator-extended move
+// constructions.  An allocator-extended move stands in for the deep copy
+// that a container would perform when the allocators differ.
+template <typename Alloc>
+class MoveCountingType
+{
+    Alloc m_alloc;
+    int   m_value;
+
+public:
+    static int s_moves;
+    static int s_extendedMoves;
+
+    typedef Alloc allocator_type;
+
+    explicit MoveCountingType(int v, const Alloc& a = Alloc())
+        : m_alloc(a), m_value(v) { }
+    MoveCountingType(MoveCountingType&& other)
+        : m_alloc(other.m_alloc), m_value(other.m_value) { ++s_moves; }
+    MoveCountingType(MoveCountingType&& other, const Alloc& a)
+        : m_alloc(a), m_value(other.m_value) { ++s_extendedMoves; }
+
+    void swap(MoveCountingType& other) noexcept {
+        assert(m_alloc == other.m_alloc);
+        std::swap(m_value, other.m_value);
+    }
+
+    Alloc get_allocator() const { return m_alloc; }
+    int value() const { return m_value; }
+
+    static void resetCounts() { s_moves = s_extendedMoves = 0; }
+};
+
+template <typename Alloc>
+int MoveCountingType<Alloc>::s_moves = 0;
+
+template <typename Alloc>
+int MoveCountingType<Alloc>::s_extendedMoves = 0;
+
+template <typename Alloc>
+void swap(MoveCountingType<Alloc>& a, MoveCountingType<Alloc>& b) noexcept
+{
+    a.swap(b);
+}
+
 namespace internal = std::experimental::fundamentals_v3::internal;
 
 int main()
@@ -249,7 +322,7 @@ int main()
     // using std::experimental::copy_swap_helper;
     using std::experimental::swap_assign;
     using std::experimental::get_allocator;
-    using std::Cpp20::make_using_allocator;
+    using std::Cpp20::make_obj_using_allocator;
 
     typedef MySTLAlloc<int> IntAlloc;
     IntAlloc A0; // Default
@@ -303,7 +376,7 @@ int main()
             TEST_ASSERT(6 == cc.value());
         }
 
-        Obj z(make_using_allocator<Obj>(get_allocator(cc), x));
+        Obj z(std::Cpp20::make_obj_using_allocator<Obj>(get_allocator(cc), x));
         TEST_ASSERT(z == x);
         TEST_ASSERT(std::allocator<std::byte>{} == get_allocator(z));
         const Obj q(9);
@@ -361,7 +434,7 @@ int main()
         }
 
         const Obj q(9, A2);
-        Obj z(make_using_allocator<Obj>(get_allocator(q), x));
+        Obj z(std::Cpp20::make_obj_using_allocator<Obj>(get_allocator(q), x));
         TEST_ASSERT(z == x);
         TEST_ASSERT(A2 == z.get_allocator());
 
@@ -422,7 +495,7 @@ int main()
         }
 
         const Obj q(std::allocator_arg, A2, 9);
-        Obj z(make_using_allocator<Obj>(get_allocator(q), x));
+        Obj z(std::Cpp20::make_obj_using_allocator<Obj>(get_allocator(q), x));
         TEST_ASSERT(z == x);
         TEST_ASSERT(A2 == z.get_allocator());
 
@@ -543,5 +616,36 @@ int main()
         TEST_ASSERT(PA1 == y.get_allocator());
     }
 
+    // swap_assign from an rvalue moves when the allocators compare equal
+    {
+        typedef MoveCountingType<IntAlloc> Obj;
+
+        Obj x(3, A1);
+        Obj::resetCounts();
+        swap_assign(x, Obj(8, A1));
+        TEST_ASSERT(8 == x.value());
+        TEST_ASSERT(A1 == x.get_allocator());
+        TEST_ASSERT(0 == Obj::s_extendedMoves);
+        TEST_ASSERT(1 == Obj::s_moves);
+
+        Obj::resetCounts();
+        swap_assign(x, Obj(9, A2));
+        TEST_ASSERT(9 == x.value());
+        TEST_ASSERT(A1 == x.get_allocator());
+        TEST_ASSERT(1 == Obj::s_extendedMoves);
+    }
+
+    // swap_assign from an rvalue moves when allocators are always equal
+    {
+        typedef MoveCountingType<MyStatelessAlloc<int>> Obj;
+
+        Obj x(3);
+        Obj::resetCounts();
+        swap_assign(x, Obj(8));
+        TEST_ASSERT(8 == x.value());
+        TEST_ASSERT(0 == Obj::s_extendedMoves);
+        TEST_ASSERT(1 == Obj::s_moves);
+    }
+
     return errorCount();
 }
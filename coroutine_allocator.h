@@ -0,0 +1,176 @@
+/* coroutine_allocator.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `coroutine_allocator_mixin`, a base class for C++20 coroutine promise
+ * types that allocates each coroutine frame from the allocator passed after
+ * `allocator_arg` in the coroutine's parameter list (extension).  Requires
+ * C++20.
+ */
+
+#ifndef INCLUDED_COROUTINE_ALLOCATOR_DOT_H
+#define INCLUDED_COROUTINE_ALLOCATOR_DOT_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if __cplusplus <= 201703L
+#error "coroutine_allocator.h requires C++20"
+#endif
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// Unit of allocation for coroutine frames, so that every frame has the
+// alignment guaranteed by `operator new`.
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) coroutine_frame_block {
+    unsigned char m_bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+};
+
+// Function that frees the coroutine frame at `frame`, of `size` bytes.
+typedef void coroutine_frame_deallocator(void* frame, size_t size) noexcept;
+
+// Return `n` rounded up to a multiple of `align`, a power of two.
+constexpr size_t coroutine_frame_round_up(size_t n, size_t align) noexcept
+{
+    return (n + align - 1) & ~(align - 1);
+}
+
+// Offset from the start of a frame of `size` bytes of the pointer to the
+// function that frees it.
+constexpr size_t coroutine_frame_deallocator_offset(size_t size) noexcept
+{
+    return coroutine_frame_round_up(size,
+                                    alignof(coroutine_frame_deallocator*));
+}
+
+// Return the location of the pointer to the function that frees the frame
+// at `frame`, of `size` bytes.
+inline coroutine_frame_deallocator**
+coroutine_frame_deallocator_slot(void* frame, size_t size) noexcept
+{
+    return reinterpret_cast<coroutine_frame_deallocator**>(
+        static_cast<char*>(frame) + coroutine_frame_deallocator_offset(size));
+}
+
+// The layout of a coroutine frame of `size` bytes allocated with `Alloc`:
+// the frame, then a pointer to the function that frees it, then a copy of
+// the allocator (rebound to `coroutine_frame_block`), all in one block of
+// `blocks(size)` units.
+template <class Alloc>
+struct coroutine_frame_layout
+{
+    typedef typename allocator_traits<Alloc>::template
+        rebind_alloc<coroutine_frame_block>              block_alloc;
+    typedef allocator_traits<block_alloc>                block_traits;
+
+    static_assert(alignof(block_alloc) <= alignof(coroutine_frame_block),
+                  "Allocator is too strictly aligned");
+    static_assert(is_same<typename block_traits::pointer,
+                          coroutine_frame_block*>::value,
+                  "Allocators with fancy pointers are not supported");
+
+    static constexpr size_t alloc_offset(size_t size) noexcept {
+        return coroutine_frame_round_up(
+                   coroutine_frame_deallocator_offset(size) +
+                   sizeof(coroutine_frame_deallocator*),
+                   alignof(block_alloc));
+    }
+
+    static constexpr size_t blocks(size_t size) noexcept {
+        return (alloc_offset(size) + sizeof(block_alloc) +
+                sizeof(coroutine_frame_block) - 1) /
+               sizeof(coroutine_frame_block);
+    }
+
+    static block_alloc* stored_alloc(void* frame, size_t size) noexcept {
+        return reinterpret_cast<block_alloc*>(
+                               static_cast<char*>(frame) + alloc_offset(size));
+    }
+
+    static void deallocate(void* frame, size_t size) noexcept {
+        block_alloc* stored = stored_alloc(frame, size);
+        block_alloc a(std::move(*stored));
+        stored->~block_alloc();
+        block_traits::deallocate(
+            a, static_cast<coroutine_frame_block*>(frame), blocks(size));
+    }
+
+    static void* allocate(size_t size, const Alloc& alloc) {
+        block_alloc a(alloc);
+        void* frame = block_traits::allocate(a, blocks(size));
+        ::new(static_cast<void*>(stored_alloc(frame, size)))
+            block_alloc(std::move(a));
+        ::new(static_cast<void*>(coroutine_frame_deallocator_slot(frame,
+                                                                  size)))
+            coroutine_frame_deallocator*(&deallocate);
+        return frame;
+    }
+};
+
+// Frees a coroutine frame obtained from global `operator new`.
+inline void coroutine_frame_delete(void* frame, size_t size) noexcept
+{
+    ::operator delete(frame, coroutine_frame_deallocator_offset(size) +
+                             sizeof(coroutine_frame_deallocator*));
+}
+
+} // close namespace internal
+
+// Base class for a coroutine promise type whose coroutine frames are
+// allocated using the allocator that follows `allocator_arg` at the start
+// of the coroutine's parameter list (after the implicit object parameter
+// for a member function), the same leading-allocator convention as
+// uses-allocator construction.  The allocator (rebound) and a pointer to
+// the function that frees the frame are stored after the frame, so the
+// allocator type need not be part of the coroutine's type.  A
+// `polymorphic_allocator` allocates the frame from its memory resource.
+// Coroutines without an allocator argument use global `operator new`.
+// Allocators with fancy pointers, or more strictly aligned than `operator
+// new` guarantees, are not supported.  GCC's `-Wmismatched-new-delete`
+// warns, wrongly, where a coroutine taking an allocator frees its frame;
+// users must suppress it (see the README).
+class coroutine_allocator_mixin
+{
+public:
+    static void* operator new(size_t size) {
+        void* frame = ::operator new(
+            internal::coroutine_frame_deallocator_offset(size) +
+            sizeof(internal::coroutine_frame_deallocator*));
+        ::new(static_cast<void*>(
+                  internal::coroutine_frame_deallocator_slot(frame, size)))
+            internal::coroutine_frame_deallocator*(
+                                          &internal::coroutine_frame_delete);
+        return frame;
+    }
+
+    // Free coroutine: `f(allocator_arg, a, args...)`.
+    template <class Alloc, class... Args>
+    static void* operator new(size_t size, allocator_arg_t,
+                              const Alloc& a, const Args&...) {
+        return internal::coroutine_frame_layout<Alloc>::allocate(size, a);
+    }
+
+    // Member coroutine: `obj.f(allocator_arg, a, args...)`.
+    template <class This, class Alloc, class... Args>
+    static void* operator new(size_t size, const This&, allocator_arg_t,
+                              const Alloc& a, const Args&...) {
+        return internal::coroutine_frame_layout<Alloc>::allocate(size, a);
+    }
+
+    static void operator delete(void* frame, size_t size) noexcept {
+        (*internal::coroutine_frame_deallocator_slot(frame, size))(frame,
+                                                                   size);
+    }
+};
+
+} // close namespace Cpp20
+} // close namespace std
+
+#endif // ! defined(INCLUDED_COROUTINE_ALLOCATOR_DOT_H)
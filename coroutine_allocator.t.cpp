@@ -0,0 +1,216 @@
+/* coroutine_allocator.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Test driver for `coroutine_allocator.h`.  Must be compiled with
+ * `-std=c++20`.  Frames are allocated both through the standard `std::pmr`
+ * and through this library's `pmr` from `memory_resource.h`.
+ */
+
+#include <coroutine_allocator.h>
+
+#include <memory_resource.h>
+#include <coroutine>
+#include <cstdlib>
+#include <memory_resource>
+#include <test_assert.h>
+
+namespace exp = std::Cpp20;
+namespace pmr = std::experimental::pmr;
+
+// Stateful allocator that counts the blocks obtained through it.
+template <class T>
+class CountingAlloc
+{
+    template <class> friend class CountingAlloc;
+
+    int* m_outstanding;
+
+public:
+    typedef T value_type;
+
+    explicit CountingAlloc(int* outstanding) : m_outstanding(outstanding) { }
+
+    template <class U>
+    CountingAlloc(const CountingAlloc<U>& other)
+        : m_outstanding(other.m_outstanding) { }
+
+    T* allocate(std::size_t n) {
+        ++*m_outstanding;
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        --*m_outstanding;
+        ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const CountingAlloc<U>& other) const
+        { return m_outstanding == other.m_outstanding; }
+};
+
+// Memory resource, derived from `MemoryResource` (`std::pmr` or this
+// library's `pmr::memory_resource`), that counts outstanding blocks.
+template <class MemoryResource>
+class CountingResource : public MemoryResource
+{
+public:
+    int m_outstanding = 0;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++m_outstanding;
+        return ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override {
+        --m_outstanding;
+        ::operator delete(p, bytes, std::align_val_t(alignment));
+    }
+
+    bool do_is_equal(const MemoryResource& other) const noexcept
+        override { return this == &other; }
+};
+
+// Minimal lazily-started coroutine returning an `int`.
+class Task
+{
+public:
+    struct promise_type : exp::coroutine_allocator_mixin {
+        int m_value = 0;
+
+        Task get_return_object() {
+            return Task(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(int v) { m_value = v; }
+        void unhandled_exception() { std::abort(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : m_handle(h) { }
+
+public:
+    Task(Task&& other) noexcept : m_handle(other.m_handle)
+        { other.m_handle = nullptr; }
+
+    ~Task() {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    int get() {
+        m_handle.resume();
+        return m_handle.promise().m_value;
+    }
+};
+
+Task plain(int x)
+{
+    co_return x + 1;
+}
+
+// GCC pairs an `operator new` with an `operator delete` by name, and the
+// usual `operator delete` that frees a frame cannot be a template like the
+// allocator-taking `operator new` that allocated it.
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+template <class Alloc>
+Task withAlloc(std::allocator_arg_t, Alloc, int x)
+{
+    co_return x * 2;
+}
+
+struct Handler
+{
+    int m_base;
+
+    template <class Alloc>
+    Task handle(std::allocator_arg_t, const Alloc&, int x) const
+    {
+        co_return m_base + x;
+    }
+};
+
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+int main()
+{
+    // Frames of coroutines without an allocator come from global new
+    {
+        Task t = plain(1);
+        TEST_ASSERT(2 == t.get());
+    }
+
+    // A leading allocator argument supplies the frame
+    {
+        int outstanding = 0;
+        {
+            Task t = withAlloc(std::allocator_arg,
+                               CountingAlloc<char>(&outstanding), 4);
+            TEST_ASSERT(1 == outstanding);
+            TEST_ASSERT(8 == t.get());
+        }
+        TEST_ASSERT(0 == outstanding);
+    }
+
+    // Member coroutines
+    {
+        int outstanding = 0;
+        const Handler h{ 10 };
+        {
+            Task t = h.handle(std::allocator_arg,
+                              CountingAlloc<int>(&outstanding), 5);
+            TEST_ASSERT(1 == outstanding);
+            TEST_ASSERT(15 == t.get());
+        }
+        TEST_ASSERT(0 == outstanding);
+    }
+
+    // A polymorphic allocator allocates the frame from its resource
+    {
+        CountingResource<std::pmr::memory_resource> r;
+        {
+            Task t = withAlloc(std::allocator_arg,
+                               std::pmr::polymorphic_allocator<>(&r), 3);
+            TEST_ASSERT(1 == r.m_outstanding);
+            TEST_ASSERT(6 == t.get());
+        }
+        TEST_ASSERT(0 == r.m_outstanding);
+    }
+
+    // So does this library's polymorphic allocator
+    {
+        CountingResource<pmr::memory_resource> r;
+        {
+            Task t = withAlloc(std::allocator_arg,
+                               pmr::polymorphic_allocator<>(&r), 7);
+            TEST_ASSERT(1 == r.m_outstanding);
+            TEST_ASSERT(14 == t.get());
+        }
+        TEST_ASSERT(0 == r.m_outstanding);
+
+        const Handler h{ 1 };
+        {
+            Task t = h.handle(std::allocator_arg,
+                              pmr::polymorphic_allocator<int>(&r), 2);
+            TEST_ASSERT(1 == r.m_outstanding);
+            TEST_ASSERT(3 == t.get());
+        }
+        TEST_ASSERT(0 == r.m_outstanding);
+    }
+
+    return errorCount();
+}
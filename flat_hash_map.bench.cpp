@@ -0,0 +1,126 @@
+/* flat_hash_map.bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Micro-benchmarks of `pmr::flat_hash_map` against `std::unordered_map`
+ * with a polymorphic allocator, mapping string keys to string values, with
+ * keys, values, and table all allocated from one
+ * `unsynchronized_pool_resource` per map.  Keys are too long for the
+ * short-string buffer, so every inserted element allocates its key and
+ * value from the pool.  The `insert` rows clear the map every `k_KEYS`
+ * insertions; the clearing is included in the time.
+ */
+
+#include <flat_hash_map.h>
+
+#include <bench.h>
+#include <pool_resource.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+typedef std::basic_string<char, std::char_traits<char>,
+                          pmr::polymorphic_allocator<char>> PmrString;
+
+// FNV-1a hash of the characters of a `PmrString`, used by both maps.
+struct StringHash
+{
+    std::size_t operator()(const PmrString& s) const {
+        std::size_t h = 14695981039346656037ull;
+        for (char c : s)
+            h = (h ^ (unsigned char) c) * 1099511628211ull;
+        return h;
+    }
+};
+
+typedef pmr::flat_hash_map<PmrString, PmrString, StringHash> FlatMap;
+
+typedef std::unordered_map<PmrString, PmrString, StringHash,
+                           std::equal_to<PmrString>,
+                           pmr::polymorphic_allocator<
+                               std::pair<const PmrString, PmrString>>>
+    UnorderedMap;
+
+static const long k_KEYS = 1 << 14;
+
+// Return `n` distinct keys starting at `first`.
+std::vector<PmrString> makeKeys(long first, long n)
+{
+    std::vector<PmrString> ret;
+    for (long i = first; i < first + n; ++i)
+        ret.emplace_back(("key that does not fit in the buffer " +
+                          std::to_string(i)).c_str());
+    return ret;
+}
+
+// Insert an element with the absent `key` and `value`.  `try_emplace` is
+// not available for `std::unordered_map` in C++14, but `emplace` constructs
+// the node before looking up the key and so costs the same when the key is
+// absent.
+void insert(UnorderedMap& m, const PmrString& key, const char* value)
+{
+    m.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+              std::forward_as_tuple(value));
+}
+
+void insert(FlatMap& m, const PmrString& key, const char* value)
+{
+    m.try_emplace(key, value);
+}
+
+// Run the benchmarks for a map of type `Map` named `name`.
+template <class Map>
+void runSuite(const char* name, const std::vector<PmrString>& keys,
+              const std::vector<PmrString>& missingKeys)
+{
+    const char* value = "mapped value that does not fit in the buffer";
+
+    {
+        pmr::unsynchronized_pool_resource pool;
+        Map m(&pool);
+        bench::run("hash_map_insert", name, [&](long i) {
+                if (i % k_KEYS == 0)
+                    m.clear();
+                insert(m, keys[i % k_KEYS], value);
+            });
+    }
+
+    pmr::unsynchronized_pool_resource pool;
+    Map m(&pool);
+    for (const PmrString& key : keys)
+        insert(m, key, value);
+
+    bench::run("hash_map_find_hit", name, [&](long i) {
+            bench::doNotOptimize(m.find(keys[i % k_KEYS]));
+        });
+
+    bench::run("hash_map_find_miss", name, [&](long i) {
+            bench::doNotOptimize(m.find(missingKeys[i % k_KEYS]));
+        });
+
+    // Steady state: erase an element and insert another, keeping the size
+    // constant.
+    bench::run("hash_map_erase_insert", name, [&](long i) {
+            const long k = i % k_KEYS;
+            m.erase(keys[k]);
+            insert(m, keys[k], value);
+        });
+}
+
+int main(int argc, char *argv[])
+{
+    bench::parseArgs(argc, argv);
+    bench::printHeader();
+
+    const std::vector<PmrString> keys = makeKeys(0, k_KEYS);
+    const std::vector<PmrString> missingKeys = makeKeys(k_KEYS, k_KEYS);
+
+    runSuite<UnorderedMap>("unordered_map", keys, missingKeys);
+    runSuite<FlatMap>("flat_hash_map", keys, missingKeys);
+
+    return 0;
+}
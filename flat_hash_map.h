@@ -0,0 +1,944 @@
+/* flat_hash_map.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `flat_hash_map`, an open-addressing hash map in the style of the "Swiss
+ * table", whose `pair<const Key, T>` slots are constructed with
+ * `uninitialized_construct_using_allocator` so that the map's allocator is
+ * passed to both the key and the mapped value (extension).
+ */
+
+#ifndef INCLUDED_FLAT_HASH_MAP_DOT_H
+#define INCLUDED_FLAT_HASH_MAP_DOT_H
+
+#include <alloc_vector.h>
+#include <uses_allocator.h>
+#include <memory_resource.h>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// Each slot of a `flat_hash_map` has a control byte.  The control byte of a
+// full slot holds the low 7 bits of the hash of its key and is therefore
+// non-negative.  The other states are negative, with `hash_ctrl_sentinel`
+// the largest, so that empty and deleted slots can be found with a single
+// signed comparison.  The sentinel follows the last slot and stops
+// iteration.
+typedef signed char hash_ctrl_t;
+constexpr hash_ctrl_t hash_ctrl_empty    = -128;
+constexpr hash_ctrl_t hash_ctrl_deleted  = -2;
+constexpr hash_ctrl_t hash_ctrl_sentinel = -1;
+
+// Index of the lowest set bit of the non-zero `mask`.
+inline unsigned hash_trailing_zeros(unsigned mask)
+{
+    return unsigned(__builtin_ctz(mask));
+}
+
+// Number of zero bits above the highest set bit of the non-zero 16-bit
+// `mask`.
+inline unsigned hash_leading_zeros16(unsigned mask)
+{
+    return unsigned(__builtin_clz(mask)) - (8 * sizeof(unsigned) - 16);
+}
+
+// A group of 16 consecutive control bytes, matched all at once.  Each
+// `match` function returns a mask with bit `i` set if control byte `i`
+// matches.  The group is loaded with SSE2 if available and compared a byte
+// at a time otherwise.
+class hash_ctrl_group
+{
+public:
+    enum { width = 16 };
+
+#ifdef __SSE2__
+private:
+    __m128i m_ctrl;
+
+    static unsigned mask(__m128i m)
+        { return unsigned(_mm_movemask_epi8(m)); }
+
+public:
+    explicit hash_ctrl_group(const hash_ctrl_t* p)
+        : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) { }
+
+    unsigned match(hash_ctrl_t h2) const
+        { return mask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl)); }
+
+    unsigned match_empty_or_deleted() const {
+        return mask(_mm_cmpgt_epi8(_mm_set1_epi8(hash_ctrl_sentinel),
+                                   m_ctrl));
+    }
+#else
+private:
+    hash_ctrl_t m_ctrl[width];
+
+public:
+    explicit hash_ctrl_group(const hash_ctrl_t* p)
+        { std::memcpy(m_ctrl, p, width); }
+
+    unsigned match(hash_ctrl_t h2) const {
+        unsigned ret = 0;
+        for (unsigned i = 0; i < width; ++i)
+            ret |= unsigned(m_ctrl[i] == h2) << i;
+        return ret;
+    }
+
+    unsigned match_empty_or_deleted() const {
+        unsigned ret = 0;
+        for (unsigned i = 0; i < width; ++i)
+            ret |= unsigned(m_ctrl[i] < hash_ctrl_sentinel) << i;
+        return ret;
+    }
+#endif
+
+    unsigned match_empty() const { return match(hash_ctrl_empty); }
+
+    // Return the number of empty or deleted slots at the start of the group.
+    unsigned count_leading_empty_or_deleted() const
+        { return hash_trailing_zeros(match_empty_or_deleted() + 1); }
+};
+
+// Control bytes of a table with no slots: a sentinel, so that iteration
+// stops at once, followed by empty bytes, so that lookup does too.
+inline hash_ctrl_t* hash_empty_group()
+{
+    // Header-only static variable
+    alignas(16) static hash_ctrl_t group[hash_ctrl_group::width] = {
+        hash_ctrl_sentinel,
+        hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty,
+        hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty,
+        hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty,
+        hash_ctrl_empty, hash_ctrl_empty, hash_ctrl_empty
+    };
+    return group;
+}
+
+// Scramble the bits of the hash value `h`, since the standard hash of an
+// integer is often the integer itself and both the high bits (which select
+// the probe position) and the low 7 bits (which are stored in the control
+// byte) must be well distributed.
+inline size_t hash_mix(size_t h)
+{
+    const size_t k = sizeof(size_t) == 8 ? size_t(0x9e3779b97f4a7c15ull)
+                                         : size_t(0x9e3779b9u);
+    h *= k;
+    return h ^ (h >> (4 * sizeof(size_t)));
+}
+
+} // close namespace internal
+
+// An unordered associative container with the interface of
+// `std::unordered_map`, implemented as an open-addressing table of
+// `pair<const Key, T>` slots with one control byte per slot.  Lookup probes
+// the control bytes 16 at a time (using SSE2 if available), comparing the
+// key only for slots whose control byte matches 7 bits of its hash.  The
+// maximum load factor is 7/8.
+//
+// Elements are constructed with `uninitialized_construct_using_allocator`
+// using the map's allocator, which is therefore passed to the key and to the
+// mapped value.  Unlike `std::unordered_map`, an insertion that grows the
+// table relocates the elements and invalidates all iterators and
+// references, so the arguments to an insertion must not refer to elements
+// of the map.  Elements are relocated with `memcpy` if
+// `is_trivially_relocatable<pair<const Key, T>>` is true, and otherwise
+// moved (including the key, through a `const_cast`, since the source is
+// destroyed immediately afterwards) if neither `Key` nor `T` can throw when
+// moved by uses-allocator construction, and copied otherwise.  The
+// allocator must use raw pointers.
+template <class Key, class T, class Hash = hash<Key>,
+          class KeyEqual = equal_to<Key>,
+          class Alloc = allocator<pair<const Key, T>>>
+class flat_hash_map
+{
+public:
+    typedef Key                                   key_type;
+    typedef T                                     mapped_type;
+    typedef pair<const Key, T>                    value_type;
+    typedef size_t                                size_type;
+    typedef ptrdiff_t                             difference_type;
+    typedef Hash                                  hasher;
+    typedef KeyEqual                              key_equal;
+    typedef Alloc                                 allocator_type;
+    typedef value_type&                           reference;
+    typedef const value_type&                     const_reference;
+    typedef value_type*                           pointer;
+    typedef const value_type*                     const_pointer;
+
+private:
+    typedef allocator_traits<Alloc>                          AT;
+    typedef internal::hash_ctrl_t                            ctrl_t;
+    typedef internal::hash_ctrl_group                        group;
+    typedef typename AT::template rebind_alloc<ctrl_t>       CtrlAlloc;
+    typedef allocator_traits<CtrlAlloc>                      CtrlAT;
+
+    static_assert(is_same<typename AT::pointer, value_type*>::value,
+                  "flat_hash_map requires an allocator with raw pointers");
+
+    typedef is_trivially_relocatable<value_type> trivially_relocatable;
+    typedef internal::is_nothrow_uses_allocator_constructible<
+                value_type, Alloc, piecewise_construct_t, tuple<Key&&>,
+                tuple<T&&>>
+        nothrow_relocatable;
+    typedef integral_constant<bool, noexcept(std::declval<const Hash&>()(
+                                             std::declval<const Key&>()))>
+        nothrow_hash;
+
+    Alloc       m_alloc;
+    Hash        m_hash;
+    KeyEqual    m_eq;
+    ctrl_t*     m_ctrl;         // `m_capacity + width` control bytes
+    value_type* m_slots;        // `m_capacity` slots
+    size_t      m_capacity;     // 0 or a power of two minus one
+    size_t      m_size;
+    size_t      m_growth_left;  // Empty slots that may still be filled
+
+    // Iterators point to a control byte and the corresponding slot and skip
+    // slots that are not full.
+    template <bool IsConst>
+    class iterator_imp
+    {
+        friend class flat_hash_map;
+        template <bool> friend class iterator_imp;
+
+    public:
+        typedef forward_iterator_tag                   iterator_category;
+        typedef flat_hash_map::value_type              value_type;
+        typedef ptrdiff_t                              difference_type;
+        typedef conditional_t<IsConst, const value_type*, value_type*>
+                                                       pointer;
+        typedef conditional_t<IsConst, const value_type&, value_type&>
+                                                       reference;
+
+    private:
+        const ctrl_t* m_ctrl;
+        value_type*   m_slot;
+
+        iterator_imp(const ctrl_t* ctrl, value_type* slot)
+            : m_ctrl(ctrl), m_slot(slot) { }
+
+        void skip_empty_or_deleted() {
+            while (*m_ctrl < internal::hash_ctrl_sentinel) {
+                unsigned n = group(m_ctrl).count_leading_empty_or_deleted();
+                m_ctrl += n;
+                m_slot += n;
+            }
+        }
+
+    public:
+        iterator_imp() : m_ctrl(nullptr), m_slot(nullptr) { }
+
+        // Conversion from `iterator` to `const_iterator`.
+        template <bool C, class = enable_if_t<IsConst && ! C>>
+        iterator_imp(const iterator_imp<C>& other)
+            : m_ctrl(other.m_ctrl), m_slot(other.m_slot) { }
+
+        reference operator*() const { return *m_slot; }
+        pointer operator->() const { return m_slot; }
+
+        iterator_imp& operator++() {
+            ++m_ctrl;
+            ++m_slot;
+            skip_empty_or_deleted();
+            return *this;
+        }
+
+        iterator_imp operator++(int) {
+            iterator_imp ret(*this);
+            ++*this;
+            return ret;
+        }
+
+        friend bool operator==(const iterator_imp& a, const iterator_imp& b)
+            { return a.m_slot == b.m_slot; }
+
+        friend bool operator!=(const iterator_imp& a, const iterator_imp& b)
+            { return a.m_slot != b.m_slot; }
+    };
+
+public:
+    typedef iterator_imp<false> iterator;
+    typedef iterator_imp<true>  const_iterator;
+
+private:
+    size_t hash_of(const Key& key) const
+        { return internal::hash_mix(m_hash(key)); }
+
+    // The high bits of the hash select the first group to probe; the low 7
+    // bits are stored in the control byte.
+    static size_t h1(size_t hash) { return hash >> 7; }
+    static ctrl_t h2(size_t hash) { return ctrl_t(hash & 0x7f); }
+
+    // Number of elements that fit in `cap` slots at the maximum load factor.
+    static size_t growth_for(size_t cap) { return cap - cap / 8; }
+
+    // Return the smallest valid capacity at which `n` elements fit.
+    static size_t capacity_for(size_t n) {
+        size_t cap = size_t(group::width) - 1;
+        while (growth_for(cap) < n)
+            cap = 2 * cap + 1;
+        return cap;
+    }
+
+    // Set control byte `i`, and its copy after the sentinel that lets groups
+    // starting near the end of the table be loaded without wrapping.
+    void set_ctrl(size_t i, ctrl_t c) noexcept {
+        m_ctrl[i] = c;
+        if (i < size_t(group::width) - 1)
+            m_ctrl[i + m_capacity + 1] = c;
+    }
+
+    // Probe the groups for `hash` starting at position `h1(hash)`, with the
+    // distance between groups growing by one group width each time, until
+    // `f(offset, g)` returns true for group `g` starting at `offset`.  Every
+    // group is visited, since the number of slots is a power of two.
+    template <class F>
+    void probe(size_t hash, F f) const {
+        size_t offset = h1(hash) & m_capacity;
+        for (size_t step = group::width; ! f(offset, group(m_ctrl + offset));
+             step += group::width)
+            offset = (offset + step) & m_capacity;
+    }
+
+    // Return the index of the slot holding `key`, or `m_capacity` if none.
+    size_t find_index(const Key& key, size_t hash) const {
+        const ctrl_t tag = h2(hash);
+        size_t ret = m_capacity;
+        probe(hash, [&](size_t offset, const group& g) {
+                for (unsigned m = g.match(tag); m; m &= m - 1) {
+                    size_t i = (offset + internal::hash_trailing_zeros(m)) &
+                               m_capacity;
+                    if (m_eq(m_slots[i].first, key)) {
+                        ret = i;
+                        return true;
+                    }
+                }
+                return g.match_empty() != 0;
+            });
+        return ret;
+    }
+
+    // Return the index of the first empty or deleted slot for `hash`.  The
+    // table always has at least one empty slot.
+    size_t find_first_non_full(size_t hash) const {
+        size_t ret = 0;
+        probe(hash, [&](size_t offset, const group& g) {
+                unsigned m = g.match_empty_or_deleted();
+                if (m)
+                    ret = (offset + internal::hash_trailing_zeros(m)) &
+                          m_capacity;
+                return m != 0;
+            });
+        return ret;
+    }
+
+    // Construct a new element from `args` in a free slot for `hash`, growing
+    // the table if needed, and return its index.  The key of the new
+    // element must not already be present.  If an exception is thrown, no
+    // element is added.
+    template <class... Args>
+    size_t insert_unique(size_t hash, Args&&... args) {
+        size_t i = find_first_non_full(hash);
+        if (m_growth_left == 0 && m_ctrl[i] != internal::hash_ctrl_deleted) {
+            // Rehash in place if most non-full slots hold tombstones.
+            rehash_imp(m_capacity > size_t(group::width) &&
+                       m_size * 32 <= m_capacity * 25 ?
+                       m_capacity : capacity_for(m_size + 1));
+            i = find_first_non_full(hash);
+        }
+        Cpp20::uninitialized_construct_using_allocator(
+            m_slots + i, m_alloc, std::forward<Args>(args)...);
+        m_growth_left -= (m_ctrl[i] == internal::hash_ctrl_empty);
+        set_ctrl(i, h2(hash));
+        ++m_size;
+        return i;
+    }
+
+    // Return the element with `key`, inserting one constructed from
+    // `piecewise_construct, forward_as_tuple(key), forward_as_tuple(args...)`
+    // if there is none.
+    template <class K, class... Args>
+    pair<iterator, bool> try_emplace_imp(K&& key, Args&&... args) {
+        const size_t hash = hash_of(key);
+        size_t i = find_index(key, hash);
+        if (i != m_capacity)
+            return { iterator_at(i), false };
+        i = insert_unique(hash, piecewise_construct,
+                          forward_as_tuple(std::forward<K>(key)),
+                          forward_as_tuple(std::forward<Args>(args)...));
+        return { iterator_at(i), true };
+    }
+
+    iterator iterator_at(size_t i) noexcept
+        { return iterator(m_ctrl + i, m_slots + i); }
+    const_iterator iterator_at(size_t i) const noexcept
+        { return const_iterator(m_ctrl + i, m_slots + i); }
+
+    size_t index_of(const_iterator pos) const noexcept
+        { return size_t(pos.m_slot - m_slots); }
+
+    bool is_full(size_t i) const noexcept { return m_ctrl[i] >= 0; }
+
+    // Construct a copy of `*from` at `to` for relocation.  The original must
+    // then be destroyed.
+    void relocate_construct(true_type /* nothrow */, value_type* from,
+                            value_type* to) {
+        Cpp20::uninitialized_construct_using_allocator(to, m_alloc,
+                    piecewise_construct,
+                    forward_as_tuple(std::move(const_cast<Key&>(from->first))),
+                    forward_as_tuple(std::move(from->second)));
+    }
+
+    void relocate_construct(false_type /* nothrow */, value_type* from,
+                            value_type* to) {
+        Cpp20::uninitialized_construct_using_allocator(
+            to, m_alloc, static_cast<const value_type&>(*from));
+    }
+
+    // Relocate the elements of the table with control bytes `ctrl`, slots
+    // `slots`, and capacity `cap` into the current (empty) table.
+    void relocate_all(true_type /* trivially relocatable */, ctrl_t* ctrl,
+                      value_type* slots, size_t cap) {
+        for (size_t i = 0; i < cap; ++i) {
+            if (ctrl[i] >= 0) {
+                size_t hash = hash_of(slots[i].first);
+                size_t j = find_first_non_full(hash);
+                std::memcpy(static_cast<void*>(m_slots + j),
+                            static_cast<const void*>(slots + i),
+                            sizeof(value_type));
+                set_ctrl(j, h2(hash));
+            }
+        }
+    }
+
+    void relocate_all(false_type /* trivially relocatable */, ctrl_t* ctrl,
+                      value_type* slots, size_t cap) {
+        if (nothrow_relocatable::value && ! nothrow_hash::value) {
+            relocate_all_prehashed(ctrl, slots, cap);
+            return;
+        }
+        for (size_t i = 0; i < cap; ++i) {
+            if (ctrl[i] >= 0) {
+                size_t hash = hash_of(slots[i].first);
+                size_t j = find_first_non_full(hash);
+                relocate_construct(nothrow_relocatable(), slots + i,
+                                   m_slots + j);
+                set_ctrl(j, h2(hash));
+            }
+        }
+        for (size_t i = 0; i < cap; ++i)
+            if (ctrl[i] >= 0)
+                slots[i].~value_type();
+    }
+
+    // Move the elements of the table with control bytes `ctrl`, slots
+    // `slots`, and capacity `cap` into the current (empty) table, hashing
+    // them all before moving any, so that if the hash function throws, no
+    // element has been moved from.
+    void relocate_all_prehashed(ctrl_t* ctrl, value_type* slots, size_t cap) {
+        typedef typename AT::template rebind_alloc<size_t> SizeAlloc;
+        typedef allocator_traits<SizeAlloc>                SizeAT;
+
+        const size_t n = m_size;
+        if (0 == n)
+            return;
+        SizeAlloc size_alloc(m_alloc);
+        size_t* hashes = SizeAT::allocate(size_alloc, n);
+        try {
+            for (size_t i = 0, k = 0; i < cap; ++i)
+                if (ctrl[i] >= 0)
+                    hashes[k++] = hash_of(slots[i].first);
+        }
+        catch (...) {
+            SizeAT::deallocate(size_alloc, hashes, n);
+            throw;
+        }
+
+        for (size_t i = 0, k = 0; i < cap; ++i) {
+            if (ctrl[i] >= 0) {
+                size_t j = find_first_non_full(hashes[k]);
+                relocate_construct(true_type(), slots + i, m_slots + j);
+                slots[i].~value_type();
+                set_ctrl(j, h2(hashes[k++]));
+            }
+        }
+        SizeAT::deallocate(size_alloc, hashes, n);
+    }
+
+    // Allocate `cap` slots and their control bytes, all empty, and make them
+    // the current table without freeing the old one.
+    void allocate_table(size_t cap) {
+        CtrlAlloc ctrl_alloc(m_alloc);
+        ctrl_t* ctrl = CtrlAT::allocate(ctrl_alloc, cap + group::width);
+        try {
+            m_slots = AT::allocate(m_alloc, cap);
+        }
+        catch (...) {
+            CtrlAT::deallocate(ctrl_alloc, ctrl, cap + group::width);
+            throw;
+        }
+        std::memset(ctrl, internal::hash_ctrl_empty, cap + group::width);
+        ctrl[cap] = internal::hash_ctrl_sentinel;
+        m_ctrl = ctrl;
+        m_capacity = cap;
+        m_growth_left = growth_for(cap);
+    }
+
+    void deallocate_table(ctrl_t* ctrl, value_type* slots, size_t cap) {
+        if (cap) {
+            CtrlAlloc ctrl_alloc(m_alloc);
+            CtrlAT::deallocate(ctrl_alloc, ctrl, cap + group::width);
+            AT::deallocate(m_alloc, slots, cap);
+        }
+    }
+
+    // Move the elements to a new table of `cap` slots, which must be enough
+    // to hold them.  If an exception is thrown, `*this` is unchanged.
+    void rehash_imp(size_t cap) {
+        ctrl_t* old_ctrl = m_ctrl;
+        value_type* old_slots = m_slots;
+        const size_t old_cap = m_capacity;
+        const size_t old_growth_left = m_growth_left;
+        allocate_table(cap);
+        try {
+            relocate_all(trivially_relocatable(), old_ctrl, old_slots,
+                         old_cap);
+        }
+        catch (...) {
+            // Only the hash function can throw when relocating bytes or
+            // moving elements, which happens before any element is moved
+            // from, and the copies made so far are then simply discarded.
+            if (! trivially_relocatable::value)
+                destroy_elements();
+            deallocate_table(m_ctrl, m_slots, m_capacity);
+            m_ctrl = old_ctrl;
+            m_slots = old_slots;
+            m_capacity = old_cap;
+            m_growth_left = old_growth_left;
+            throw;
+        }
+        deallocate_table(old_ctrl, old_slots, old_cap);
+        m_growth_left -= m_size;
+    }
+
+    // Destroy the element at index `i` and free its slot.  The slot is
+    // marked empty if no probe sequence can have passed over it when it was
+    // full, i.e., if every group containing it also contains an empty
+    // slot, and is otherwise marked deleted.
+    void erase_at(size_t i) noexcept {
+        m_slots[i].~value_type();
+        --m_size;
+        const size_t before = (i - group::width) & m_capacity;
+        const unsigned empty_after = group(m_ctrl + i).match_empty();
+        const unsigned empty_before = group(m_ctrl + before).match_empty();
+        const bool was_never_full = empty_before && empty_after &&
+            internal::hash_trailing_zeros(empty_after) +
+            internal::hash_leading_zeros16(empty_before) < group::width;
+        set_ctrl(i, was_never_full ? internal::hash_ctrl_empty :
+                                     internal::hash_ctrl_deleted);
+        m_growth_left += was_never_full;
+    }
+
+    void destroy_elements() noexcept {
+        if (! is_trivially_destructible<value_type>::value)
+            for (size_t i = 0; i < m_capacity; ++i)
+                if (is_full(i))
+                    m_slots[i].~value_type();
+    }
+
+    // Take over the table of `other`, leaving it empty.
+    void steal(flat_hash_map& other) noexcept {
+        m_ctrl = other.m_ctrl;
+        m_slots = other.m_slots;
+        m_capacity = other.m_capacity;
+        m_size = other.m_size;
+        m_growth_left = other.m_growth_left;
+        other.reset_empty();
+    }
+
+    void reset_empty() noexcept {
+        m_ctrl = internal::hash_empty_group();
+        m_slots = nullptr;
+        m_capacity = m_size = m_growth_left = 0;
+    }
+
+    void swap_table(flat_hash_map& other) noexcept {
+        using std::swap;
+        swap(m_ctrl, other.m_ctrl);
+        swap(m_slots, other.m_slots);
+        swap(m_capacity, other.m_capacity);
+        swap(m_size, other.m_size);
+        swap(m_growth_left, other.m_growth_left);
+    }
+
+    // Insert the elements of `other`, which have distinct keys not present
+    // in `*this`.  The mapped values are moved if `other` is an rvalue;
+    // the keys are always copied.
+    template <class Map>
+    void insert_all_unique(Map&& other) {
+        typedef conditional_t<is_lvalue_reference<Map>::value, const T&, T&&>
+            mapped_ref;
+        reserve(size() + other.size());
+        for (size_t i = 0; i < other.m_capacity; ++i) {
+            if (other.is_full(i)) {
+                value_type& elem = other.m_slots[i];
+                insert_unique(hash_of(elem.first), piecewise_construct,
+                              forward_as_tuple(elem.first),
+                              forward_as_tuple(
+                                  static_cast<mapped_ref>(elem.second)));
+            }
+        }
+    }
+
+public:
+    flat_hash_map() : flat_hash_map(0) { }
+
+    explicit flat_hash_map(size_t n, const Hash& h = Hash(),
+                           const KeyEqual& eq = KeyEqual(),
+                           const Alloc& a = Alloc())
+        : m_alloc(a), m_hash(h), m_eq(eq) {
+        reset_empty();
+        if (n)
+            reserve(n);
+    }
+
+    flat_hash_map(size_t n, const Alloc& a)
+        : flat_hash_map(n, Hash(), KeyEqual(), a) { }
+
+    explicit flat_hash_map(const Alloc& a)
+        : flat_hash_map(0, Hash(), KeyEqual(), a) { }
+
+    template <class InputIt, class = typename
+              iterator_traits<InputIt>::iterator_category>
+    flat_hash_map(InputIt first, InputIt last, size_t n = 0,
+                  const Hash& h = Hash(), const KeyEqual& eq = KeyEqual(),
+                  const Alloc& a = Alloc())
+        : flat_hash_map(n, h, eq, a) {
+        insert(first, last);
+    }
+
+    flat_hash_map(initializer_list<value_type> il, size_t n = 0,
+                  const Hash& h = Hash(), const KeyEqual& eq = KeyEqual(),
+                  const Alloc& a = Alloc())
+        : flat_hash_map(il.begin(), il.end(), n, h, eq, a) { }
+
+    flat_hash_map(const flat_hash_map& other)
+        : flat_hash_map(other,
+                    AT::select_on_container_copy_construction(other.m_alloc))
+        { }
+
+    flat_hash_map(const flat_hash_map& other, const Alloc& a)
+        : flat_hash_map(0, other.m_hash, other.m_eq, a) {
+        insert_all_unique(other);
+    }
+
+    flat_hash_map(flat_hash_map&& other) noexcept
+        : m_alloc(std::move(other.m_alloc)), m_hash(other.m_hash),
+          m_eq(other.m_eq) {
+        steal(other);
+    }
+
+    // Move-construct with allocator `a`.  If `a` differs from the allocator
+    // of `other`, the mapped values are moved and the keys copied one by
+    // one so that they use `a`.
+    flat_hash_map(flat_hash_map&& other, const Alloc& a)
+        : flat_hash_map(0, other.m_hash, other.m_eq, a) {
+        if (m_alloc == other.m_alloc)
+            steal(other);
+        else
+            insert_all_unique(std::move(other));
+    }
+
+    ~flat_hash_map() {
+        destroy_elements();
+        deallocate_table(m_ctrl, m_slots, m_capacity);
+    }
+
+    flat_hash_map& operator=(const flat_hash_map& rhs) {
+        if (this != &rhs) {
+            typedef typename AT::propagate_on_container_copy_assignment
+                propagate;
+            flat_hash_map tmp(rhs, propagate::value ? rhs.m_alloc : m_alloc);
+            swap_table(tmp);
+            internal::propagate_swap(propagate(), m_alloc, tmp.m_alloc);
+            m_hash = rhs.m_hash;
+            m_eq = rhs.m_eq;
+        }
+        return *this;
+    }
+
+    flat_hash_map& operator=(flat_hash_map&& rhs)
+        noexcept(AT::propagate_on_container_move_assignment::value ||
+                 AT::is_always_equal::value) {
+        if (this == &rhs)
+            return *this;
+        if (AT::propagate_on_container_move_assignment::value ||
+            m_alloc == rhs.m_alloc) {
+            destroy_elements();
+            deallocate_table(m_ctrl, m_slots, m_capacity);
+            internal::propagate_assign(
+                typename AT::propagate_on_container_move_assignment(),
+                m_alloc, rhs.m_alloc);
+            steal(rhs);
+        }
+        else {
+            // Unequal allocators that don't propagate: move element-wise.
+            flat_hash_map tmp(std::move(rhs), m_alloc);
+            swap_table(tmp);
+        }
+        m_hash = rhs.m_hash;
+        m_eq = rhs.m_eq;
+        return *this;
+    }
+
+    flat_hash_map& operator=(initializer_list<value_type> il) {
+        clear();
+        insert(il);
+        return *this;
+    }
+
+    allocator_type get_allocator() const noexcept { return m_alloc; }
+    hasher hash_function() const { return m_hash; }
+    key_equal key_eq() const { return m_eq; }
+
+    // Iterators
+    iterator begin() noexcept {
+        if (! m_size)
+            return end();
+        iterator ret(m_ctrl, m_slots);
+        ret.skip_empty_or_deleted();
+        return ret;
+    }
+
+    const_iterator begin() const noexcept
+        { return const_cast<flat_hash_map*>(this)->begin(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return iterator_at(m_capacity); }
+    const_iterator end() const noexcept { return iterator_at(m_capacity); }
+    const_iterator cend() const noexcept { return end(); }
+
+    // Capacity
+    bool empty() const noexcept { return m_size == 0; }
+    size_t size() const noexcept { return m_size; }
+    size_t max_size() const noexcept { return AT::max_size(m_alloc); }
+
+    // Modifiers
+    void clear() noexcept {
+        destroy_elements();
+        if (m_capacity) {
+            std::memset(m_ctrl, internal::hash_ctrl_empty,
+                        m_capacity + group::width);
+            m_ctrl[m_capacity] = internal::hash_ctrl_sentinel;
+        }
+        m_size = 0;
+        m_growth_left = growth_for(m_capacity);
+    }
+
+    pair<iterator, bool> insert(const value_type& value)
+        { return try_emplace_imp(value.first, value.second); }
+
+    pair<iterator, bool> insert(value_type&& value)
+        { return try_emplace_imp(value.first, std::move(value.second)); }
+
+    template <class InputIt, class = typename
+              iterator_traits<InputIt>::iterator_category>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first)
+            emplace(*first);
+    }
+
+    void insert(initializer_list<value_type> il)
+        { insert(il.begin(), il.end()); }
+
+    // Construct an element from `args` and insert it if its key is not
+    // present.  Since the key is not known until the element is
+    // constructed, it is constructed outside the table (with the map's
+    // allocator) and relocated into it; prefer `try_emplace` when the key is
+    // available separately.
+    template <class... Args>
+    pair<iterator, bool> emplace(Args&&... args) {
+        value_type tmp(Cpp20::make_obj_using_allocator<value_type>(
+                           m_alloc, std::forward<Args>(args)...));
+        const size_t hash = hash_of(tmp.first);
+        size_t i = find_index(tmp.first, hash);
+        if (i != m_capacity)
+            return { iterator_at(i), false };
+        i = insert_unique(hash, piecewise_construct,
+                forward_as_tuple(std::move(const_cast<Key&>(tmp.first))),
+                forward_as_tuple(std::move(tmp.second)));
+        return { iterator_at(i), true };
+    }
+
+    template <class... Args>
+    pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+        { return try_emplace_imp(key, std::forward<Args>(args)...); }
+
+    template <class... Args>
+    pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+        return try_emplace_imp(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template <class M>
+    pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+        pair<iterator, bool> ret = try_emplace_imp(key, std::forward<M>(obj));
+        if (! ret.second)
+            ret.first->second = std::forward<M>(obj);
+        return ret;
+    }
+
+    template <class M>
+    pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+        pair<iterator, bool> ret = try_emplace_imp(std::move(key),
+                                                   std::forward<M>(obj));
+        if (! ret.second)
+            ret.first->second = std::forward<M>(obj);
+        return ret;
+    }
+
+    // Erase the element at `pos` and return an iterator to the next one.
+    iterator erase(const_iterator pos) noexcept {
+        const size_t i = index_of(pos);
+        erase_at(i);
+        return ++iterator_at(i);
+    }
+
+    iterator erase(iterator pos) noexcept
+        { return erase(const_iterator(pos)); }
+
+    size_t erase(const Key& key) {
+        const size_t i = find_index(key, hash_of(key));
+        if (i == m_capacity)
+            return 0;
+        erase_at(i);
+        return 1;
+    }
+
+    void swap(flat_hash_map& other)
+        noexcept(AT::propagate_on_container_swap::value ||
+                 AT::is_always_equal::value) {
+        using std::swap;
+        internal::propagate_swap(typename AT::propagate_on_container_swap(),
+                                 m_alloc, other.m_alloc);
+        swap_table(other);
+        swap(m_hash, other.m_hash);
+        swap(m_eq, other.m_eq);
+    }
+
+    // Lookup
+    T& at(const Key& key) {
+        iterator it = find(key);
+        if (it == end())
+            throw out_of_range("flat_hash_map::at");
+        return it->second;
+    }
+
+    const T& at(const Key& key) const
+        { return const_cast<flat_hash_map*>(this)->at(key); }
+
+    T& operator[](const Key& key)
+        { return try_emplace_imp(key).first->second; }
+
+    T& operator[](Key&& key)
+        { return try_emplace_imp(std::move(key)).first->second; }
+
+    iterator find(const Key& key)
+        { return iterator_at(find_index(key, hash_of(key))); }
+
+    const_iterator find(const Key& key) const
+        { return iterator_at(find_index(key, hash_of(key))); }
+
+    size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+    bool contains(const Key& key) const
+        { return find_index(key, hash_of(key)) != m_capacity; }
+
+    // Hash policy.  `bucket_count` is the number of slots.
+    size_t bucket_count() const noexcept { return m_capacity; }
+
+    float load_factor() const noexcept
+        { return m_capacity ? float(m_size) / float(m_capacity) : 0.0f; }
+
+    float max_load_factor() const noexcept { return 0.875f; }
+
+    // Rehash to a table of at least `n` slots that is large enough for the
+    // current elements, or free the table if both are zero.
+    void rehash(size_t n) {
+        if (n == 0 && m_size == 0) {
+            deallocate_table(m_ctrl, m_slots, m_capacity);
+            reset_empty();
+            return;
+        }
+        size_t cap = capacity_for(m_size);
+        while (cap < n)
+            cap = 2 * cap + 1;
+        if (cap != m_capacity)
+            rehash_imp(cap);
+    }
+
+    // Make room for `n` elements without further allocation.
+    void reserve(size_t n) {
+        if (n > m_size + m_growth_left)
+            rehash_imp(capacity_for(n));
+    }
+};
+
+template <class Key, class T, class Hash, class KeyEqual, class Alloc>
+bool operator==(const flat_hash_map<Key, T, Hash, KeyEqual, Alloc>& a,
+                const flat_hash_map<Key, T, Hash, KeyEqual, Alloc>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (const auto& elem : a) {
+        auto it = b.find(elem.first);
+        if (it == b.end() || ! (it->second == elem.second))
+            return false;
+    }
+    return true;
+}
+
+template <class Key, class T, class Hash, class KeyEqual, class Alloc>
+inline bool operator!=(const flat_hash_map<Key, T, Hash, KeyEqual, Alloc>& a,
+                       const flat_hash_map<Key, T, Hash, KeyEqual, Alloc>& b)
+{
+    return ! (a == b);
+}
+
+template <class Key, class T, class Hash, class KeyEqual, class Alloc>
+inline void swap(flat_hash_map<Key, T, Hash, KeyEqual, Alloc>& a,
+                 flat_hash_map<Key, T, Hash, KeyEqual, Alloc>& b)
+    noexcept(noexcept(a.swap(b)))
+{
+    a.swap(b);
+}
+
+} // close namespace Cpp20
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+template <class Key, class T, class Hash = hash<Key>,
+          class KeyEqual = equal_to<Key>>
+using flat_hash_map = Cpp20::flat_hash_map<Key, T, Hash, KeyEqual,
+                                  polymorphic_allocator<pair<const Key, T>>>;
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_FLAT_HASH_MAP_DOT_H)
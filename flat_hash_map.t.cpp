@@ -0,0 +1,417 @@
+/* flat_hash_map.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <flat_hash_map.h>
+
+#include <stats_resource.h>
+#include <string>
+#include <utility>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// String that gets its memory from a polymorphic allocator.
+typedef std::basic_string<char, std::char_traits<char>,
+                          pmr::polymorphic_allocator<char>> PmrString;
+
+// FNV-1a hash of the characters of a `PmrString`.
+struct StringHash
+{
+    std::size_t operator()(const PmrString& s) const {
+        std::size_t h = 14695981039346656037ull;
+        for (char c : s)
+            h = (h ^ (unsigned char) c) * 1099511628211ull;
+        return h;
+    }
+};
+
+// Hash function under which every key collides.
+struct CollidingHash
+{
+    std::size_t operator()(int) const { return 42; }
+};
+
+// Return a key long enough not to fit in the short-string buffer.
+PmrString longKey(int i, const pmr::polymorphic_allocator<char>& a)
+{
+    PmrString ret("a key that does not fit in the string: ", a);
+    ret += std::to_string(i).c_str();
+    return ret;
+}
+
+// Allocator-aware mapped type that takes a polymorphic allocator as a
+// trailing constructor argument.
+class PmrType
+{
+    pmr::polymorphic_allocator<> m_alloc;
+    int                          m_value;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static int s_copies;
+    static int s_moves;
+
+    explicit PmrType(const allocator_type& a) : m_alloc(a), m_value(0) { }
+    PmrType(int v, const allocator_type& a) : m_alloc(a), m_value(v) { }
+    PmrType(const PmrType& other, const allocator_type& a)
+        : m_alloc(a), m_value(other.m_value) { ++s_copies; }
+    PmrType(PmrType&& other, const allocator_type& a) noexcept
+        : m_alloc(a), m_value(other.m_value) { ++s_moves; }
+
+    PmrType& operator=(const PmrType& rhs)
+        { m_value = rhs.m_value; return *this; }
+
+    pmr::memory_resource* resource() const { return m_alloc.resource(); }
+    int value() const { return m_value; }
+
+    static void resetCounts() { s_copies = s_moves = 0; }
+};
+
+int PmrType::s_copies = 0;
+int PmrType::s_moves = 0;
+
+bool operator==(const PmrType& a, const PmrType& b)
+{
+    return a.value() == b.value();
+}
+
+// Type whose copy constructor throws after a set number of copies.  Its
+// move constructor may throw, so it is copied on relocation.
+struct Throwing
+{
+    static int s_live;
+    static int s_copiesBeforeThrow;
+    int m_value;
+
+    Throwing(int v) : m_value(v) { ++s_live; }
+    Throwing(const Throwing& o) : m_value(o.m_value) {
+        if (0 == s_copiesBeforeThrow--)
+            throw 1;
+        ++s_live;
+    }
+    ~Throwing() { --s_live; }
+};
+
+int Throwing::s_live = 0;
+int Throwing::s_copiesBeforeThrow = -1;
+
+// Hash function that throws after a set number of calls.
+struct ThrowingHash
+{
+    static int s_callsBeforeThrow;
+
+    std::size_t operator()(int key) const {
+        if (0 == s_callsBeforeThrow--)
+            throw 2;
+        return std::size_t(key);
+    }
+};
+
+int ThrowingHash::s_callsBeforeThrow = -1;
+
+// Type whose move constructor cannot throw and marks its source as moved
+// from.
+struct Movable
+{
+    int m_value;
+
+    Movable(int v) : m_value(v) { }
+    Movable(const Movable& o) : m_value(o.m_value) { }
+    Movable(Movable&& o) noexcept : m_value(o.m_value) { o.m_value = -1; }
+};
+
+int main()
+{
+    using exp::flat_hash_map;
+
+    // Basic operations with the default allocator
+    {
+        flat_hash_map<int, int> m;
+        TEST_ASSERT(m.empty());
+        TEST_ASSERT(m.begin() == m.end());
+        TEST_ASSERT(0 == m.bucket_count());
+        TEST_ASSERT(m.find(1) == m.end());
+        TEST_ASSERT(0 == m.erase(1));
+
+        const int n = 1000;
+        for (int i = 0; i < n; ++i) {
+            auto r = m.try_emplace(i, 2 * i);
+            TEST_ASSERT(r.second);
+            TEST_ASSERT(i == r.first->first);
+        }
+        TEST_ASSERT(n == m.size());
+        TEST_ASSERT(m.load_factor() <= m.max_load_factor());
+        TEST_ASSERT(! m.try_emplace(7, 0).second);
+        TEST_ASSERT(14 == m[7]);
+        TEST_ASSERT(! m.insert({ 7, 0 }).second);
+        TEST_ASSERT(! m.emplace(7, 0).second);
+
+        long sum = 0;
+        int count = 0;
+        for (const auto& elem : m) {
+            TEST_ASSERT(2 * elem.first == elem.second);
+            sum += elem.first;
+            ++count;
+        }
+        TEST_ASSERT(n == count);
+        TEST_ASSERT(long(n) * (n - 1) / 2 == sum);
+
+        for (int i = 0; i < n; i += 2)
+            TEST_ASSERT(1 == m.erase(i));
+        TEST_ASSERT(n / 2 == m.size());
+        for (int i = 0; i < n; ++i)
+            TEST_ASSERT((i % 2 == 1) == m.contains(i));
+        TEST_ASSERT(0 == m.count(n));
+
+        // Erasing through an iterator returns the next element
+        count = 0;
+        for (auto it = m.begin(); it != m.end(); ) {
+            if (it->first % 4 == 1)
+                it = m.erase(it);
+            else
+                ++it, ++count;
+        }
+        TEST_ASSERT(n / 4 == count);
+        TEST_ASSERT(n / 4 == m.size());
+
+        m[n] = 5;
+        TEST_ASSERT(5 == m.at(n));
+        TEST_ASSERT(! m.insert_or_assign(n, 6).second);
+        TEST_ASSERT(6 == m.at(n));
+        TEST_ASSERT(m.insert_or_assign(n + 1, 7).second);
+        TEST_ASSERT(m.emplace(std::make_pair(n + 2, 8)).second);
+        TEST_ASSERT(8 == m.at(n + 2));
+
+        bool caught = false;
+        try {
+            m.at(-1);
+        }
+        catch (const std::out_of_range&) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+
+        const std::size_t buckets = m.bucket_count();
+        m.clear();
+        TEST_ASSERT(m.empty());
+        TEST_ASSERT(m.begin() == m.end());
+        TEST_ASSERT(buckets == m.bucket_count());
+        m.rehash(0);
+        TEST_ASSERT(0 == m.bucket_count());
+
+        flat_hash_map<int, int> il{ { 1, 2 }, { 3, 4 }, { 1, 5 } };
+        TEST_ASSERT(2 == il.size());
+        TEST_ASSERT(2 == il[1]);
+        flat_hash_map<int, int> il2{ { 3, 4 }, { 1, 2 } };
+        TEST_ASSERT(il == il2);
+        il2[3] = 0;
+        TEST_ASSERT(il != il2);
+    }
+
+    // Colliding keys probe past each other and past deleted slots
+    {
+        flat_hash_map<int, int, CollidingHash> m;
+        for (int i = 0; i < 100; ++i)
+            m[i] = i;
+        for (int i = 0; i < 100; i += 3)
+            m.erase(i);
+        for (int i = 0; i < 100; ++i)
+            TEST_ASSERT((i % 3 != 0) == m.contains(i));
+        for (int i = 0; i < 100; i += 3)
+            m[i] = -i;
+        TEST_ASSERT(100 == m.size());
+        for (int i = 0; i < 100; ++i)
+            TEST_ASSERT((i % 3 ? i : -i) == m.at(i));
+    }
+
+    // Deleted slots are reclaimed without growing the table
+    {
+        flat_hash_map<int, int> m;
+        m.reserve(100);
+        const std::size_t buckets = m.bucket_count();
+        for (int i = 0; i < 100000; ++i) {
+            m[i] = i;
+            if (i >= 100)
+                m.erase(i - 100);
+        }
+        TEST_ASSERT(100 == m.size());
+        TEST_ASSERT(buckets == m.bucket_count());
+        for (int i = 100000 - 100; i < 100000; ++i)
+            TEST_ASSERT(i == m.at(i));
+    }
+
+    // The map's resource is passed to both keys and mapped values
+    {
+        pmr::stats_resource sr;
+        {
+            pmr::flat_hash_map<PmrString, PmrType, StringHash> m(&sr);
+            for (int i = 0; i < 100; ++i)
+                m.try_emplace(longKey(i, pmr::new_delete_resource()), i);
+            m.emplace(std::piecewise_construct,
+                      std::forward_as_tuple("a key emplaced piecewise into "
+                                            "the table"),
+                      std::forward_as_tuple(100));
+            m[longKey(101, &sr)];
+            TEST_ASSERT(102 == m.size());
+
+            for (const auto& elem : m) {
+                TEST_ASSERT(&sr == elem.first.get_allocator().resource());
+                TEST_ASSERT(&sr == elem.second.resource());
+            }
+            TEST_ASSERT(42 ==
+                        m.find(longKey(42, &sr))->second.value());
+            TEST_ASSERT(sr.snapshot().live_bytes > 0);
+        }
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    // Growth moves elements whose moves cannot throw...
+    {
+        pmr::flat_hash_map<int, PmrType> m;
+        PmrType::resetCounts();
+        for (int i = 0; i < 100; ++i)
+            m.try_emplace(i, i);
+        TEST_ASSERT(0 == PmrType::s_copies);
+        TEST_ASSERT(PmrType::s_moves > 0);
+    }
+
+    // ...and otherwise copies them, leaving the map unchanged on exception
+    {
+        flat_hash_map<int, Throwing> m;
+        m.reserve(14);
+        const std::size_t buckets = m.bucket_count();
+        int i = 0;
+        while (m.size() < 14)
+            m.try_emplace(i, i), ++i;
+        TEST_ASSERT(buckets == m.bucket_count());
+
+        Throwing::s_copiesBeforeThrow = 5;
+        bool caught = false;
+        try {
+            m.try_emplace(i, i);
+        }
+        catch (int) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(14 == m.size());
+        TEST_ASSERT(14 == Throwing::s_live);
+        TEST_ASSERT(buckets == m.bucket_count());
+        TEST_ASSERT(! m.contains(i));
+        for (int j = 0; j < i; ++j)
+            TEST_ASSERT(j == m.at(j).m_value);
+
+        Throwing::s_copiesBeforeThrow = -1;
+        m.try_emplace(i, i);
+        TEST_ASSERT(15 == m.size());
+        TEST_ASSERT(15 == Throwing::s_live);
+    }
+    TEST_ASSERT(0 == Throwing::s_live);
+
+    // A hash function that throws during growth leaves the map unchanged
+    // even when elements are moved, and the map remains usable.
+    {
+        flat_hash_map<int, Movable, ThrowingHash> m;
+        for (int i = 0; i < 200; ++i)
+            m.try_emplace(i, i);
+        for (int i = 0; i < 200; i += 3)
+            m.erase(i);
+
+        // The hash function is called once per insertion, and again for
+        // every element if the table grows, failing partway through.
+        int k = 200;
+        bool caught = false;
+        std::size_t buckets = 0;
+        while (! caught && k < 10000) {
+            buckets = m.bucket_count();
+            ThrowingHash::s_callsBeforeThrow = 10;
+            try {
+                m.try_emplace(k, k);
+                ++k;
+            }
+            catch (int) {
+                caught = true;
+            }
+        }
+        ThrowingHash::s_callsBeforeThrow = -1;
+        TEST_ASSERT(caught);
+        TEST_ASSERT(! m.contains(k));
+        TEST_ASSERT(buckets == m.bucket_count());
+        for (auto& e : m)
+            TEST_ASSERT(e.first == e.second.m_value);
+
+        // The table is as full as before, so retrying rehashes it, calling
+        // the hash function for every element.
+        const int calls = 1000000;
+        ThrowingHash::s_callsBeforeThrow = calls;
+        m.try_emplace(k, k);
+        TEST_ASSERT(calls - ThrowingHash::s_callsBeforeThrow > 1);
+        ThrowingHash::s_callsBeforeThrow = -1;
+
+        for (int i = k + 1; i < k + 1000; ++i) {
+            m.try_emplace(i, i);
+            TEST_ASSERT(! m.contains(-i));
+        }
+        for (auto& e : m)
+            TEST_ASSERT(e.first == e.second.m_value);
+    }
+
+    // Copy, move, and assignment with polymorphic allocators
+    {
+        typedef pmr::flat_hash_map<int, PmrType> Map;
+        pmr::stats_resource r1, r2;
+        Map m1(&r1);
+        m1.try_emplace(1, 10);
+        m1.try_emplace(2, 20);
+
+        // Copy construction does not propagate the resource
+        Map c(m1);
+        TEST_ASSERT(pmr::new_delete_resource() ==
+                    c.get_allocator().resource());
+        TEST_ASSERT(pmr::new_delete_resource() == c.at(1).resource());
+        TEST_ASSERT(c == m1);
+
+        Map c2(m1, &r2);
+        TEST_ASSERT(&r2 == c2.at(2).resource());
+
+        // Moving steals the table...
+        const PmrType* p = &c2.at(1);
+        Map m(std::move(c2));
+        TEST_ASSERT(p == &m.at(1));
+        TEST_ASSERT(c2.empty());
+
+        // ...unless a different resource is requested
+        Map m2(std::move(m), &r1);
+        TEST_ASSERT(&r1 == m2.at(1).resource());
+        TEST_ASSERT(m2 == m1);
+
+        // Assignment keeps the target's resource
+        Map t(&r2);
+        t = m1;
+        TEST_ASSERT(&r2 == t.get_allocator().resource());
+        TEST_ASSERT(&r2 == t.at(1).resource());
+        TEST_ASSERT(t == m1);
+
+        Map t2(&r2);
+        t2.try_emplace(5, 5);
+        t2 = std::move(t);
+        TEST_ASSERT(&r2 == t2.at(2).resource());
+        TEST_ASSERT(t2 == m1);
+
+        t2 = std::move(m2);  // Different resource: element-wise move
+        TEST_ASSERT(&r2 == t2.at(2).resource());
+        TEST_ASSERT(t2 == m1);
+
+        Map s(&r1);
+        s.swap(m1);
+        TEST_ASSERT(2 == s.size());
+        TEST_ASSERT(m1.empty());
+    }
+
+    return errorCount();
+}
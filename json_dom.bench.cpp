@@ -0,0 +1,184 @@
+/* json_dom.bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Benchmark of building and destroying a JSON DOM from a document of
+ * `iterations() / 64` records, reporting the time per node.  The rows are:
+ *
+ *     std_dom         `std::string`, `std::vector`, and `std::map` nodes on
+ *                     the global heap, every string copied
+ *     malloc_dom      `basic_json_value<std::allocator<char>>`: the same
+ *                     nodes and string views as the arena DOM, but on the
+ *                     global heap
+ *     arena_document  `pmr::json_document`: all nodes in one monotonic
+ *                     arena, destroyed by releasing the arena
+ *
+ * All three are built by `json_sax_parse`.  The `build` rows time parsing
+ * and building; the `destroy` rows time destroying the finished DOM.
+ */
+
+#include <json_dom.h>
+
+#include <bench.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Conventional DOM node that copies every string to the global heap.
+struct StdValue
+{
+    exp::json_type                   m_type = exp::json_type::null;
+    bool                             m_bool = false;
+    double                           m_number = 0.0;
+    std::string                      m_string;
+    std::vector<StdValue>            m_array;
+    std::map<std::string, StdValue>  m_object;
+};
+
+// Handler for `json_sax_parse` that builds a `StdValue` tree.
+class StdBuilder
+{
+    StdValue               m_root;
+    std::string            m_key;
+    std::vector<StdValue*> m_stack;
+
+    StdValue& add(exp::json_type t) {
+        StdValue* v = &m_root;
+        if (! m_stack.empty()) {
+            StdValue& parent = *m_stack.back();
+            if (exp::json_type::array == parent.m_type) {
+                parent.m_array.emplace_back();
+                v = &parent.m_array.back();
+            }
+            else
+                v = &parent.m_object[m_key];
+        }
+        v->m_type = t;
+        return *v;
+    }
+
+    static std::string copy(const char* first, const char* last,
+                            bool escaped) {
+        if (! escaped)
+            return std::string(first, last);
+        std::string s(exp::json_unescaped_size(first, last), '\0');
+        exp::json_unescape(first, last, &s[0]);
+        return s;
+    }
+
+public:
+    void null_value() { add(exp::json_type::null); }
+    void bool_value(bool b) { add(exp::json_type::boolean).m_bool = b; }
+    void number_value(double d)
+        { add(exp::json_type::number).m_number = d; }
+    void string_value(const char* first, const char* last, bool escaped)
+        { add(exp::json_type::string).m_string = copy(first, last, escaped); }
+    void key(const char* first, const char* last, bool escaped)
+        { m_key = copy(first, last, escaped); }
+    void start_array() { m_stack.push_back(&add(exp::json_type::array)); }
+    void end_array() { m_stack.pop_back(); }
+    void start_object() { m_stack.push_back(&add(exp::json_type::object)); }
+    void end_object() { m_stack.pop_back(); }
+
+    StdValue& root() { return m_root; }
+};
+
+// Handler for `json_sax_parse` that counts values.
+struct NodeCounter
+{
+    long m_nodes = 0;
+
+    void null_value() { ++m_nodes; }
+    void bool_value(bool) { ++m_nodes; }
+    void number_value(double) { ++m_nodes; }
+    void string_value(const char*, const char*, bool) { ++m_nodes; }
+    void key(const char*, const char*, bool) { }
+    void start_array() { ++m_nodes; }
+    void end_array() { }
+    void start_object() { ++m_nodes; }
+    void end_object() { }
+};
+
+// Return a JSON array of `n` records.
+std::string makeDocument(long n)
+{
+    std::string ret = "[";
+    for (long i = 0; i < n; ++i) {
+        const std::string id = std::to_string(i);
+        if (i)
+            ret += ",\n";
+        ret += "{\"id\": " + id + ", \"name\": \"user number " + id +
+               "\", \"active\": " + (i % 2 ? "true" : "false") +
+               ", \"score\": " + id + ".25, \"manager\": null"
+               ", \"tags\": [\"alpha\", \"beta\", \"gamma\", \"delta\"]"
+               ", \"address\": {\"street\": \"" + id + " Main Street\""
+               ", \"city\": \"Montr\\u00e9al\", \"zip\": \"H2X 1Y4\"}}";
+    }
+    return ret + "]";
+}
+
+int main(int argc, char *argv[])
+{
+    bench::parseArgs(argc, argv);
+    bench::printHeader();
+
+    const std::string text = makeDocument(bench::iterations() / 64);
+    const char* const first = text.data();
+    const char* const last = first + text.size();
+
+    NodeCounter counter;
+    exp::json_sax_parse(first, last, counter);
+    const long n = counter.m_nodes;
+
+    {
+        std::unique_ptr<StdBuilder> builder;
+        bench::runBatch("json_dom_build", "std_dom", n, [&]() {
+                builder.reset(new StdBuilder);
+                exp::json_sax_parse(first, last, *builder);
+                bench::doNotOptimize(builder->root());
+            }, [&]() { builder.reset(); });
+
+        builder.reset(new StdBuilder);
+        exp::json_sax_parse(first, last, *builder);
+        bench::runBatch("json_dom_destroy", "std_dom", n, [&]() {
+                builder.reset();
+            }, [&]() {
+                builder.reset(new StdBuilder);
+                exp::json_sax_parse(first, last, *builder);
+            });
+    }
+
+    {
+        typedef exp::basic_json_value<> Value;
+        std::allocator<char> a;
+        Value v;
+        bench::runBatch("json_dom_build", "malloc_dom", n, [&]() {
+                v = exp::json_parse(first, last, a);
+                bench::doNotOptimize(v);
+            }, [&]() { v.reset(); });
+
+        v = exp::json_parse(first, last, a);
+        bench::runBatch("json_dom_destroy", "malloc_dom", n, [&]() {
+                v.reset();
+            }, [&]() { v = exp::json_parse(first, last, a); });
+    }
+
+    {
+        pmr::json_document doc;
+        bench::runBatch("json_dom_build", "arena_document", n, [&]() {
+                bench::doNotOptimize(doc.parse(first, last));
+            }, [&]() { doc.clear(); });
+
+        doc.parse(first, last);
+        bench::runBatch("json_dom_destroy", "arena_document", n, [&]() {
+                doc.clear();
+            }, [&]() { doc.parse(first, last); });
+    }
+
+    return 0;
+}
@@ -0,0 +1,868 @@
+/* json_dom.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * A streaming (SAX-style) JSON parser and an allocator-aware JSON document
+ * object model built from its events by uses-allocator construction, with
+ * `pmr::json_document`, which holds a whole document in a monotonic arena
+ * (extension).
+ */
+
+#ifndef INCLUDED_JSON_DOM_DOT_H
+#define INCLUDED_JSON_DOM_DOT_H
+
+#include <alloc_vector.h>
+#include <memory_resource.h>
+#include <uses_allocator.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+// Exception thrown for malformed JSON text, recording the offset of the
+// offending character.
+class json_parse_error : public runtime_error
+{
+    size_t m_offset;
+
+public:
+    json_parse_error(const char* what, size_t offset)
+        : runtime_error(what), m_offset(offset) { }
+
+    size_t offset() const noexcept { return m_offset; }
+};
+
+// Non-owning view of a sequence of characters, used for JSON strings that
+// refer to the input text.
+class json_string
+{
+    const char* m_data;
+    size_t      m_size;
+
+public:
+    constexpr json_string() noexcept : m_data(""), m_size(0) { }
+    constexpr json_string(const char* data, size_t size) noexcept
+        : m_data(data), m_size(size) { }
+    json_string(const char* s) noexcept : m_data(s), m_size(strlen(s)) { }
+
+    constexpr const char* data() const noexcept { return m_data; }
+    constexpr size_t size() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return 0 == m_size; }
+    constexpr const char* begin() const noexcept { return m_data; }
+    constexpr const char* end() const noexcept { return m_data + m_size; }
+};
+
+inline bool operator==(json_string a, json_string b) noexcept
+{
+    return a.size() == b.size() &&
+           (a.empty() || 0 == memcmp(a.data(), b.data(), a.size()));
+}
+
+inline bool operator!=(json_string a, json_string b) noexcept
+{
+    return ! (a == b);
+}
+
+namespace internal {
+
+// Maximum nesting depth of arrays and objects accepted by the parser.
+constexpr int json_max_depth = 512;
+
+inline int json_hex_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9' ? c - '0' :
+           c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+           c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+// Return the code unit of the 4 hex digits at `p`.
+inline unsigned json_hex4(const char* p) noexcept
+{
+    return unsigned(json_hex_digit(p[0]) << 12 | json_hex_digit(p[1]) << 8 |
+                    json_hex_digit(p[2]) << 4 | json_hex_digit(p[3]));
+}
+
+// Decode the escape sequence at `p`, just after a backslash in the valid
+// JSON string text ending at `last`, to the code point `*cp`, and return
+// the position after it.  A surrogate pair is combined; a lone surrogate
+// becomes U+FFFD.
+inline const char* json_decode_escape(const char* p, const char* last,
+                                      unsigned* cp) noexcept
+{
+    switch (*p) {
+      case 'b': *cp = '\b'; return p + 1;
+      case 'f': *cp = '\f'; return p + 1;
+      case 'n': *cp = '\n'; return p + 1;
+      case 'r': *cp = '\r'; return p + 1;
+      case 't': *cp = '\t'; return p + 1;
+      case 'u': break;
+      default:  *cp = (unsigned char) *p; return p + 1;
+    }
+    unsigned u = json_hex4(p + 1);
+    p += 5;
+    if (u >= 0xd800 && u < 0xdc00 && last - p >= 6 && '\\' == p[0] &&
+        'u' == p[1]) {
+        const unsigned lo = json_hex4(p + 2);
+        if (lo >= 0xdc00 && lo < 0xe000) {
+            *cp = 0x10000 + ((u - 0xd800) << 10) + (lo - 0xdc00);
+            return p + 6;
+        }
+    }
+    *cp = u >= 0xd800 && u < 0xe000 ? 0xfffd : u;
+    return p;
+}
+
+// Return the number of bytes in the UTF-8 encoding of `cp`.
+inline size_t json_utf8_size(unsigned cp) noexcept
+{
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+inline char* json_utf8_encode(unsigned cp, char* out) noexcept
+{
+    if (cp < 0x80)
+        *out++ = char(cp);
+    else if (cp < 0x800) {
+        *out++ = char(0xc0 | cp >> 6);
+        *out++ = char(0x80 | (cp & 0x3f));
+    }
+    else if (cp < 0x10000) {
+        *out++ = char(0xe0 | cp >> 12);
+        *out++ = char(0x80 | (cp >> 6 & 0x3f));
+        *out++ = char(0x80 | (cp & 0x3f));
+    }
+    else {
+        *out++ = char(0xf0 | cp >> 18);
+        *out++ = char(0x80 | (cp >> 12 & 0x3f));
+        *out++ = char(0x80 | (cp >> 6 & 0x3f));
+        *out++ = char(0x80 | (cp & 0x3f));
+    }
+    return out;
+}
+
+// Recursive-descent JSON parser reporting each value to a `Handler` (see
+// `json_sax_parse`).
+template <class Handler>
+class json_parser
+{
+    const char* m_first;
+    const char* m_cur;
+    const char* m_last;
+    Handler&    m_handler;
+    int         m_depth;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw json_parse_error(what, size_t(m_cur - m_first));
+    }
+
+    void skip_ws() noexcept {
+        while (m_cur != m_last && (' ' == *m_cur || '\n' == *m_cur ||
+                                   '\r' == *m_cur || '\t' == *m_cur))
+            ++m_cur;
+    }
+
+    void expect_literal(const char* lit, size_t n) {
+        if (size_t(m_last - m_cur) < n || 0 != memcmp(m_cur, lit, n))
+            fail("invalid literal");
+        m_cur += n;
+    }
+
+    // Scan the string starting at the opening quote, setting `*first` and
+    // `*last` to its contents and returning true if it contains escapes.
+    bool scan_string(const char** first, const char** last) {
+        bool escaped = false;
+        *first = ++m_cur;
+        for (;;) {
+            if (m_cur == m_last)
+                fail("unterminated string");
+            const char c = *m_cur;
+            if ('"' == c)
+                break;
+            if ((unsigned char) c < 0x20)
+                fail("control character in string");
+            if ('\\' == c) {
+                escaped = true;
+                if (++m_cur == m_last)
+                    fail("unterminated string");
+                if ('u' == *m_cur) {
+                    if (m_last - m_cur < 5)
+                        fail("invalid escape");
+                    for (int i = 1; i <= 4; ++i)
+                        if (json_hex_digit(m_cur[i]) < 0)
+                            fail("invalid escape");
+                    m_cur += 4;
+                }
+                else if (! *m_cur || ! strchr("\"\\/bfnrt", *m_cur))
+                    fail("invalid escape");
+            }
+            ++m_cur;
+        }
+        *last = m_cur++;
+        return escaped;
+    }
+
+    void scan_digits() {
+        if (m_cur == m_last || *m_cur < '0' || *m_cur > '9')
+            fail("invalid number");
+        while (m_cur != m_last && *m_cur >= '0' && *m_cur <= '9')
+            ++m_cur;
+    }
+
+    void parse_number() {
+        const char* first = m_cur;
+        if ('-' == *m_cur)
+            ++m_cur;
+        if (m_cur != m_last && '0' == *m_cur)
+            ++m_cur;
+        else
+            scan_digits();
+        if (m_cur != m_last && '.' == *m_cur) {
+            ++m_cur;
+            scan_digits();
+        }
+        if (m_cur != m_last && ('e' == *m_cur || 'E' == *m_cur)) {
+            ++m_cur;
+            if (m_cur != m_last && ('+' == *m_cur || '-' == *m_cur))
+                ++m_cur;
+            scan_digits();
+        }
+
+        // `strtod` needs a null-terminated copy.
+        const size_t n = size_t(m_cur - first);
+        char buf[64];
+        if (n < sizeof(buf)) {
+            memcpy(buf, first, n);
+            buf[n] = '\0';
+            m_handler.number_value(strtod(buf, nullptr));
+        }
+        else
+            m_handler.number_value(strtod(string(first, n).c_str(),
+                                          nullptr));
+    }
+
+    void parse_array() {
+        ++m_cur;
+        m_handler.start_array();
+        skip_ws();
+        if (m_cur != m_last && ']' == *m_cur)
+            ++m_cur;
+        else {
+            for (;;) {
+                parse_value();
+                skip_ws();
+                if (m_cur == m_last)
+                    fail("unterminated array");
+                if (']' == *m_cur++)
+                    break;
+                if (',' != m_cur[-1]) {
+                    --m_cur;
+                    fail("expected ',' or ']'");
+                }
+            }
+        }
+        m_handler.end_array();
+    }
+
+    void parse_object() {
+        ++m_cur;
+        m_handler.start_object();
+        skip_ws();
+        if (m_cur != m_last && '}' == *m_cur)
+            ++m_cur;
+        else {
+            for (;;) {
+                skip_ws();
+                if (m_cur == m_last || '"' != *m_cur)
+                    fail("expected string key");
+                const char *first, *last;
+                const bool escaped = scan_string(&first, &last);
+                m_handler.key(first, last, escaped);
+                skip_ws();
+                if (m_cur == m_last || ':' != *m_cur)
+                    fail("expected ':'");
+                ++m_cur;
+                parse_value();
+                skip_ws();
+                if (m_cur == m_last)
+                    fail("unterminated object");
+                if ('}' == *m_cur++)
+                    break;
+                if (',' != m_cur[-1]) {
+                    --m_cur;
+                    fail("expected ',' or '}'");
+                }
+            }
+        }
+        m_handler.end_object();
+    }
+
+    void parse_value() {
+        skip_ws();
+        if (m_cur == m_last)
+            fail("expected value");
+        switch (*m_cur) {
+          case '{':
+          case '[':
+            if (++m_depth > json_max_depth)
+                fail("nesting too deep");
+            if ('{' == *m_cur)
+                parse_object();
+            else
+                parse_array();
+            --m_depth;
+            break;
+          case '"': {
+            const char *first, *last;
+            const bool escaped = scan_string(&first, &last);
+            m_handler.string_value(first, last, escaped);
+            break;
+          }
+          case 't':
+            expect_literal("true", 4);
+            m_handler.bool_value(true);
+            break;
+          case 'f':
+            expect_literal("false", 5);
+            m_handler.bool_value(false);
+            break;
+          case 'n':
+            expect_literal("null", 4);
+            m_handler.null_value();
+            break;
+          default:
+            if ('-' != *m_cur && (*m_cur < '0' || *m_cur > '9'))
+                fail("expected value");
+            parse_number();
+        }
+    }
+
+public:
+    json_parser(const char* first, const char* last, Handler& h) noexcept
+        : m_first(first), m_cur(first), m_last(last), m_handler(h)
+        , m_depth(0) { }
+
+    void parse() {
+        parse_value();
+        skip_ws();
+        if (m_cur != m_last)
+            fail("unexpected text after value");
+    }
+};
+
+} // close namespace internal
+
+// Return the number of bytes to which the valid JSON string text
+// `[first, last)` (without quotes) decodes.
+inline size_t json_unescaped_size(const char* first, const char* last)
+    noexcept
+{
+    size_t n = 0;
+    while (first != last) {
+        if ('\\' == *first) {
+            unsigned cp;
+            first = internal::json_decode_escape(first + 1, last, &cp);
+            n += internal::json_utf8_size(cp);
+        }
+        else {
+            ++first;
+            ++n;
+        }
+    }
+    return n;
+}
+
+// Decode the valid JSON string text `[first, last)` (without quotes) to
+// UTF-8 at `out` and return the end of the output, which is never longer
+// than the input.
+inline char* json_unescape(const char* first, const char* last, char* out)
+    noexcept
+{
+    while (first != last) {
+        if ('\\' == *first) {
+            unsigned cp;
+            first = internal::json_decode_escape(first + 1, last, &cp);
+            out = internal::json_utf8_encode(cp, out);
+        }
+        else
+            *out++ = *first++;
+    }
+    return out;
+}
+
+// Parse the JSON text `[first, last)`, calling members of `handler` for
+// each value in document order:
+//
+//     null_value()                       `null`
+//     bool_value(bool)                   `true` or `false`
+//     number_value(double)               a number
+//     string_value(const char* first,    a string; `[first, last)` is the
+//                  const char* last,     text between the quotes, which
+//                  bool escaped)         needs `json_unescape` if `escaped`
+//     key(first, last, escaped)          an object member's name
+//     start_array(), end_array()         around an array's elements
+//     start_object(), end_object()       around an object's members
+//
+// Throw `json_parse_error` if the text is not a single valid JSON value
+// (with optional surrounding whitespace); the handler may have received
+// some events by then.
+template <class Handler>
+void json_sax_parse(const char* first, const char* last, Handler& handler)
+{
+    internal::json_parser<Handler>(first, last, handler).parse();
+}
+
+enum class json_type { null, boolean, number, string, array, object };
+
+// Tag selecting the `basic_json_value` constructor that decodes escaped
+// JSON string text.
+struct json_escaped_t { explicit json_escaped_t() = default; };
+constexpr json_escaped_t json_escaped{};
+
+// A JSON value whose arrays, objects, and decoded strings use memory from
+// `Alloc`.  Strings without escapes are `json_string` views of the input
+// text, which must outlive the value; strings with escapes are decoded into
+// storage from the allocator.  Objects are vectors of name/value pairs, in
+// document order, searched linearly by `find`.  Values are allocator-aware,
+// so the elements of arrays and objects, including both members of each
+// object pair, get the container's allocator by uses-allocator
+// construction.  As with other allocator-aware types, the allocator is not
+// propagated on assignment.
+template <class Alloc = allocator<char>>
+class basic_json_value
+{
+    typedef allocator_traits<Alloc>                         AT;
+    typedef typename AT::template rebind_alloc<char>        char_alloc;
+    typedef allocator_traits<char_alloc>                    char_traits;
+
+public:
+    typedef Alloc                                           allocator_type;
+    typedef alloc_vector<basic_json_value,
+                typename AT::template rebind_alloc<basic_json_value>>
+        array_type;
+    typedef pair<basic_json_value, basic_json_value>        member_type;
+    typedef alloc_vector<member_type,
+                typename AT::template rebind_alloc<member_type>>
+        object_type;
+
+private:
+    allocator_type m_alloc;
+    json_type      m_type;
+    bool           m_owned;   // `m_string` was allocated from `m_alloc`
+    union {
+        bool        m_bool;
+        double      m_number;
+        json_string m_string;
+        array_type  m_array;
+        object_type m_object;
+    };
+
+    // Copy the `n` characters at `s` to storage from the allocator.
+    void copy_string(const char* s, size_t n) {
+        char_alloc ca(m_alloc);
+        char* p = n ? char_traits::allocate(ca, n) : nullptr;
+        if (n)
+            memcpy(p, s, n);
+        m_string = json_string(p ? p : "", n);
+        m_owned = p != nullptr;
+    }
+
+    // Copy the value of `other`, using this value's allocator.
+    void copy_from(const basic_json_value& other) {
+        switch (other.m_type) {
+          case json_type::null:    break;
+          case json_type::boolean: m_bool = other.m_bool; break;
+          case json_type::number:  m_number = other.m_number; break;
+          case json_type::string:
+            if (other.m_owned)
+                copy_string(other.m_string.data(), other.m_string.size());
+            else
+                m_string = other.m_string;
+            break;
+          case json_type::array:
+            ::new(static_cast<void*>(&m_array))
+                array_type(other.m_array, m_alloc);
+            break;
+          case json_type::object:
+            ::new(static_cast<void*>(&m_object))
+                object_type(other.m_object, m_alloc);
+            break;
+        }
+        m_type = other.m_type;
+    }
+
+    // Take over the value of `other`, which has an equal allocator, leaving
+    // it null.
+    void steal(basic_json_value& other) noexcept {
+        switch (other.m_type) {
+          case json_type::array:
+            ::new(static_cast<void*>(&m_array))
+                array_type(std::move(other.m_array));
+            break;
+          case json_type::object:
+            ::new(static_cast<void*>(&m_object))
+                object_type(std::move(other.m_object));
+            break;
+          case json_type::boolean: m_bool = other.m_bool; break;
+          case json_type::number:  m_number = other.m_number; break;
+          case json_type::string:  m_string = other.m_string; break;
+          case json_type::null:    break;
+        }
+        m_type = other.m_type;
+        m_owned = other.m_owned;
+        other.m_owned = false;
+        other.reset();
+    }
+
+    void destroy() noexcept {
+        switch (m_type) {
+          case json_type::string:
+            if (m_owned) {
+                char_alloc ca(m_alloc);
+                char_traits::deallocate(ca, const_cast<char*>(
+                                            m_string.data()),
+                                        m_string.size());
+            }
+            break;
+          case json_type::array:  m_array.~array_type(); break;
+          case json_type::object: m_object.~object_type(); break;
+          default: break;
+        }
+    }
+
+public:
+    basic_json_value() noexcept(noexcept(Alloc()))
+        : basic_json_value(Alloc()) { }
+
+    explicit basic_json_value(const Alloc& a) noexcept
+        : m_alloc(a), m_type(json_type::null), m_owned(false) { }
+
+    basic_json_value(nullptr_t, const Alloc& a = Alloc()) noexcept
+        : basic_json_value(a) { }
+
+    // Only an actual `bool`, so that a pointer is not converted to one and
+    // an integer is unambiguously a number.
+    template <class B, class = enable_if_t<is_same<B, bool>::value>>
+    basic_json_value(B b, const Alloc& a = Alloc()) noexcept
+        : m_alloc(a), m_type(json_type::boolean), m_owned(false), m_bool(b)
+        { }
+
+    basic_json_value(double d, const Alloc& a = Alloc()) noexcept
+        : m_alloc(a), m_type(json_type::number), m_owned(false), m_number(d)
+        { }
+
+    // A string that refers to the characters of `s` without copying them.
+    basic_json_value(json_string s, const Alloc& a = Alloc()) noexcept
+        : m_alloc(a), m_type(json_type::string), m_owned(false), m_string(s)
+        { }
+
+    // A string that refers to the null-terminated `s` without copying it.
+    basic_json_value(const char* s, const Alloc& a = Alloc()) noexcept
+        : basic_json_value(json_string(s), a) { }
+
+    // A string decoded from the valid, escaped JSON string text
+    // `[first, last)` into storage from `a`.
+    basic_json_value(json_escaped_t, const char* first, const char* last,
+                     const Alloc& a = Alloc())
+        : m_alloc(a), m_type(json_type::string), m_owned(false), m_string()
+    {
+        const size_t n = json_unescaped_size(first, last);
+        if (n) {
+            char_alloc ca(m_alloc);
+            char* p = char_traits::allocate(ca, n);
+            json_unescape(first, last, p);
+            m_string = json_string(p, n);
+            m_owned = true;
+        }
+    }
+
+    // An empty array or object, or a default value of type `t`.
+    basic_json_value(json_type t, const Alloc& a = Alloc())
+        : m_alloc(a), m_type(json_type::null), m_owned(false)
+    {
+        switch (t) {
+          case json_type::boolean: m_bool = false; break;
+          case json_type::number:  m_number = 0.0; break;
+          case json_type::string:  m_string = json_string(); break;
+          case json_type::array:
+            ::new(static_cast<void*>(&m_array)) array_type(m_alloc);
+            break;
+          case json_type::object:
+            ::new(static_cast<void*>(&m_object)) object_type(m_alloc);
+            break;
+          default: break;
+        }
+        m_type = t;
+    }
+
+    basic_json_value(const basic_json_value& other)
+        : basic_json_value(other,
+                           AT::select_on_container_copy_construction(
+                               other.m_alloc)) { }
+
+    basic_json_value(const basic_json_value& other, const Alloc& a)
+        : m_alloc(a), m_type(json_type::null), m_owned(false)
+        { copy_from(other); }
+
+    basic_json_value(basic_json_value&& other) noexcept
+        : m_alloc(other.m_alloc), m_type(json_type::null), m_owned(false)
+        { steal(other); }
+
+    basic_json_value(basic_json_value&& other, const Alloc& a)
+        : m_alloc(a), m_type(json_type::null), m_owned(false)
+    {
+        if (m_alloc == other.m_alloc)
+            steal(other);
+        else
+            copy_from(other);
+    }
+
+    ~basic_json_value() { destroy(); }
+
+    basic_json_value& operator=(const basic_json_value& rhs) {
+        if (this != &rhs) {
+            basic_json_value tmp(rhs, m_alloc);
+            reset();
+            steal(tmp);
+        }
+        return *this;
+    }
+
+    basic_json_value& operator=(basic_json_value&& rhs) {
+        if (this != &rhs) {
+            basic_json_value tmp(std::move(rhs), m_alloc);
+            reset();
+            steal(tmp);
+        }
+        return *this;
+    }
+
+    // Make this value null.
+    void reset() noexcept {
+        destroy();
+        m_type = json_type::null;
+        m_owned = false;
+    }
+
+    json_type type() const noexcept { return m_type; }
+    bool is_null() const noexcept { return json_type::null == m_type; }
+
+    // Accessors; the value must have the corresponding type.
+    bool as_bool() const noexcept { return m_bool; }
+    double as_number() const noexcept { return m_number; }
+    json_string as_string() const noexcept { return m_string; }
+    array_type& as_array() noexcept { return m_array; }
+    const array_type& as_array() const noexcept { return m_array; }
+    object_type& as_object() noexcept { return m_object; }
+    const object_type& as_object() const noexcept { return m_object; }
+
+    // Return the number of elements of an array or members of an object,
+    // and 0 for other values.
+    size_t size() const noexcept {
+        return json_type::array == m_type ? m_array.size() :
+               json_type::object == m_type ? m_object.size() : 0;
+    }
+
+    // Return the element at index `i` of an array, which must exist.
+    const basic_json_value& operator[](size_t i) const { return m_array[i]; }
+
+    // Return the value of the first member of an object named `name`, or
+    // null if this is not an object or has no such member.
+    const basic_json_value* find(json_string name) const noexcept {
+        if (json_type::object != m_type)
+            return nullptr;
+        for (const member_type& m : m_object)
+            if (m.first.m_string == name)
+                return &m.second;
+        return nullptr;
+    }
+
+    allocator_type get_allocator() const noexcept { return m_alloc; }
+};
+
+// A value holds only its allocator and pointers into memory that it owns.
+template <class Alloc>
+struct is_trivially_relocatable<basic_json_value<Alloc>>
+    : internal::boolean_constant<
+          is_trivially_copy_constructible<Alloc>::value &&
+          is_trivially_destructible<Alloc>::value> { };
+
+template <class Alloc>
+struct is_trivially_relocatable<pair<basic_json_value<Alloc>,
+                                     basic_json_value<Alloc>>>
+    : is_trivially_relocatable<basic_json_value<Alloc>> { };
+
+// Handler for `json_sax_parse` that builds a `basic_json_value<Alloc>`
+// tree, every node of which uses the builder's allocator.  The root is
+// created by `make_obj_using_allocator` and each element or member by
+// uses-allocator construction in place at the end of its parent, so no
+// node is moved or copied once made (apart from relocation when a parent
+// grows).  Strings without escapes remain views of the input.
+template <class Alloc = allocator<char>>
+class basic_json_builder
+{
+public:
+    typedef basic_json_value<Alloc> value_type;
+    typedef Alloc                   allocator_type;
+
+private:
+    allocator_type           m_alloc;
+    value_type               m_root;
+    value_type               m_key;     // Name of the next object member
+    vector<value_type*>      m_stack;   // Open arrays and objects
+    bool                     m_done;
+
+    template <class... Args>
+    value_type& add(Args&&... args) {
+        if (m_stack.empty()) {
+            m_root = Cpp20::make_obj_using_allocator<value_type>(
+                m_alloc, std::forward<Args>(args)...);
+            m_done = true;
+            return m_root;
+        }
+        value_type& parent = *m_stack.back();
+        if (json_type::array == parent.type())
+            return parent.as_array().emplace_back(
+                std::forward<Args>(args)...);
+        return parent.as_object().emplace_back(
+            piecewise_construct, forward_as_tuple(std::move(m_key)),
+            forward_as_tuple(std::forward<Args>(args)...)).second;
+    }
+
+    void add_string(const char* first, const char* last, bool escaped) {
+        if (escaped)
+            add(json_escaped, first, last);
+        else
+            add(json_string(first, size_t(last - first)));
+    }
+
+public:
+    explicit basic_json_builder(const Alloc& a = Alloc())
+        : m_alloc(a), m_root(a), m_key(a), m_done(false) { }
+
+    void null_value() { add(nullptr); }
+    void bool_value(bool b) { add(b); }
+    void number_value(double d) { add(d); }
+    void string_value(const char* first, const char* last, bool escaped)
+        { add_string(first, last, escaped); }
+
+    void key(const char* first, const char* last, bool escaped) {
+        if (escaped)
+            m_key = value_type(json_escaped, first, last, m_alloc);
+        else
+            m_key = value_type(json_string(first, size_t(last - first)),
+                               m_alloc);
+    }
+
+    void start_array() { m_stack.push_back(&add(json_type::array)); }
+    void end_array() { m_stack.pop_back(); }
+    void start_object() { m_stack.push_back(&add(json_type::object)); }
+    void end_object() { m_stack.pop_back(); }
+
+    // Return true if a complete value has been built.
+    bool done() const noexcept { return m_done && m_stack.empty(); }
+
+    // Return the value built so far.
+    value_type& root() noexcept { return m_root; }
+};
+
+// Parse the JSON text `[first, last)` into a value that uses allocator `a`.
+// Strings without escapes refer to the input text, which must outlive the
+// result.  Throw `json_parse_error` if the text is not valid JSON.
+template <class Alloc>
+basic_json_value<Alloc> json_parse(const char* first, const char* last,
+                                   const Alloc& a)
+{
+    basic_json_builder<Alloc> builder(a);
+    json_sax_parse(first, last, builder);
+    return std::move(builder.root());
+}
+
+} // close namespace Cpp20
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+typedef basic_json_value<polymorphic_allocator<>>   json_value;
+typedef basic_json_builder<polymorphic_allocator<>> json_builder;
+
+// A parsed JSON document, all of whose nodes (and decoded strings) are
+// allocated from one `monotonic_buffer_resource` owned by the document.
+// Since the tree holds nothing but memory from the arena, node destructors
+// are never run: destroying or re-parsing a document is a single release of
+// the arena.  Strings without escapes refer to the input text, which must
+// outlive the document's use of them.
+class json_document
+{
+    monotonic_buffer_resource m_arena;
+    json_value*               m_root;
+
+public:
+    explicit json_document(memory_resource* upstream = get_default_resource())
+        : m_arena(upstream), m_root(nullptr) { }
+
+    json_document(size_t initial_size,
+                  memory_resource* upstream = get_default_resource())
+        : m_arena(initial_size, upstream), m_root(nullptr) { }
+
+    json_document(const json_document&) = delete;
+    json_document& operator=(const json_document&) = delete;
+
+    // Replace the contents with the value parsed from `[first, last)` and
+    // return it.  Throw `json_parse_error` if the text is not valid JSON,
+    // leaving the document empty.
+    const json_value& parse(const char* first, const char* last) {
+        clear();
+        polymorphic_allocator<json_value> a(&m_arena);
+        try {
+            // A partial tree is destroyed with the builder, before the
+            // arena is released.
+            json_builder builder(a);
+            json_sax_parse(first, last, builder);
+            json_value* p = a.allocate(1);
+            Cpp20::uninitialized_construct_using_allocator(
+                p, a, std::move(builder.root()));
+            m_root = p;
+        }
+        catch (...) {
+            clear();
+            throw;
+        }
+        return *m_root;
+    }
+
+    const json_value& parse(const char* s) {
+        return parse(s, s + strlen(s));
+    }
+
+    // Discard the contents, returning all memory to the arena's upstream
+    // resource.
+    void clear() noexcept {
+        m_root = nullptr;
+        m_arena.release();
+    }
+
+    bool empty() const noexcept { return ! m_root; }
+
+    // Return the root value, which must exist.
+    const json_value& root() const noexcept { return *m_root; }
+
+    memory_resource* resource() noexcept { return &m_arena; }
+};
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_JSON_DOM_DOT_H)
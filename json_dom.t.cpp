@@ -0,0 +1,237 @@
+/* json_dom.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <json_dom.h>
+
+#include <stats_resource.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Handler that records the events of `json_sax_parse` as a string.
+struct Recorder
+{
+    std::string m_events;
+
+    void null_value() { m_events += "n "; }
+    void bool_value(bool b) { m_events += b ? "t " : "f "; }
+    void number_value(double d) {
+        m_events += std::to_string(static_cast<long>(d)) + ' ';
+    }
+    void string_value(const char* first, const char* last, bool escaped) {
+        m_events += (escaped ? "S:" : "s:") + std::string(first, last) + ' ';
+    }
+    void key(const char* first, const char* last, bool) {
+        m_events += "k:" + std::string(first, last) + ' ';
+    }
+    void start_array() { m_events += "[ "; }
+    void end_array() { m_events += "] "; }
+    void start_object() { m_events += "{ "; }
+    void end_object() { m_events += "} "; }
+};
+
+// Return the offset reported for the invalid JSON text `s`, or -1 if it
+// parses.
+long errorOffset(const char* s)
+{
+    Recorder r;
+    try {
+        exp::json_sax_parse(s, s + std::strlen(s), r);
+    }
+    catch (exp::json_parse_error& e) {
+        return static_cast<long>(e.offset());
+    }
+    return -1;
+}
+
+const char k_text[] =
+    " {\"name\": \"widget\", \"tags\": [\"a\", \"b\\tc\"], \"n\": -12.5e1,"
+    "  \"ok\": true, \"none\": null, \"nested\": {\"k\\u00e9y\": [[], {}]}} ";
+
+int main()
+{
+    // SAX events
+    {
+        Recorder r;
+        const char s[] = "[1, \"x\", {\"a\": false, \"b\\\"\": null}, []]";
+        exp::json_sax_parse(s, s + sizeof(s) - 1, r);
+        TEST_ASSERT("[ 1 s:x { k:a f k:b\\\" n } [ ] ] " == r.m_events);
+    }
+
+    // Malformed text
+    {
+        TEST_ASSERT(-1 == errorOffset(" 0 "));
+        TEST_ASSERT(0 == errorOffset(""));
+        TEST_ASSERT(3 == errorOffset("[1 2]"));
+        TEST_ASSERT(2 == errorOffset("[]]"));
+        TEST_ASSERT(1 == errorOffset("01"));
+        TEST_ASSERT(1 == errorOffset("-."));
+        TEST_ASSERT(0 == errorOffset("tru"));
+        TEST_ASSERT(2 == errorOffset("\"\\x\""));
+        TEST_ASSERT(2 == errorOffset("\"\\u12g4\""));
+        TEST_ASSERT(4 == errorOffset("\"abc"));
+        TEST_ASSERT(1 == errorOffset("{1: 2}"));
+        TEST_ASSERT(5 == errorOffset("{\"a\" 2}"));
+        TEST_ASSERT(8 == errorOffset("{\"a\": 2 ]"));
+        TEST_ASSERT(3 == errorOffset("[1,]"));
+        TEST_ASSERT(-1 == errorOffset(std::string(512, '[').append(512, ']')
+                                      .c_str()));
+        TEST_ASSERT(512 == errorOffset(std::string(513, '[')
+                                       .append(513, ']').c_str()));
+    }
+
+    // Unescaping, including surrogate pairs and lone surrogates
+    {
+        const char s[] = "a\\n\\u00e9\\ud83d\\ude00\\/\\ud800x";
+        const char expected[] = "a\n\xc3\xa9\xf0\x9f\x98\x80/\xef\xbf\xbdx";
+        const std::size_t n = exp::json_unescaped_size(s, s + sizeof(s) - 1);
+        TEST_ASSERT(sizeof(expected) - 1 == n);
+        char out[sizeof(s)];
+        TEST_ASSERT(out + n == exp::json_unescape(s, s + sizeof(s) - 1, out));
+        TEST_ASSERT(0 == std::memcmp(expected, out, n));
+    }
+
+    // DOM: every node and decoded string uses the value's allocator, and
+    // strings without escapes refer to the input
+    {
+        pmr::stats_resource sr;
+        {
+            const char* const first = k_text;
+            const char* const last = k_text + sizeof(k_text) - 1;
+            pmr::json_value v = exp::json_parse(
+                first, last, pmr::polymorphic_allocator<>(&sr));
+            TEST_ASSERT(exp::json_type::object == v.type());
+            TEST_ASSERT(&sr == v.get_allocator().resource());
+            TEST_ASSERT(6 == v.size());
+
+            const pmr::json_value* name = v.find("name");
+            TEST_ASSERT(name && "widget" == name->as_string());
+            TEST_ASSERT(name->as_string().data() > first &&
+                        name->as_string().data() < last);
+
+            const pmr::json_value& tags = *v.find("tags");
+            TEST_ASSERT(2 == tags.size());
+            TEST_ASSERT(&sr == tags.as_array().get_allocator().resource());
+            TEST_ASSERT("a" == tags[0].as_string());
+            TEST_ASSERT("b\tc" == tags[1].as_string());
+            TEST_ASSERT(tags[1].as_string().data() < first ||
+                        tags[1].as_string().data() >= last);
+
+            TEST_ASSERT(-125.0 == v.find("n")->as_number());
+            TEST_ASSERT(v.find("ok")->as_bool());
+            TEST_ASSERT(v.find("none")->is_null());
+            TEST_ASSERT(! v.find("missing"));
+
+            const pmr::json_value& nested = *v.find("nested");
+            const pmr::json_value* inner = nested.find("k\xc3\xa9y");
+            TEST_ASSERT(inner && 2 == inner->size());
+            TEST_ASSERT(&sr == nested.as_object()[0].first.get_allocator()
+                               .resource());
+            TEST_ASSERT(&sr == (*inner)[1].get_allocator().resource());
+            TEST_ASSERT(exp::json_type::array == (*inner)[0].type());
+            TEST_ASSERT(exp::json_type::object == (*inner)[1].type());
+
+            // Copies use their own allocator; views remain views
+            pmr::stats_resource sr2;
+            pmr::json_value c(v, pmr::polymorphic_allocator<>(&sr2));
+            TEST_ASSERT(&sr2 == c.find("tags")->as_array().get_allocator()
+                                .resource());
+            TEST_ASSERT(name->as_string().data() ==
+                        c.find("name")->as_string().data());
+            TEST_ASSERT("b\tc" == (*c.find("tags"))[1].as_string());
+            TEST_ASSERT((*c.find("tags"))[1].as_string().data() !=
+                        tags[1].as_string().data());
+            TEST_ASSERT(0 < sr2.snapshot().live_bytes);
+
+            c = *v.find("tags");
+            TEST_ASSERT(&sr2 == c.as_array().get_allocator().resource());
+            TEST_ASSERT(2 == c.size());
+            c.reset();
+            TEST_ASSERT(0 == sr2.snapshot().live_bytes);
+        }
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    // Scalar constructors: a string literal is a string, an integer is a
+    // number, and only a `bool` is a boolean
+    {
+        const char* const hello = "hello";
+        pmr::json_value s(hello);
+        TEST_ASSERT(exp::json_type::string == s.type());
+        TEST_ASSERT("hello" == s.as_string());
+        TEST_ASSERT(hello == s.as_string().data());
+
+        pmr::json_value l("hi");
+        TEST_ASSERT(exp::json_type::string == l.type());
+        TEST_ASSERT("hi" == l.as_string());
+
+        pmr::json_value n(5);
+        TEST_ASSERT(exp::json_type::number == n.type());
+        TEST_ASSERT(5.0 == n.as_number());
+
+        pmr::json_value b(true);
+        TEST_ASSERT(exp::json_type::boolean == b.type());
+        TEST_ASSERT(b.as_bool());
+
+        pmr::stats_resource sr;
+        pmr::json_value a("x", pmr::polymorphic_allocator<>(&sr));
+        TEST_ASSERT(&sr == a.get_allocator().resource());
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    // DOM on `std::allocator`
+    {
+        const char s[] = "[\"\\u0041\", [1, 2, 3], {\"x\": \"y\"}]";
+        exp::basic_json_value<> v = exp::json_parse(s, s + sizeof(s) - 1,
+                                                    std::allocator<char>());
+        TEST_ASSERT(3 == v.size());
+        TEST_ASSERT("A" == v[0].as_string());
+        TEST_ASSERT(3.0 == v[1][2].as_number());
+        TEST_ASSERT("y" == v[2].find("x")->as_string());
+
+        exp::basic_json_value<> w(std::move(v));
+        TEST_ASSERT(v.is_null());
+        TEST_ASSERT(3 == w.size());
+    }
+
+    // Document: nodes come from the arena, and clearing releases it
+    {
+        pmr::stats_resource sr;
+        pmr::json_document doc(&sr);
+        TEST_ASSERT(doc.empty());
+
+        const pmr::json_value& root = doc.parse(k_text);
+        TEST_ASSERT(! doc.empty());
+        TEST_ASSERT(&root == &doc.root());
+        TEST_ASSERT(doc.resource() == root.get_allocator().resource());
+        TEST_ASSERT("b\tc" == (*root.find("tags"))[1].as_string());
+        TEST_ASSERT(0 < sr.snapshot().live_bytes);
+
+        doc.clear();
+        TEST_ASSERT(doc.empty());
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+
+        // A failed parse leaves the document empty
+        int caught = 0;
+        try {
+            doc.parse("[{\"a\": [1, 2, \"\\u00e9\"]}, tru]");
+        }
+        catch (exp::json_parse_error&) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+        TEST_ASSERT(doc.empty());
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+
+        TEST_ASSERT(4.0 == doc.parse("[4]")[0].as_number());
+    }
+
+    return errorCount();
+}
@@ -10,56 +10,106 @@
 #include <utility>
 #include <tuple>
 #include <cstdlib>
+#include <memory>
+
+// Expands to `constexpr` in C++20 and later, where objects can be
+// constructed in place during constant evaluation with `std::construct_at`,
+// and to nothing otherwise.
+#if __cplusplus > 201703L
+#define CPP20_CONSTEXPR constexpr
+#else
+#define CPP20_CONSTEXPR
+#endif
 
 namespace std {
 
 inline namespace Cpp17 {
 
+#if __cplusplus < 201703L
 template <class...> struct void_t_imp { typedef void type; };
 template <class... T> using void_t = typename void_t_imp<T...>::type;
 
+enum class byte : unsigned char { };
+#endif
+
 namespace internal {
 
+template <class T, class Tuple, class Indexes>
+struct is_nothrow_constructible_from_tuple_imp;
+
+template <class T, class Tuple, size_t... Indexes>
+struct is_nothrow_constructible_from_tuple_imp<T, Tuple,
+                                               index_sequence<Indexes...>>
+    : is_nothrow_constructible<T,
+                       decltype(get<Indexes>(std::declval<Tuple>()))...>
+{
+};
+
+// True if constructing a `T` from the elements of a tuple of type `Tuple`
+// (as an rvalue unless `Tuple` is an lvalue reference) cannot throw.
+template <class T, class Tuple>
+using is_nothrow_constructible_from_tuple =
+    is_nothrow_constructible_from_tuple_imp<T, Tuple,
+                   make_index_sequence<tuple_size<decay_t<Tuple>>::value>>;
+
+#if __cplusplus < 201703L
 template <class F, class Tuple, size_t... I>
-constexpr decltype(auto) apply_impl(F&& f, Tuple&& t, index_sequence<I...>) {
+constexpr decltype(auto) apply_impl(F&& f, Tuple&& t, index_sequence<I...>)
+    noexcept(noexcept(std::forward<F>(f)(
+                          std::get<I>(std::forward<Tuple>(t))...))) {
     // TBD: This should be a call to `invoke()`
     return std::forward<F>(f)(std::get<I>(std::forward<Tuple>(t))...);
 }
 
 template <class T, class Tuple, size_t... Indexes>
 T make_from_tuple_imp(Tuple&& t, index_sequence<Indexes...>)
+    noexcept(is_nothrow_constructible_from_tuple<T, Tuple>::value)
 {
     return T(get<Indexes>(forward<Tuple>(t))...);
 }
+#endif
 
-#if 0
 template <class T, class Tuple, size_t... Indexes>
-T* uninitialized_construct_from_tuple_imp(T* p, Tuple&& t,
-                                          index_sequence<Indexes...>)
+CPP20_CONSTEXPR T* uninitialized_construct_from_tuple_imp(T* p, Tuple&& t,
+                                                  index_sequence<Indexes...>)
+    noexcept(is_nothrow_constructible_from_tuple<T, Tuple>::value)
 {
+#if __cplusplus > 201703L
+    return std::construct_at(p, get<Indexes>(std::forward<Tuple>(t))...);
+#else
     return ::new((void*) p) T(get<Indexes>(std::forward<Tuple>(t))...);
-}
 #endif
+}
 
 } // close namespace namespace Cpp20::internal
 
+// `apply` and `make_from_tuple` are provided by the standard library in
+// C++17 and later (where both are `constexpr`).  As there, each is
+// `noexcept` if the call or constructor it makes is.
+#if __cplusplus < 201703L
 template <class F, class Tuple>
-constexpr decltype(auto) apply(F&& f, Tuple&& t) {
+constexpr decltype(auto) apply(F&& f, Tuple&& t)
+    noexcept(noexcept(internal::apply_impl(std::forward<F>(f),
+                                           std::forward<Tuple>(t),
+                 make_index_sequence<tuple_size<decay_t<Tuple>>::value>{}))) {
     return internal::apply_impl(std::forward<F>(f), std::forward<Tuple>(t),
                     make_index_sequence<tuple_size<decay_t<Tuple>>::value>{});
 }
 
 template <class T, class Tuple>
 T make_from_tuple(Tuple&& args_tuple)
+    noexcept(internal::is_nothrow_constructible_from_tuple<T, Tuple>::value)
 {
     using namespace internal;
     using Indices = make_index_sequence<tuple_size<decay_t<Tuple>>::value>;
     return make_from_tuple_imp<T>(forward<Tuple>(args_tuple), Indices{});
 }
+#endif
 
-#if 0
 template <class T, class Tuple>
-T* uninitialized_construct_from_tuple(T* p, Tuple&& args_tuple)
+CPP20_CONSTEXPR T* uninitialized_construct_from_tuple(T* p,
+                                                      Tuple&& args_tuple)
+    noexcept(internal::is_nothrow_constructible_from_tuple<T, Tuple>::value)
 {
     using namespace internal;
     using Indices = make_index_sequence<tuple_size<decay_t<Tuple>>::value>;
@@ -67,7 +117,6 @@ T* uninitialized_construct_from_tuple(T* p, Tuple&& args_tuple)
                                                      forward<Tuple>(args_tuple),
                                                      Indices{});
 }
-#endif
 
 } // close namespace Cpp17
 } // close namespace std
@@ -129,5 +129,29 @@ int main()
         pObj->~TT();
     }
 
+    // `apply`, `make_from_tuple`, and `uninitialized_construct_from_tuple`
+    // are `noexcept` if the call or constructor they make is.
+    {
+        struct Nothrow {
+            Nothrow(int) noexcept { }
+            Nothrow(int, int) { }
+        };
+        auto nothrowF = [](int) noexcept { };
+        auto throwF = [](int) { };
+        std::tuple<int> t1(1);
+        std::tuple<int, int> t2(1, 2);
+        std::tuple<const char*> ts("abc");
+        Nothrow *p = nullptr;
+
+        TEST_ASSERT(noexcept(std::apply(nothrowF, t1)));
+        TEST_ASSERT(! noexcept(std::apply(throwF, t1)));
+        TEST_ASSERT(noexcept(std::make_from_tuple<Nothrow>(std::move(t1))));
+        TEST_ASSERT(! noexcept(std::make_from_tuple<Nothrow>(t2)));
+        TEST_ASSERT(! noexcept(std::make_from_tuple<std::string>(ts)));
+        TEST_ASSERT(noexcept(std::uninitialized_construct_from_tuple(p, t1)));
+        TEST_ASSERT(! noexcept(std::uninitialized_construct_from_tuple(p,
+                                                                       t2)));
+    }
+
     return errorCount();
 }
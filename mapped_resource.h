@@ -0,0 +1,269 @@
+/* mapped_resource.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `mapped_segment`, a bump allocator over a block of memory whose contents
+ * are position independent; `segment_allocator`, an allocator for it whose
+ * `pointer` type is `offset_ptr`; and `pmr::mapped_file_resource`, which
+ * maps a file as a segment, so that allocator-aware data structures built
+ * in the file can be used again after remapping it, without deserializing
+ * them (extension).  Requires POSIX `mmap`.
+ */
+
+#ifndef INCLUDED_MAPPED_RESOURCE_DOT_H
+#define INCLUDED_MAPPED_RESOURCE_DOT_H
+
+#include <memory_resource.h>
+#include <offset_ptr.h>
+#include <uses_allocator.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+// Header at the start of a block of memory, followed by storage that is
+// handed out in order and never reused, like a `monotonic_buffer_resource`
+// whose state lives in the block itself.  All of the segment's state is
+// stored in the block as sizes and offsets, so the block may be copied or
+// mapped at another address.  Not thread-safe.
+class mapped_segment
+{
+    static constexpr uint64_t segment_magic = 0x31746e656d676553ull;
+
+    uint64_t         m_magic;
+    uint64_t         m_size;   // Bytes in the block, including the header
+    uint64_t         m_used;   // Bytes allocated, including the header
+    offset_ptr<void> m_root;
+
+    explicit mapped_segment(size_t size) noexcept
+        : m_magic(segment_magic), m_size(size), m_used(sizeof(*this)) { }
+
+    mapped_segment(const mapped_segment&) = delete;
+    mapped_segment& operator=(const mapped_segment&) = delete;
+
+public:
+    // Create an empty segment in the `size` bytes at `base`, which must be
+    // suitably aligned for any type.
+    static mapped_segment* create(void* base, size_t size) {
+        if (size < sizeof(mapped_segment))
+            throw invalid_argument("mapped_segment: block too small");
+        return ::new(base) mapped_segment(size);
+    }
+
+    // Return the segment previously created in the `size` bytes at `base`.
+    // Throw `runtime_error` if the block does not hold such a segment.
+    static mapped_segment* open(void* base, size_t size) {
+        mapped_segment* s = static_cast<mapped_segment*>(base);
+        if (size < sizeof(mapped_segment) || segment_magic != s->m_magic ||
+            size < s->m_size || s->m_size < s->m_used)
+            throw runtime_error("mapped_segment: not a valid segment");
+        return s;
+    }
+
+    // Return `bytes` bytes aligned to `alignment`, a power of two, from the
+    // unused part of the block.  Throw `bad_alloc` if they do not fit.
+    void* allocate(size_t bytes, size_t alignment = alignof(max_align_t)) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(this);
+        const uintptr_t first = (base + m_used + alignment - 1) &
+                                ~uintptr_t(alignment - 1);
+        if (first - base > m_size || bytes > m_size - (first - base))
+            throw bad_alloc();
+        m_used = first - base + bytes;
+        return reinterpret_cast<void*>(first);
+    }
+
+    // Memory is reclaimed only when the whole segment is discarded.
+    void deallocate(void*, size_t, size_t = alignof(max_align_t)) noexcept
+        { }
+
+    size_t size() const noexcept { return size_t(m_size); }
+    size_t used() const noexcept { return size_t(m_used); }
+
+    // The object from which the contents of the segment are reached after
+    // it is reopened, or null.
+    void* root() const noexcept { return m_root.get(); }
+    void set_root(void* p) noexcept { m_root = p; }
+};
+
+// Allocator that obtains memory from a `mapped_segment`.  Its `pointer` is
+// `offset_ptr<T>` and it holds an `offset_ptr` to the segment, so a
+// container that stores its allocator and pointers inside the segment
+// remains valid wherever the segment is mapped.  `construct` performs
+// uses-allocator construction, so that allocator-aware elements use the
+// same segment.  Memory is never reused (see `mapped_segment`).
+template <class T>
+class segment_allocator
+{
+    template <class> friend class segment_allocator;
+
+    offset_ptr<mapped_segment> m_segment;
+
+public:
+    typedef T                      value_type;
+    typedef offset_ptr<T>          pointer;
+    typedef offset_ptr<const T>    const_pointer;
+    typedef offset_ptr<void>       void_pointer;
+    typedef offset_ptr<const void> const_void_pointer;
+    typedef size_t                 size_type;
+    typedef ptrdiff_t              difference_type;
+
+    explicit segment_allocator(mapped_segment* s) noexcept : m_segment(s) { }
+
+    template <class U>
+    segment_allocator(const segment_allocator<U>& other) noexcept
+        : m_segment(other.m_segment) { }
+
+    pointer allocate(size_t n) {
+        if (n > size_t(-1) / sizeof(T))
+            throw bad_alloc();
+        return pointer(static_cast<T*>(
+                           m_segment->allocate(n * sizeof(T), alignof(T))));
+    }
+
+    void deallocate(pointer p, size_t n) noexcept {
+        m_segment->deallocate(p.get(), n * sizeof(T), alignof(T));
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        Cpp20::uninitialized_construct_using_allocator(
+            p, *this, std::forward<Args>(args)...);
+    }
+
+    mapped_segment* segment() const noexcept { return m_segment.get(); }
+};
+
+template <class T, class U>
+inline bool operator==(const segment_allocator<T>& a,
+                       const segment_allocator<U>& b) noexcept
+{
+    return a.segment() == b.segment();
+}
+
+template <class T, class U>
+inline bool operator!=(const segment_allocator<T>& a,
+                       const segment_allocator<U>& b) noexcept
+{
+    return a.segment() != b.segment();
+}
+
+} // close namespace Cpp20
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+// Memory resource whose memory comes from a file mapped shared into the
+// address space, holding a `mapped_segment`.  Structures built with
+// `segment_allocator` from `segment()` (and reached from its root) are
+// written to the file, and a later `mapped_file_resource` for the same file
+// finds them in place at whatever address the file is mapped.  Memory
+// obtained through the `memory_resource` interface also comes from the
+// segment, but is reached through raw pointers, so it is only usable while
+// this mapping exists.
+class mapped_file_resource : public memory_resource
+{
+    int             m_fd;
+    void*           m_base;
+    size_t          m_size;
+    mapped_segment* m_segment;
+    bool            m_created;
+
+    [[noreturn]] static void fail(const char* what) {
+        throw system_error(errno, system_category(), what);
+    }
+
+public:
+    // Open the file at `path`, creating it with a new segment of `size`
+    // bytes if it does not exist or is empty, and map all of it for reading
+    // and writing.  Throw `system_error` if the file cannot be opened or
+    // mapped, and `runtime_error` if it does not hold a segment.
+    mapped_file_resource(const char* path, size_t size)
+        : m_fd(::open(path, O_RDWR | O_CREAT, 0666))
+        , m_base(nullptr), m_size(0), m_segment(nullptr), m_created(false)
+    {
+        if (m_fd < 0)
+            fail("mapped_file_resource: open");
+        try {
+            struct stat st;
+            if (::fstat(m_fd, &st) < 0)
+                fail("mapped_file_resource: fstat");
+            m_created = 0 == st.st_size;
+            if (m_created && ::ftruncate(m_fd, off_t(size)) < 0)
+                fail("mapped_file_resource: ftruncate");
+            m_size = m_created ? size : size_t(st.st_size);
+            m_base = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, m_fd, 0);
+            if (MAP_FAILED == m_base) {
+                m_base = nullptr;
+                fail("mapped_file_resource: mmap");
+            }
+            m_segment = m_created ? mapped_segment::create(m_base, m_size)
+                                  : mapped_segment::open(m_base, m_size);
+        }
+        catch (...) {
+            if (m_base)
+                ::munmap(m_base, m_size);
+            ::close(m_fd);
+            throw;
+        }
+    }
+
+    mapped_file_resource(const mapped_file_resource&) = delete;
+    mapped_file_resource& operator=(const mapped_file_resource&) = delete;
+
+    // Unmap the file.  The kernel writes the contents back to the file.
+    ~mapped_file_resource() {
+        ::munmap(m_base, m_size);
+        ::close(m_fd);
+    }
+
+    // Write the contents of the mapping to the file before returning.
+    void sync() {
+        if (::msync(m_base, m_size, MS_SYNC) < 0)
+            fail("mapped_file_resource: msync");
+    }
+
+    // True if this object created the segment rather than opening an
+    // existing one.
+    bool created() const noexcept { return m_created; }
+
+    mapped_segment& segment() const noexcept { return *m_segment; }
+
+    template <class T>
+    segment_allocator<T> get_allocator() const noexcept
+        { return segment_allocator<T>(m_segment); }
+
+    void* base() const noexcept { return m_base; }
+    size_t size() const noexcept { return m_size; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+        { return m_segment->allocate(bytes, alignment); }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        { m_segment->deallocate(p, bytes, alignment); }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_MAPPED_RESOURCE_DOT_H)
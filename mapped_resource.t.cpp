@@ -0,0 +1,189 @@
+/* mapped_resource.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <mapped_resource.h>
+
+#include <copy_swap_transaction.h>
+#include <cstdio>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+typedef std::vector<int, exp::segment_allocator<int>> IntVec;
+
+// Allocator-aware table entry; its vector uses the entry's allocator.
+struct Entry
+{
+    typedef exp::segment_allocator<int> allocator_type;
+
+    int    m_key;
+    IntVec m_values;
+
+    Entry(int key, const allocator_type& a) : m_key(key), m_values(a) { }
+    Entry(const Entry& other, const allocator_type& a)
+        : m_key(other.m_key), m_values(other.m_values, a) { }
+    Entry(Entry&& other, const allocator_type& a)
+        : m_key(other.m_key), m_values(std::move(other.m_values), a) { }
+};
+
+typedef std::vector<Entry, exp::segment_allocator<Entry>> Table;
+
+const int k_ENTRIES = 100;
+
+// Return true if `t` holds the entries built below, all of whose memory
+// comes from `segment`.
+bool checkTable(const Table& t, exp::mapped_segment* segment)
+{
+    if (k_ENTRIES != int(t.size()) || segment != t.get_allocator().segment())
+        return false;
+    for (int i = 0; i < k_ENTRIES; ++i) {
+        const Entry& e = t[i];
+        if (i != e.m_key || i % 7 + 1 != int(e.m_values.size()) ||
+            segment != e.m_values.get_allocator().segment())
+            return false;
+        for (int j = 0; j < int(e.m_values.size()); ++j)
+            if (i * 100 + j != e.m_values[j])
+                return false;
+    }
+    return true;
+}
+
+int main()
+{
+    const std::string path = "mapped_resource_t_" +
+                             std::to_string(::getpid()) + ".seg";
+    std::remove(path.c_str());
+
+    // Segments in ordinary memory
+    {
+        alignas(std::max_align_t) unsigned char buf[256];
+        exp::mapped_segment* s = exp::mapped_segment::create(buf,
+                                                             sizeof(buf));
+        TEST_ASSERT(sizeof(buf) == s->size());
+        TEST_ASSERT(! s->root());
+        void* p = s->allocate(10, 1);
+        void* q = s->allocate(8, 8);
+        TEST_ASSERT(0 == reinterpret_cast<std::uintptr_t>(q) % 8);
+        TEST_ASSERT(static_cast<char*>(q) >= static_cast<char*>(p) + 10);
+
+        int caught = 0;
+        try {
+            s->allocate(sizeof(buf));
+        }
+        catch (std::bad_alloc&) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+        TEST_ASSERT(s == exp::mapped_segment::open(buf, sizeof(buf)));
+
+        unsigned char junk[256] = { };
+        try {
+            exp::mapped_segment::open(junk, sizeof(junk));
+        }
+        catch (std::runtime_error&) {
+            ++caught;
+        }
+        TEST_ASSERT(2 == caught);
+    }
+
+    // Build a table of allocator-aware entries in a new file
+    {
+        pmr::mapped_file_resource r(path.c_str(), 1 << 20);
+        TEST_ASSERT(r.created());
+        TEST_ASSERT((1 << 20) == r.size());
+
+        exp::segment_allocator<Table> a = r.get_allocator<Table>();
+        exp::offset_ptr<Table> t = a.allocate(1);
+        exp::uninitialized_construct_using_allocator(t, a);
+        r.segment().set_root(t.get());
+
+        for (int i = 0; i < k_ENTRIES; ++i) {
+            Entry& e = (t->emplace_back(i), t->back());
+            for (int j = 0; j <= i % 7; ++j)
+                e.m_values.push_back(i * 100 + j);
+        }
+        TEST_ASSERT(checkTable(*t, &r.segment()));
+
+        // The same file mapped again, at another address
+        {
+            pmr::mapped_file_resource r2(path.c_str(), 0);
+            TEST_ASSERT(! r2.created());
+            TEST_ASSERT(r2.base() != r.base());
+            const Table* t2 = static_cast<Table*>(r2.segment().root());
+            TEST_ASSERT(static_cast<const void*>(t2) != t.get());
+            TEST_ASSERT(checkTable(*t2, &r2.segment()));
+        }
+
+        // `swap_assign` keeps the table's allocator
+        Table other(a);
+        other.emplace_back(-1);
+        std::experimental::swap_assign(*t, std::move(other));
+        TEST_ASSERT(1 == t->size());
+        TEST_ASSERT(&r.segment() == t->get_allocator().segment());
+        TEST_ASSERT(&r.segment() ==
+                    (*t)[0].m_values.get_allocator().segment());
+        t->clear();
+        for (int i = 0; i < k_ENTRIES; ++i) {
+            Entry& e = (t->emplace_back(i), t->back());
+            for (int j = 0; j <= i % 7; ++j)
+                e.m_values.push_back(i * 100 + j);
+        }
+
+        // The `memory_resource` interface allocates from the segment
+        const std::size_t used = r.segment().used();
+        void* p = r.allocate(64);
+        TEST_ASSERT(r.segment().used() >= used + 64);
+        TEST_ASSERT(static_cast<char*>(p) > static_cast<char*>(r.base()));
+        r.deallocate(p, 64);
+        r.sync();
+    }
+
+    // Reopened after the first mapping is gone
+    {
+        pmr::mapped_file_resource r(path.c_str(), 1 << 20);
+        TEST_ASSERT(! r.created());
+        Table* t = static_cast<Table*>(r.segment().root());
+        TEST_ASSERT(checkTable(*t, &r.segment()));
+
+        // Growing an existing table allocates from the reopened segment
+        t->emplace_back(k_ENTRIES);
+        TEST_ASSERT(&r.segment() ==
+                    t->back().m_values.get_allocator().segment());
+    }
+
+    // Files that do not hold a segment are rejected
+    {
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        std::fputs("not a segment", f);
+        std::fclose(f);
+        int caught = 0;
+        try {
+            pmr::mapped_file_resource r(path.c_str(), 1 << 20);
+        }
+        catch (std::runtime_error&) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+
+        try {
+            pmr::mapped_file_resource r("no_such_dir/x.seg", 1 << 20);
+        }
+        catch (std::system_error&) {
+            ++caught;
+        }
+        TEST_ASSERT(2 == caught);
+    }
+
+    std::remove(path.c_str());
+    return errorCount();
+}
@@ -0,0 +1,431 @@
+/* memory_resource.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Implementation of C++17 `pmr::memory_resource`, `new_delete_resource`,
+ * `null_memory_resource`, `get_default_resource`, `set_default_resource`,
+ * and `monotonic_buffer_resource`, and of a C++20
+ * `pmr::polymorphic_allocator` whose `construct` member uses
+ * `uninitialized_construct_using_allocator`, with a thread-local
+ * `scoped_default_resource` override (extension).
+ */
+
+#ifndef INCLUDED_MEMORY_RESOURCE_DOT_H
+#define INCLUDED_MEMORY_RESOURCE_DOT_H
+
+#include <uses_allocator.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace std {
+
+// In C++17 and later the standard library declares its own `std::pmr`, so
+// this library's `pmr` is declared in `std::experimental` (as in the
+// Library Fundamentals TS) rather than in an inline namespace of `std`,
+// where the two would be ambiguous.
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+class memory_resource
+{
+    static constexpr size_t max_align = alignof(max_align_t);
+
+public:
+    virtual ~memory_resource() { }
+
+    void* allocate(size_t bytes, size_t alignment = max_align)
+        { return do_allocate(bytes, alignment); }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = max_align)
+        { do_deallocate(p, bytes, alignment); }
+
+    // Deallocate the `n` blocks `blocks[0]` through `blocks[n - 1]`, each of
+    // which was allocated with the specified `bytes` and `alignment`
+    // (extension).
+    void deallocate_bulk(void* const* blocks, size_t n, size_t bytes,
+                         size_t alignment = max_align)
+        { do_deallocate_bulk(blocks, n, bytes, alignment); }
+
+    bool is_equal(const memory_resource& other) const noexcept
+        { return do_is_equal(other); }
+
+protected:
+    virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+
+    // Deallocate each block in turn.  Resources that can return a batch of
+    // same-sized blocks more cheaply than one at a time should override this.
+    virtual void do_deallocate_bulk(void* const* blocks, size_t n,
+                                    size_t bytes, size_t alignment) {
+        for (size_t i = 0; i < n; ++i)
+            do_deallocate(blocks[i], bytes, alignment);
+    }
+};
+
+inline bool operator==(const memory_resource& a, const memory_resource& b)
+{
+    return &a == &b || a.is_equal(b);
+}
+
+inline bool operator!=(const memory_resource& a, const memory_resource& b)
+{
+    return ! (a == b);
+}
+
+namespace internal {
+
+// Memory resource that uses global `operator new` and `operator delete`.
+// Alignments larger than that guaranteed by `operator new` are satisfied by
+// over-allocating and storing the original pointer just before the aligned
+// block.
+class new_delete_resource_imp : public memory_resource
+{
+    static constexpr size_t new_align = alignof(max_align_t);
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (alignment <= new_align)
+            return ::operator new(bytes);
+
+        size_t total = bytes + alignment + sizeof(void*);
+        void* raw = ::operator new(total);
+        void* p = static_cast<char*>(raw) + sizeof(void*);
+        size_t space = total - sizeof(void*);
+        std::align(alignment, bytes, p, space);
+        static_cast<void**>(p)[-1] = raw;
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t, size_t alignment) override {
+        if (alignment <= new_align)
+            ::operator delete(p);
+        else
+            ::operator delete(static_cast<void**>(p)[-1]);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+// Memory resource that fails every allocation.
+class null_memory_resource_imp : public memory_resource
+{
+protected:
+    void* do_allocate(size_t, size_t) override { throw bad_alloc(); }
+    void do_deallocate(void*, size_t, size_t) override { }
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+} // close namespace internal
+
+inline memory_resource* new_delete_resource() noexcept
+{
+    // Header-only static variable
+    static internal::new_delete_resource_imp resource;
+    return &resource;
+}
+
+inline memory_resource* null_memory_resource() noexcept
+{
+    // Header-only static variable
+    static internal::null_memory_resource_imp resource;
+    return &resource;
+}
+
+namespace internal {
+
+// The process-wide default resource set by `set_default_resource`.
+inline atomic<memory_resource*>& global_default_resource() noexcept
+{
+    // Header-only static variable
+    static atomic<memory_resource*> resource(new_delete_resource());
+    return resource;
+}
+
+// The calling thread's override of the default resource, installed by
+// `scoped_default_resource`, or null if there is none.
+inline memory_resource*& thread_default_resource() noexcept
+{
+    // Header-only thread-local variable
+    static thread_local memory_resource* resource = nullptr;
+    return resource;
+}
+
+} // close namespace internal
+
+// Return the default memory resource for the calling thread: the resource
+// of the innermost `scoped_default_resource` alive on this thread, if any,
+// and otherwise the one set by `set_default_resource`.
+inline memory_resource* get_default_resource() noexcept
+{
+    memory_resource* r = internal::thread_default_resource();
+    return r ? r : internal::global_default_resource().load();
+}
+
+// Set the process-wide default memory resource to `r`, or to
+// `new_delete_resource()` if `r` is null, and return the previous one.
+inline memory_resource* set_default_resource(memory_resource* r) noexcept
+{
+    return internal::global_default_resource().exchange(
+                                                r ? r : new_delete_resource());
+}
+
+// Guard that makes `r` the default memory resource of the calling thread
+// for its lifetime (extension), so that e.g. every allocator-aware object
+// built without an explicit allocator while a request is handled is
+// allocated from the request's arena.  Guards nest; destroying one
+// restores the default that was in effect when it was created.  A guard
+// must be destroyed on the thread that created it, in reverse order of
+// creation.
+class scoped_default_resource
+{
+    memory_resource* m_previous;
+
+public:
+    explicit scoped_default_resource(memory_resource* r) noexcept
+        : m_previous(internal::thread_default_resource()) {
+        internal::thread_default_resource() = r;
+    }
+
+    scoped_default_resource(const scoped_default_resource&) = delete;
+    scoped_default_resource& operator=(const scoped_default_resource&)
+        = delete;
+
+    ~scoped_default_resource()
+        { internal::thread_default_resource() = m_previous; }
+};
+
+// Memory resource that allocates by bumping a pointer through a chunk of
+// memory obtained from an upstream resource.  Deallocation is a no-op;
+// memory is reclaimed only by `release()` or destruction.  When a chunk is
+// exhausted, the next chunk obtained from upstream is `growth_factor` times
+// larger than the previous one, so the number of chunks is logarithmic in
+// the total number of bytes allocated.  If an initial buffer is supplied, it
+// is used before any memory is requested from upstream.
+class monotonic_buffer_resource : public memory_resource
+{
+    // Header placed at the start of each chunk obtained from upstream.
+    struct chunk_header {
+        chunk_header* m_next;
+        size_t        m_size;
+        size_t        m_alignment;
+    };
+
+    static constexpr size_t default_initial_size = 1024;
+    static constexpr size_t growth_factor        = 2;
+
+    memory_resource* m_upstream;
+    void*            m_initial_buffer;
+    size_t           m_initial_size;
+    char*            m_current;       // Next free byte in current chunk
+    size_t           m_space;         // Bytes remaining in current chunk
+    size_t           m_next_size;     // Size of next chunk from upstream
+    size_t           m_first_size;    // Size of first chunk from upstream
+    chunk_header*    m_chunks;        // Most recent upstream chunk
+
+    // Return `size` times `growth_factor`, saturating at the largest
+    // `size_t` (which no upstream resource can supply).
+    static size_t grow(size_t size) noexcept {
+        return size > size_t(-1) / growth_factor ? size_t(-1)
+                                                 : size * growth_factor;
+    }
+
+    // Obtain a new chunk from upstream large enough to hold `bytes` bytes
+    // aligned to `alignment`, and allocate from it.  Throw `bad_alloc` if
+    // the chunk size cannot be represented.
+    void* allocate_from_new_chunk(size_t bytes, size_t alignment) {
+        constexpr size_t header_size = sizeof(chunk_header);
+        size_t chunk_align = alignof(chunk_header);
+        if (alignment > chunk_align)
+            chunk_align = alignment;
+
+        if (bytes > size_t(-1) - header_size - alignment)
+            throw bad_alloc();
+        size_t size = m_next_size;
+        size_t needed = header_size + alignment + bytes;
+        while (size < needed)
+            size = grow(size);
+
+        void* chunk = m_upstream->allocate(size, chunk_align);
+        chunk_header* header = static_cast<chunk_header*>(chunk);
+        header->m_next = m_chunks;
+        header->m_size = size;
+        header->m_alignment = chunk_align;
+        m_chunks = header;
+        m_next_size = grow(size);
+
+        void* p = static_cast<char*>(chunk) + header_size;
+        size_t space = size - header_size;
+        std::align(alignment, bytes, p, space);
+        m_current = static_cast<char*>(p) + bytes;
+        m_space = space - bytes;
+        return p;
+    }
+
+public:
+    explicit monotonic_buffer_resource(
+                           memory_resource* upstream = get_default_resource())
+        : monotonic_buffer_resource(default_initial_size, upstream) { }
+
+    monotonic_buffer_resource(size_t initial_size,
+                              memory_resource* upstream =
+                                                      get_default_resource())
+        : m_upstream(upstream)
+        , m_initial_buffer(nullptr), m_initial_size(0)
+        , m_current(nullptr), m_space(0)
+        , m_next_size(initial_size ? initial_size : 1)
+        , m_first_size(m_next_size)
+        , m_chunks(nullptr) { }
+
+    monotonic_buffer_resource(void* buffer, size_t buffer_size,
+                              memory_resource* upstream =
+                                                      get_default_resource())
+        : m_upstream(upstream)
+        , m_initial_buffer(buffer), m_initial_size(buffer_size)
+        , m_current(static_cast<char*>(buffer)), m_space(buffer_size)
+        , m_next_size(buffer_size ? grow(buffer_size) : default_initial_size)
+        , m_first_size(m_next_size)
+        , m_chunks(nullptr) { }
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&)
+        = delete;
+
+    ~monotonic_buffer_resource() { release(); }
+
+    // Return all memory obtained from upstream and make the initial buffer
+    // (if any) available again.  The cost is independent of the number of
+    // allocations; it is proportional only to the number of upstream chunks.
+    void release() {
+        while (m_chunks) {
+            chunk_header* next = m_chunks->m_next;
+            m_upstream->deallocate(m_chunks, m_chunks->m_size,
+                                   m_chunks->m_alignment);
+            m_chunks = next;
+        }
+        m_current = static_cast<char*>(m_initial_buffer);
+        m_space = m_initial_size;
+        m_next_size = m_first_size;
+    }
+
+    memory_resource* upstream_resource() const { return m_upstream; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = m_current;
+        size_t space = m_space;
+        if (p && std::align(alignment, bytes, p, space)) {
+            m_current = static_cast<char*>(p) + bytes;
+            m_space = space - bytes;
+            return p;
+        }
+        return allocate_from_new_chunk(bytes, alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override { }
+
+    void do_deallocate_bulk(void* const*, size_t, size_t, size_t) override
+        { }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+template <class T = std::byte>
+class polymorphic_allocator {
+    memory_resource *p_rsrc;
+
+    template <class> friend class polymorphic_allocator;
+
+public:
+    typedef T value_type;
+
+    // Use the calling thread's default resource (see
+    // `scoped_default_resource`).
+    polymorphic_allocator() noexcept : p_rsrc(get_default_resource()) { }
+    polymorphic_allocator(memory_resource *r) : p_rsrc(r) { }
+
+    template <class U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+        : p_rsrc(other.p_rsrc) { }
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(p_rsrc->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        p_rsrc->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    // Deallocate the `num_blocks` blocks `blocks[0]` through
+    // `blocks[num_blocks - 1]`, each of which was obtained from `allocate(n)`,
+    // with as few calls to `resource()->deallocate_bulk` as possible
+    // (extension).
+    void deallocate_bulk(T* const* blocks, size_t num_blocks, size_t n = 1) {
+        static constexpr size_t batch = 64;
+        void* buffer[batch];
+        while (num_blocks) {
+            const size_t count = std::min(num_blocks, batch);
+            for (size_t i = 0; i < count; ++i)
+                buffer[i] = blocks[i];
+            p_rsrc->deallocate_bulk(buffer, count, n * sizeof(T), alignof(T));
+            blocks += count;
+            num_blocks -= count;
+        }
+    }
+
+    // Construct a `U` at `p` using uses-allocator construction with this
+    // allocator, including piecewise propagation into `std::pair` members.
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        Cpp20::uninitialized_construct_using_allocator(p, *this,
+                                                std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    void destroy(U* p) { p->~U(); }
+
+    polymorphic_allocator select_on_container_copy_construction() const
+        { return polymorphic_allocator(); }
+
+    memory_resource *resource() const { return p_rsrc; }
+};
+
+template <class T1, class T2>
+bool operator==(const polymorphic_allocator<T1>& a1,
+                const polymorphic_allocator<T2>& a2) {
+    return *a1.resource() == *a2.resource();
+}
+
+template <class T1, class T2>
+bool operator!=(const polymorphic_allocator<T1>& a1,
+                const polymorphic_allocator<T2>& a2) {
+    return ! (a1 == a2);
+}
+
+// Return a `T` constructed by uses-allocator construction with a
+// `polymorphic_allocator` using the calling thread's default resource, and
+// the specified `args` (extension).
+template <class T, class... Args>
+T make_obj_using_default_resource(Args&&... args)
+{
+    return Cpp20::make_obj_using_allocator<T>(polymorphic_allocator<>(),
+                                              std::forward<Args>(args)...);
+}
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_MEMORY_RESOURCE_DOT_H)
@@ -0,0 +1,382 @@
+/* memory_resource.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <memory_resource.h>
+
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Upstream resource that records every allocation and deallocation.
+class CountingResource : public pmr::memory_resource
+{
+public:
+    struct Block { void* p; std::size_t bytes; std::size_t alignment; };
+
+    std::vector<Block> m_allocs;
+    std::vector<Block> m_deallocs;
+
+    std::size_t outstanding() const
+        { return m_allocs.size() - m_deallocs.size(); }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = pmr::new_delete_resource()->allocate(bytes, alignment);
+        m_allocs.push_back(Block{ p, bytes, alignment });
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override {
+        m_deallocs.push_back(Block{ p, bytes, alignment });
+        pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept
+        override { return this == &other; }
+};
+
+bool isAligned(void* p, std::size_t alignment)
+{
+    return 0 == reinterpret_cast<std::uintptr_t>(p) % alignment;
+}
+
+// Allocator-aware test type that takes a polymorphic allocator as a trailing
+// constructor argument.
+class PmrType
+{
+    pmr::polymorphic_allocator<> m_alloc;
+    int                          m_value;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    explicit PmrType(int v = 0) : m_value(v) { }
+    PmrType(int v, const allocator_type& a) : m_alloc(a), m_value(v) { }
+
+    allocator_type get_allocator() const { return m_alloc; }
+    int value() const { return m_value; }
+};
+
+int main()
+{
+    // new_delete_resource and null_memory_resource
+    {
+        pmr::memory_resource* r = pmr::new_delete_resource();
+        TEST_ASSERT(r == pmr::new_delete_resource());
+        TEST_ASSERT(*r == *pmr::new_delete_resource());
+        TEST_ASSERT(*r != *pmr::null_memory_resource());
+
+        for (std::size_t align = 1; align <= 256; align *= 2) {
+            void* p = r->allocate(40, align);
+            TEST_ASSERT(isAligned(p, align));
+            r->deallocate(p, 40, align);
+        }
+
+        bool caught = false;
+        try {
+            pmr::null_memory_resource()->allocate(1);
+        }
+        catch (std::bad_alloc&) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+    }
+
+    // Monotonic allocation is a pointer bump within a chunk
+    {
+        CountingResource upstream;
+        pmr::monotonic_buffer_resource mr(&upstream);
+        TEST_ASSERT(&upstream == mr.upstream_resource());
+        TEST_ASSERT(0 == upstream.m_allocs.size());
+
+        char* p1 = static_cast<char*>(mr.allocate(8, 1));
+        char* p2 = static_cast<char*>(mr.allocate(8, 1));
+        char* p3 = static_cast<char*>(mr.allocate(4, 4));
+        TEST_ASSERT(1 == upstream.m_allocs.size());
+        TEST_ASSERT(p1 + 8 == p2);
+        TEST_ASSERT(p2 + 8 == p3);
+
+        mr.deallocate(p2, 8, 1);  // No-op
+        TEST_ASSERT(0 == upstream.m_deallocs.size());
+
+        void* p4 = mr.allocate(16, 64);
+        TEST_ASSERT(isAligned(p4, 64));
+
+        TEST_ASSERT(mr == mr);
+        pmr::monotonic_buffer_resource mr2(&upstream);
+        TEST_ASSERT(mr != mr2);
+    }
+
+    // Geometric chunk growth and release
+    {
+        CountingResource upstream;
+        {
+            pmr::monotonic_buffer_resource mr(100, &upstream);
+            for (int i = 0; i < 1000; ++i)
+                mr.allocate(10, 1);
+
+            const std::size_t numChunks = upstream.m_allocs.size();
+            TEST_ASSERT(numChunks > 1);
+            TEST_ASSERT(numChunks < 10);
+            TEST_ASSERT(100 == upstream.m_allocs[0].bytes);
+            for (std::size_t i = 1; i < numChunks; ++i)
+                TEST_ASSERT(upstream.m_allocs[i].bytes ==
+                            2 * upstream.m_allocs[i - 1].bytes);
+
+            mr.release();
+            TEST_ASSERT(0 == upstream.outstanding());
+
+            // Growth restarts from the initial size after release
+            mr.allocate(10, 1);
+            TEST_ASSERT(numChunks + 1 == upstream.m_allocs.size());
+            TEST_ASSERT(100 == upstream.m_allocs.back().bytes);
+
+            // A request larger than the next chunk size is satisfied
+            void* big = mr.allocate(10000, 8);
+            TEST_ASSERT(isAligned(big, 8));
+            TEST_ASSERT(upstream.m_allocs.back().bytes >= 10000);
+        }
+        // Destructor releases
+        TEST_ASSERT(0 == upstream.outstanding());
+    }
+
+    // Initial buffer is used before upstream
+    {
+        CountingResource upstream;
+        alignas(std::max_align_t) char buffer[64];
+        pmr::monotonic_buffer_resource mr(buffer, sizeof(buffer), &upstream);
+
+        void* p1 = mr.allocate(32, 1);
+        void* p2 = mr.allocate(32, 1);
+        TEST_ASSERT(buffer == p1);
+        TEST_ASSERT(buffer + 32 == p2);
+        TEST_ASSERT(0 == upstream.m_allocs.size());
+
+        mr.allocate(1, 1);
+        TEST_ASSERT(1 == upstream.m_allocs.size());
+        TEST_ASSERT(128 == upstream.m_allocs[0].bytes);
+
+        mr.release();
+        TEST_ASSERT(0 == upstream.outstanding());
+        TEST_ASSERT(buffer == mr.allocate(8, 1));
+    }
+
+    // Requests too large for any chunk fail instead of overflowing the
+    // chunk size
+    {
+        CountingResource upstream;
+        pmr::monotonic_buffer_resource mr(100, &upstream);
+        int caught = 0;
+        try {
+            mr.allocate(std::size_t(-1), 1);
+        }
+        catch (std::bad_alloc&) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+        TEST_ASSERT(0 == upstream.m_allocs.size());
+
+        // The size of the chunk requested saturates rather than wrapping
+        pmr::monotonic_buffer_resource mr2(100, pmr::null_memory_resource());
+        try {
+            mr2.allocate(std::size_t(-1) - 1024, 1);
+        }
+        catch (std::bad_alloc&) {
+            ++caught;
+        }
+        TEST_ASSERT(2 == caught);
+    }
+
+    // polymorphic_allocator
+    {
+        pmr::polymorphic_allocator<> dflt;
+        TEST_ASSERT(pmr::new_delete_resource() == dflt.resource());
+
+        pmr::monotonic_buffer_resource mr;
+        pmr::polymorphic_allocator<int> a(&mr);
+        pmr::polymorphic_allocator<double> b(a);
+        TEST_ASSERT(&mr == b.resource());
+        TEST_ASSERT(a == b);
+        TEST_ASSERT(a != dflt);
+        TEST_ASSERT(dflt == a.select_on_container_copy_construction());
+
+        int* ip = a.allocate(10);
+        TEST_ASSERT(isAligned(ip, alignof(int)));
+        double* dp = b.allocate(1);
+        TEST_ASSERT(isAligned(dp, alignof(double)));
+        b.deallocate(dp, 1);
+        a.deallocate(ip, 10);
+    }
+
+    // Bulk deallocation defaults to deallocating each block in turn
+    {
+        CountingResource upstream;
+        pmr::polymorphic_allocator<int> a(&upstream);
+        std::vector<int*> blocks;
+        for (int i = 0; i < 100; ++i)
+            blocks.push_back(a.allocate(3));
+        a.deallocate_bulk(blocks.data(), blocks.size(), 3);
+        TEST_ASSERT(0 == upstream.outstanding());
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            TEST_ASSERT(blocks[i] == upstream.m_deallocs[i].p);
+            TEST_ASSERT(3 * sizeof(int) == upstream.m_deallocs[i].bytes);
+            TEST_ASSERT(alignof(int) == upstream.m_deallocs[i].alignment);
+        }
+
+        pmr::monotonic_buffer_resource mr(&upstream);
+        void* ps[2] = { mr.allocate(8), mr.allocate(8) };
+        mr.deallocate_bulk(ps, 2, 8);
+        TEST_ASSERT(1 == upstream.outstanding());
+    }
+
+    // Uses-allocator construction from a monotonic resource
+    {
+        CountingResource upstream;
+        pmr::monotonic_buffer_resource mr(4096, &upstream);
+        pmr::polymorphic_allocator<PmrType> a(&mr);
+
+        PmrType* p = a.allocate(1);
+        exp::uninitialized_construct_using_allocator(p, a, 5);
+        TEST_ASSERT(5 == p->value());
+        TEST_ASSERT(&mr == p->get_allocator().resource());
+        p->~PmrType();
+
+        typedef std::pair<PmrType, int> Pair;
+        pmr::polymorphic_allocator<Pair> pa(a);
+        Pair* pp = pa.allocate(1);
+        pa.construct(pp, 6, 7);
+        TEST_ASSERT(6 == pp->first.value());
+        TEST_ASSERT(7 == pp->second);
+        TEST_ASSERT(&mr == pp->first.get_allocator().resource());
+        pa.destroy(pp);
+
+        PmrType* range = a.allocate(100);
+        exp::uninitialized_construct_n_using_allocator(range, 100, a, 8);
+        for (PmrType* q = range; q != range + 100; ++q) {
+            TEST_ASSERT(8 == q->value());
+            TEST_ASSERT(&mr == q->get_allocator().resource());
+        }
+        TEST_ASSERT(1 == upstream.m_allocs.size());
+    }
+
+    // Process-wide default resource
+    {
+        TEST_ASSERT(pmr::new_delete_resource() == pmr::get_default_resource());
+
+        CountingResource r;
+        TEST_ASSERT(pmr::new_delete_resource() ==
+                    pmr::set_default_resource(&r));
+        TEST_ASSERT(&r == pmr::get_default_resource());
+        TEST_ASSERT(&r == pmr::polymorphic_allocator<int>().resource());
+
+        pmr::monotonic_buffer_resource mr;
+        TEST_ASSERT(&r == mr.upstream_resource());
+
+        TEST_ASSERT(&r == pmr::set_default_resource(nullptr));
+        TEST_ASSERT(pmr::new_delete_resource() == pmr::get_default_resource());
+    }
+
+    // A scoped default resource routes every allocation made without an
+    // explicit allocator on this thread to a per-request arena.
+    {
+        CountingResource upstream;
+        pmr::monotonic_buffer_resource arena(&upstream);
+        {
+            pmr::scoped_default_resource guard(&arena);
+            TEST_ASSERT(&arena == pmr::get_default_resource());
+
+            PmrType obj = pmr::make_obj_using_default_resource<PmrType>(3);
+            TEST_ASSERT(3 == obj.value());
+            TEST_ASSERT(&arena == obj.get_allocator().resource());
+
+            typedef std::pair<PmrType, int> Pair;
+            Pair pr = pmr::make_obj_using_default_resource<Pair>(4, 5);
+            TEST_ASSERT(&arena == pr.first.get_allocator().resource());
+
+            pmr::polymorphic_allocator<int> a;
+            TEST_ASSERT(&arena == a.resource());
+            a.allocate(10);
+
+            // Guards nest
+            pmr::monotonic_buffer_resource inner;
+            {
+                pmr::scoped_default_resource guard2(&inner);
+                TEST_ASSERT(&inner == pmr::get_default_resource());
+            }
+            TEST_ASSERT(&arena == pmr::get_default_resource());
+
+            // Other threads are unaffected
+            pmr::memory_resource* other = nullptr;
+            std::thread th([&]() { other = pmr::get_default_resource(); });
+            th.join();
+            TEST_ASSERT(pmr::new_delete_resource() == other);
+
+            TEST_ASSERT(1 == upstream.outstanding());
+        }
+        TEST_ASSERT(pmr::new_delete_resource() == pmr::get_default_resource());
+
+        // The whole request is freed at once
+        arena.release();
+        TEST_ASSERT(0 == upstream.outstanding());
+    }
+
+    // Nested guards on one thread do not leak into another thread, whose
+    // own guards nest independently while this thread's are active.
+    {
+        typedef pmr::memory_resource* Rsrc;
+        pmr::monotonic_buffer_resource outer, inner, theirs, theirsInner;
+        std::atomic<int> step(0);
+        Rsrc before = nullptr, beforeObj = nullptr;
+        Rsrc during = nullptr, duringObj = nullptr, after = nullptr;
+        {
+            pmr::scoped_default_resource guard1(&outer);
+            pmr::scoped_default_resource guard2(&inner);
+
+            std::thread th([&]() {
+                before = pmr::get_default_resource();
+                beforeObj = pmr::make_obj_using_default_resource<PmrType>(1)
+                                .get_allocator().resource();
+                pmr::scoped_default_resource t1(&theirs);
+                {
+                    pmr::scoped_default_resource t2(&theirsInner);
+                    step = 1;
+                    while (2 != step)
+                        std::this_thread::yield();
+                    during = pmr::get_default_resource();
+                    duringObj =
+                        pmr::make_obj_using_default_resource<PmrType>(2)
+                            .get_allocator().resource();
+                }
+                after = pmr::get_default_resource();
+            });
+
+            while (1 != step)
+                std::this_thread::yield();
+            TEST_ASSERT(&inner == pmr::get_default_resource());
+            PmrType mine = pmr::make_obj_using_default_resource<PmrType>(3);
+            TEST_ASSERT(&inner == mine.get_allocator().resource());
+            step = 2;
+            th.join();
+
+            TEST_ASSERT(pmr::new_delete_resource() == before);
+            TEST_ASSERT(pmr::new_delete_resource() == beforeObj);
+            TEST_ASSERT(&theirsInner == during);
+            TEST_ASSERT(&theirsInner == duringObj);
+            TEST_ASSERT(&theirs == after);
+            TEST_ASSERT(&inner == pmr::get_default_resource());
+        }
+        TEST_ASSERT(pmr::new_delete_resource() == pmr::get_default_resource());
+    }
+
+    return errorCount();
+}
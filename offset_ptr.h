@@ -0,0 +1,188 @@
+/* offset_ptr.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `offset_ptr`, a fancy pointer that stores the distance from itself to the
+ * object it points to, so that data structures linked with it remain valid
+ * when the memory that holds them is mapped at a different address
+ * (extension).
+ */
+
+#ifndef INCLUDED_OFFSET_PTR_DOT_H
+#define INCLUDED_OFFSET_PTR_DOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// Stand-in for `T&` in `offset_ptr<void>::pointer_to`.
+struct offset_ptr_no_reference { };
+
+} // close namespace internal
+
+// Pointer to `T` stored as the offset in bytes from the `offset_ptr` object
+// itself to the target.  Copying an `offset_ptr` recomputes the offset, so
+// the copy points to the same object; copying the bytes of a structure that
+// contains both an `offset_ptr` and its target (e.g., by mapping the same
+// file at another address) yields a pointer to the copied target.  The
+// null pointer is represented by an offset of 1, which cannot address a
+// distinct object.  Meets the requirements of a random-access iterator and
+// of an allocator's `pointer` type.
+template <class T>
+class offset_ptr
+{
+    template <class> friend class offset_ptr;
+
+    ptrdiff_t m_offset;
+
+    static constexpr ptrdiff_t null_offset = 1;
+
+    ptrdiff_t offset_to(const volatile void* p) const noexcept {
+        return p ? reinterpret_cast<intptr_t>(p) -
+                   reinterpret_cast<intptr_t>(this) : null_offset;
+    }
+
+    template <class U>
+    using enable_if_convertible = enable_if_t<is_convertible<U*, T*>::value>;
+
+    template <class U>
+    using enable_if_explicit = enable_if_t<
+        ! is_convertible<U*, T*>::value &&
+        is_same<decltype(static_cast<T*>(declval<U*>())), T*>::value>;
+
+public:
+    typedef T                          element_type;
+    typedef remove_cv_t<T>             value_type;
+    typedef ptrdiff_t                  difference_type;
+    typedef add_lvalue_reference_t<T>  reference;
+    typedef offset_ptr                 pointer;
+    typedef random_access_iterator_tag iterator_category;
+
+    template <class U> using rebind = offset_ptr<U>;
+
+    offset_ptr() noexcept : m_offset(null_offset) { }
+    offset_ptr(nullptr_t) noexcept : m_offset(null_offset) { }
+    offset_ptr(T* p) noexcept : m_offset(offset_to(p)) { }
+
+    offset_ptr(const offset_ptr& other) noexcept
+        : m_offset(offset_to(other.get())) { }
+
+    template <class U, class = enable_if_convertible<U>>
+    offset_ptr(const offset_ptr<U>& other) noexcept
+        : m_offset(offset_to(static_cast<T*>(other.get()))) { }
+
+    // Conversions that require `static_cast`, e.g., from `offset_ptr<void>`.
+    template <class U, class = enable_if_explicit<U>, class = void>
+    explicit offset_ptr(const offset_ptr<U>& other) noexcept
+        : m_offset(offset_to(static_cast<T*>(other.get()))) { }
+
+    offset_ptr& operator=(const offset_ptr& rhs) noexcept {
+        m_offset = offset_to(rhs.get());
+        return *this;
+    }
+
+    offset_ptr& operator=(T* p) noexcept {
+        m_offset = offset_to(p);
+        return *this;
+    }
+
+    offset_ptr& operator=(nullptr_t) noexcept {
+        m_offset = null_offset;
+        return *this;
+    }
+
+    // Return a pointer to `r`.
+    static offset_ptr pointer_to(conditional_t<is_void<T>::value,
+                                     internal::offset_ptr_no_reference,
+                                     T>& r) noexcept {
+        return offset_ptr(std::addressof(r));
+    }
+
+    T* get() const noexcept {
+        return null_offset == m_offset ? nullptr : reinterpret_cast<T*>(
+            reinterpret_cast<intptr_t>(this) + m_offset);
+    }
+
+    reference operator*() const noexcept { return *get(); }
+    T* operator->() const noexcept { return get(); }
+    reference operator[](ptrdiff_t i) const noexcept { return get()[i]; }
+
+    explicit operator bool() const noexcept
+        { return null_offset != m_offset; }
+
+    offset_ptr& operator+=(ptrdiff_t n) noexcept {
+        m_offset += n * ptrdiff_t(sizeof(T));
+        return *this;
+    }
+
+    offset_ptr& operator-=(ptrdiff_t n) noexcept {
+        m_offset -= n * ptrdiff_t(sizeof(T));
+        return *this;
+    }
+
+    offset_ptr& operator++() noexcept { return *this += 1; }
+    offset_ptr& operator--() noexcept { return *this -= 1; }
+
+    offset_ptr operator++(int) noexcept {
+        offset_ptr ret(*this);
+        ++*this;
+        return ret;
+    }
+
+    offset_ptr operator--(int) noexcept {
+        offset_ptr ret(*this);
+        --*this;
+        return ret;
+    }
+
+    friend offset_ptr operator+(offset_ptr p, ptrdiff_t n) noexcept
+        { return p += n; }
+    friend offset_ptr operator+(ptrdiff_t n, offset_ptr p) noexcept
+        { return p += n; }
+    friend offset_ptr operator-(offset_ptr p, ptrdiff_t n) noexcept
+        { return p -= n; }
+    friend ptrdiff_t operator-(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return a.get() - b.get(); }
+
+    friend bool operator==(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return a.get() == b.get(); }
+    friend bool operator!=(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return a.get() != b.get(); }
+    friend bool operator<(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return less<T*>()(a.get(), b.get()); }
+    friend bool operator>(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return b < a; }
+    friend bool operator<=(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return ! (b < a); }
+    friend bool operator>=(const offset_ptr& a, const offset_ptr& b)
+        noexcept { return ! (a < b); }
+
+    friend bool operator==(const offset_ptr& a, nullptr_t) noexcept
+        { return ! a; }
+    friend bool operator==(nullptr_t, const offset_ptr& a) noexcept
+        { return ! a; }
+    friend bool operator!=(const offset_ptr& a, nullptr_t) noexcept
+        { return bool(a); }
+    friend bool operator!=(nullptr_t, const offset_ptr& a) noexcept
+        { return bool(a); }
+
+    friend void swap(offset_ptr& a, offset_ptr& b) noexcept {
+        T* const pa = a.get();
+        a = b.get();
+        b = pa;
+    }
+};
+
+} // close namespace Cpp20
+} // close namespace std
+
+#endif // ! defined(INCLUDED_OFFSET_PTR_DOT_H)
@@ -0,0 +1,125 @@
+/* offset_ptr.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <offset_ptr.h>
+
+#include <uses_allocator.h>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include <test_assert.h>
+
+namespace exp = std::Cpp20;
+
+// A node and a pointer to it, in one block of memory.
+struct Linked
+{
+    int                   m_values[4];
+    exp::offset_ptr<int>  m_third;
+};
+
+// Allocator-aware type taking the allocator as a trailing argument.
+struct Tracked
+{
+    typedef std::allocator<char> allocator_type;
+
+    int  m_value;
+    bool m_gotAlloc;
+
+    Tracked(int v, const allocator_type&) : m_value(v), m_gotAlloc(true) { }
+};
+
+int main()
+{
+    // Null pointers
+    {
+        exp::offset_ptr<int> p;
+        TEST_ASSERT(! p);
+        TEST_ASSERT(p == nullptr);
+        TEST_ASSERT(nullptr == p.get());
+
+        int x = 1;
+        p = &x;
+        TEST_ASSERT(p);
+        TEST_ASSERT(p != nullptr);
+        p = nullptr;
+        TEST_ASSERT(! p);
+    }
+
+    // Copies point to the same object; arithmetic and comparison
+    {
+        int a[5] = { 10, 11, 12, 13, 14 };
+        exp::offset_ptr<int> p(a);
+        exp::offset_ptr<int> q(p);
+        TEST_ASSERT(a == q.get());
+        TEST_ASSERT(12 == p[2]);
+        TEST_ASSERT(14 == *(p + 4));
+        TEST_ASSERT(13 == *(3 + p));
+        ++q;
+        TEST_ASSERT(11 == *q);
+        TEST_ASSERT(1 == q - p);
+        TEST_ASSERT(p < q && q > p && p <= p && q >= p);
+        q += 3;
+        TEST_ASSERT(14 == *q--);
+        TEST_ASSERT(13 == *q);
+        q -= 3;
+        TEST_ASSERT(q == p);
+        swap(p, q);
+        TEST_ASSERT(a == p.get() && a == q.get());
+    }
+
+    // Conversions, including through `void`
+    {
+        int x = 3;
+        exp::offset_ptr<int> p(&x);
+        exp::offset_ptr<const int> cp(p);
+        exp::offset_ptr<void> vp(p);
+        exp::offset_ptr<int> back = static_cast<exp::offset_ptr<int>>(vp);
+        TEST_ASSERT(&x == cp.get());
+        TEST_ASSERT(&x == vp.get());
+        TEST_ASSERT(3 == *back);
+    }
+
+    // `pointer_traits`
+    {
+        typedef std::pointer_traits<exp::offset_ptr<int>> PT;
+        static_assert(std::is_same<PT::element_type, int>::value, "");
+        static_assert(std::is_same<PT::rebind<long>,
+                                   exp::offset_ptr<long>>::value, "");
+        int x = 4;
+        TEST_ASSERT(&x == PT::pointer_to(x).get());
+    }
+
+    // Copying the bytes of a block relocates its internal pointers
+    {
+        alignas(Linked) unsigned char buf1[sizeof(Linked)];
+        alignas(Linked) unsigned char buf2[sizeof(Linked)];
+        Linked* l1 = ::new(buf1) Linked{ { 1, 2, 3, 4 }, nullptr };
+        l1->m_third = &l1->m_values[2];
+        std::memcpy(buf2, buf1, sizeof(Linked));
+        Linked* l2 = reinterpret_cast<Linked*>(buf2);
+        TEST_ASSERT(&l2->m_values[2] == l2->m_third.get());
+        l2->m_values[2] = 30;
+        TEST_ASSERT(30 == *l2->m_third);
+        TEST_ASSERT(3 == *l1->m_third);
+    }
+
+    // Uses-allocator construction and destruction through a fancy pointer
+    {
+        alignas(Tracked) unsigned char buf[sizeof(Tracked)];
+        exp::offset_ptr<Tracked> p(reinterpret_cast<Tracked*>(buf));
+        std::allocator<char> a;
+        exp::offset_ptr<Tracked> r =
+            exp::uninitialized_construct_using_allocator(p, a, 5);
+        TEST_ASSERT(r == p);
+        TEST_ASSERT(5 == p->m_value);
+        TEST_ASSERT(p->m_gotAlloc);
+        TEST_ASSERT(p + 1 == exp::destroy_n_using_allocator(p, 1, a));
+    }
+
+    return errorCount();
+}
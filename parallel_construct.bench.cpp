@@ -0,0 +1,104 @@
+/* parallel_construct.bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Benchmark of `parallel_uninitialized_construct_using_allocator` building
+ * a batch of `iterations() / 8` allocator-aware objects, each allocating a
+ * small block from a per-worker `monotonic_buffer_resource`.  The `serial`
+ * row constructs the batch on the calling thread from a single arena and is
+ * the baseline.  Reports the wall-clock time per object, which perfect
+ * scaling halves each time the number of workers doubles (up to the number
+ * of cores).
+ */
+
+#include <parallel_construct.h>
+
+#include <bench.h>
+#include <memory_resource.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware type that owns a small heap block, like a string that
+// does not fit in a small-string buffer.
+class Payload
+{
+    pmr::polymorphic_allocator<char> m_alloc;
+    char*                            m_data;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static constexpr std::size_t k_SIZE = 48;
+
+    Payload(int v, const allocator_type& a)
+        : m_alloc(a), m_data(m_alloc.allocate(k_SIZE)) {
+        m_data[0] = char(v);
+    }
+
+    ~Payload() { m_alloc.deallocate(m_data, k_SIZE); }
+
+    char value() const { return m_data[0]; }
+};
+
+typedef std::vector<std::unique_ptr<pmr::monotonic_buffer_resource>> Arenas;
+
+Arenas makeArenas(std::size_t n)
+{
+    Arenas ret;
+    for (std::size_t i = 0; i < n; ++i)
+        ret.emplace_back(new pmr::monotonic_buffer_resource);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    bench::parseArgs(argc, argv);
+    bench::printHeader();
+
+    const long n = bench::iterations() / 8;
+    std::allocator<Payload> sa;
+    Payload* p = sa.allocate(std::size_t(n));
+
+    auto argsGen = [](std::size_t i) { return std::make_tuple(int(i)); };
+
+    {
+        Arenas arenas = makeArenas(1);
+        bench::runBatch("parallel_construct", "serial", n, [&]() {
+                pmr::polymorphic_allocator<Payload> a(arenas[0].get());
+                for (long i = 0; i < n; ++i)
+                    exp::uninitialized_construct_using_allocator(p + i, a,
+                                                                 int(i));
+            }, [&]() {
+                exp::internal::destroy_range(p, p + n);
+                arenas[0]->release();
+            });
+    }
+
+    const std::size_t hw = std::thread::hardware_concurrency();
+    const std::size_t maxWorkers = hw > 8 ? hw : 8;
+    for (std::size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        Arenas arenas = makeArenas(workers);
+        const std::string name = "workers_" + std::to_string(workers);
+        bench::runBatch("parallel_construct", name.c_str(), n, [&]() {
+                exp::parallel_uninitialized_construct_using_allocator(
+                    p, p + n, [&](std::size_t w) {
+                        return pmr::polymorphic_allocator<Payload>(
+                                                           arenas[w].get());
+                    }, argsGen, workers);
+            }, [&]() {
+                exp::internal::destroy_range(p, p + n);
+                for (auto& arena : arenas)
+                    arena->release();
+            });
+    }
+
+    sa.deallocate(p, std::size_t(n));
+    return 0;
+}
@@ -0,0 +1,156 @@
+/* parallel_construct.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `parallel_uninitialized_construct_using_allocator`, which constructs a
+ * range of objects using uses-allocator construction on several threads,
+ * each with its own allocator (extension).
+ */
+
+#ifndef INCLUDED_PARALLEL_CONSTRUCT_DOT_H
+#define INCLUDED_PARALLEL_CONSTRUCT_DOT_H
+
+#include <uses_allocator.h>
+#include <make_from_tuple.h>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// The part of a parallel construction assigned to one worker: the indexes
+// `[m_begin, m_end)`, the number of objects constructed so far starting at
+// `m_begin`, and the exception that stopped the worker, if any.
+struct parallel_construct_chunk {
+    size_t        m_begin;
+    size_t        m_end;
+    size_t        m_constructed;
+    exception_ptr m_error;
+};
+
+// Construct the objects of `chunk` at `first + i`, using uses-allocator
+// construction with the allocator returned by `alloc_factory(worker)` and
+// the arguments in the tuple returned by `args_gen(i)`.  Stops early if
+// another worker has set `failed`, and sets it on exception.
+template <class T, class AllocFactory, class ArgsGen>
+void parallel_construct_run(T* first, parallel_construct_chunk& chunk,
+                            AllocFactory& alloc_factory, ArgsGen& args_gen,
+                            size_t worker, atomic<bool>& failed) noexcept
+{
+    try {
+        const auto a = alloc_factory(worker);
+        for (size_t i = chunk.m_begin; i < chunk.m_end; ++i) {
+            if (failed.load(memory_order_relaxed))
+                return;
+            T* p = first + i;
+            apply([p, &a](auto&&... args) {
+                    Cpp20::uninitialized_construct_using_allocator(
+                        p, a, std::forward<decltype(args)>(args)...);
+                }, args_gen(i));
+            ++chunk.m_constructed;
+        }
+    }
+    catch (...) {
+        chunk.m_error = current_exception();
+        failed.store(true, memory_order_relaxed);
+    }
+}
+
+// Destroy the objects constructed by every worker.
+template <class T>
+void parallel_construct_rollback(
+                      T* first, const vector<parallel_construct_chunk>& chunks)
+{
+    for (const parallel_construct_chunk& chunk : chunks)
+        destroy_range(first + chunk.m_begin,
+                      first + chunk.m_begin + chunk.m_constructed);
+}
+
+} // close namespace internal
+
+// Return the default number of workers used by
+// `parallel_uninitialized_construct_using_allocator`: the number of hardware
+// threads, or 1 if unknown.
+inline size_t parallel_construct_default_workers()
+{
+    const unsigned n = thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Construct an object of type `T` at each `first + i` in the uninitialized
+// range `[first, last)` using uses-allocator construction with the
+// arguments in the tuple returned by `args_gen(i)`.  The range is split into
+// `num_workers` contiguous chunks (fewer if there are fewer objects), each
+// constructed on its own thread, with the calling thread doing the first.
+// Each worker calls `alloc_factory(w)`, where `w < num_workers` is its
+// index, to get the allocator for its chunk, so that e.g. each worker can
+// allocate from its own unsynchronized arena; the allocators, and any
+// resources they refer to, must outlive the objects.  `alloc_factory` and
+// `args_gen` are called concurrently from several threads.  If any
+// constructor (or call to `alloc_factory` or `args_gen`) throws, the other
+// workers stop, every object already constructed is destroyed, and the
+// exception from the lowest-numbered failing worker is rethrown.  Returns
+// `last`.
+template <class T, class AllocFactory, class ArgsGen>
+T* parallel_uninitialized_construct_using_allocator(
+                     T* first, T* last, AllocFactory alloc_factory,
+                     ArgsGen args_gen,
+                     size_t num_workers = parallel_construct_default_workers())
+{
+    const size_t n = size_t(last - first);
+    if (num_workers > n)
+        num_workers = n;
+    if (num_workers == 0)
+        return last;
+
+    vector<internal::parallel_construct_chunk> chunks(num_workers);
+    for (size_t w = 0; w < num_workers; ++w) {
+        chunks[w].m_begin = n * w / num_workers;
+        chunks[w].m_end = n * (w + 1) / num_workers;
+        chunks[w].m_constructed = 0;
+    }
+
+    atomic<bool> failed(false);
+    auto work = [&](size_t w) {
+        internal::parallel_construct_run(first, chunks[w], alloc_factory,
+                                         args_gen, w, failed);
+    };
+
+    vector<thread> threads;
+    try {
+        threads.reserve(num_workers - 1);
+        for (size_t w = 1; w < num_workers; ++w)
+            threads.emplace_back(work, w);
+    }
+    catch (...) {
+        // Could not start a thread: stop the workers already running.
+        failed.store(true, memory_order_relaxed);
+        for (thread& th : threads)
+            th.join();
+        internal::parallel_construct_rollback(first, chunks);
+        throw;
+    }
+    work(0);
+    for (thread& th : threads)
+        th.join();
+
+    for (const internal::parallel_construct_chunk& chunk : chunks) {
+        if (chunk.m_error) {
+            internal::parallel_construct_rollback(first, chunks);
+            rethrow_exception(chunk.m_error);
+        }
+    }
+    return last;
+}
+
+} // close namespace Cpp20
+} // close namespace std
+
+#endif // ! defined(INCLUDED_PARALLEL_CONSTRUCT_DOT_H)
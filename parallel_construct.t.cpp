@@ -0,0 +1,185 @@
+/* parallel_construct.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <parallel_construct.h>
+
+#include <stats_resource.h>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware type that allocates a block from its resource.  The
+// constructor throws if the value is `s_throwOn`.
+class Element
+{
+    pmr::polymorphic_allocator<int> m_alloc;
+    int*                            m_data;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static std::atomic<int> s_live;
+    static int              s_throwOn;
+
+    Element(int v, const allocator_type& a)
+        : m_alloc(a), m_data(nullptr) {
+        if (v == s_throwOn)
+            throw v;
+        m_data = m_alloc.allocate(4);
+        m_data[0] = v;
+        ++s_live;
+    }
+
+    ~Element() {
+        m_alloc.deallocate(m_data, 4);
+        --s_live;
+    }
+
+    pmr::memory_resource* resource() const { return m_alloc.resource(); }
+    int value() const { return m_data[0]; }
+};
+
+std::atomic<int> Element::s_live(0);
+int              Element::s_throwOn = -1;
+
+// Per-worker arenas, with an allocator factory that returns the one for a
+// worker.
+struct Arenas
+{
+    std::vector<std::unique_ptr<pmr::stats_resource>> m_arenas;
+
+    explicit Arenas(std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i)
+            m_arenas.emplace_back(new pmr::stats_resource);
+    }
+
+    pmr::stats_resource* operator[](std::size_t w) const
+        { return m_arenas[w].get(); }
+
+    std::size_t liveBytes() const {
+        std::size_t ret = 0;
+        for (const auto& a : m_arenas)
+            ret += a->snapshot().live_bytes;
+        return ret;
+    }
+
+    // Return a factory returning an allocator for worker `w`'s arena.
+    auto factory() const {
+        return [this](std::size_t w) {
+            return pmr::polymorphic_allocator<Element>((*this)[w]);
+        };
+    }
+};
+
+int main()
+{
+    using exp::parallel_uninitialized_construct_using_allocator;
+
+    auto argsGen = [](std::size_t i) { return std::make_tuple(int(i)); };
+
+    TEST_ASSERT(exp::parallel_construct_default_workers() >= 1);
+
+    // Each worker constructs a contiguous chunk with its own allocator
+    {
+        const std::size_t n = 1000, workers = 4;
+        Arenas arenas(workers);
+        std::allocator<Element> sa;
+        Element* p = sa.allocate(n);
+
+        Element* end = parallel_uninitialized_construct_using_allocator(
+            p, p + n, arenas.factory(), argsGen, workers);
+        TEST_ASSERT(p + n == end);
+        TEST_ASSERT(n == Element::s_live);
+        for (std::size_t i = 0; i < n; ++i) {
+            TEST_ASSERT(int(i) == p[i].value());
+            TEST_ASSERT(arenas[i * workers / n] == p[i].resource());
+        }
+        for (std::size_t w = 0; w < workers; ++w)
+            TEST_ASSERT(n / workers == arenas[w]->snapshot().allocations);
+
+        exp::internal::destroy_range(p, p + n);
+        sa.deallocate(p, n);
+        TEST_ASSERT(0 == Element::s_live);
+        TEST_ASSERT(0 == arenas.liveBytes());
+    }
+
+    // Empty ranges and more workers than objects
+    {
+        Arenas arenas(8);
+        std::allocator<Element> sa;
+        Element* p = sa.allocate(3);
+
+        TEST_ASSERT(p == parallel_uninitialized_construct_using_allocator(
+                             p, p, arenas.factory(), argsGen, 8));
+        TEST_ASSERT(0 == Element::s_live);
+
+        parallel_uninitialized_construct_using_allocator(
+            p, p + 3, arenas.factory(), argsGen, 8);
+        TEST_ASSERT(3 == Element::s_live);
+        for (std::size_t i = 0; i < 3; ++i)
+            TEST_ASSERT(arenas[i] == p[i].resource());
+        TEST_ASSERT(0 == arenas[3]->snapshot().allocations);
+
+        exp::internal::destroy_range(p, p + 3);
+        sa.deallocate(p, 3);
+    }
+
+    // A failure in one worker rolls back the objects built by all of them
+    {
+        const std::size_t n = 1000, workers = 4;
+        Arenas arenas(workers);
+        std::allocator<Element> sa;
+        Element* p = sa.allocate(n);
+
+        Element::s_throwOn = 777;
+        bool caught = false;
+        try {
+            parallel_uninitialized_construct_using_allocator(
+                p, p + n, arenas.factory(), argsGen, workers);
+        }
+        catch (int v) {
+            caught = true;
+            TEST_ASSERT(777 == v);
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(0 == Element::s_live);
+        TEST_ASSERT(0 == arenas.liveBytes());
+        Element::s_throwOn = -1;
+
+        sa.deallocate(p, n);
+    }
+
+    // Pair elements get the worker's allocator through uses-allocator
+    // construction
+    {
+        typedef std::pair<Element, int> ElemPair;
+        const std::size_t n = 100, workers = 2;
+        Arenas arenas(workers);
+        std::allocator<ElemPair> sa;
+        ElemPair* p = sa.allocate(n);
+
+        parallel_uninitialized_construct_using_allocator(
+            p, p + n, arenas.factory(),
+            [](std::size_t i) { return std::make_tuple(int(i), -int(i)); },
+            workers);
+        for (std::size_t i = 0; i < n; ++i) {
+            TEST_ASSERT(int(i) == p[i].first.value());
+            TEST_ASSERT(-int(i) == p[i].second);
+            TEST_ASSERT(arenas[i * workers / n] == p[i].first.resource());
+        }
+
+        exp::internal::destroy_range(p, p + n);
+        sa.deallocate(p, n);
+        TEST_ASSERT(0 == arenas.liveBytes());
+    }
+
+    return errorCount();
+}
@@ -0,0 +1,588 @@
+/* pmr_function.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `pmr::pmr_function` and `pmr::pmr_any`, type-erasing wrappers with a
+ * configurable inline buffer that obtain storage for larger objects from a
+ * `polymorphic_allocator` and construct the wrapped object by uses-allocator
+ * construction (extension).
+ */
+
+#ifndef INCLUDED_PMR_FUNCTION_DOT_H
+#define INCLUDED_PMR_FUNCTION_DOT_H
+
+#include <memory_resource.h>
+#include <uses_allocator.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <typeinfo>
+#include <utility>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// Storage for a type-erased object: either the object itself, in an inline
+// buffer of at least `InlineSize` bytes, or a pointer to a block obtained
+// from the wrapper's allocator.
+template <size_t InlineSize>
+union alignas(max_align_t) erased_storage
+{
+    void*         m_heap;
+    unsigned char m_buffer[InlineSize ? InlineSize : 1];
+};
+
+// True if an object of type `D` is kept in the inline buffer of an
+// `erased_storage<InlineSize>`.  Moving a `D` by uses-allocator
+// construction must also not throw, so that moving a wrapper between equal
+// allocators never throws.
+template <class D, size_t InlineSize>
+using is_inline_storable =
+    boolean_constant<sizeof(D) <= sizeof(erased_storage<InlineSize>) &&
+                     alignof(D) <= alignof(erased_storage<InlineSize>) &&
+                     is_nothrow_uses_allocator_constructible<D,
+                         experimental::pmr::polymorphic_allocator<>,
+                         D&&>::value>;
+
+// Table of operations on a type-erased object.  All objects of one type
+// share a single table, so the table's address identifies the type.
+template <size_t InlineSize>
+struct erased_ops
+{
+    typedef erased_storage<InlineSize>                 storage;
+    typedef experimental::pmr::polymorphic_allocator<> allocator;
+
+    void (*m_destroy)(storage& s, const allocator& a);
+    void (*m_copy)(const storage& from, storage& to, const allocator& a);
+    void (*m_move)(storage& from, storage& to,
+                   const allocator& from_alloc, const allocator& to_alloc);
+    const type_info& (*m_type)();
+};
+
+// Operations on an object of type `D` held in an `erased_storage`.
+template <class D, size_t InlineSize>
+struct erased_handler
+{
+    typedef erased_storage<InlineSize>                  storage;
+    typedef experimental::pmr::polymorphic_allocator<>  allocator;
+    typedef experimental::pmr::polymorphic_allocator<D> block_allocator;
+    typedef is_inline_storable<D, InlineSize>           is_inline;
+
+    static D* get(true_type, storage& s) noexcept
+        { return reinterpret_cast<D*>(s.m_buffer); }
+    static D* get(false_type, storage& s) noexcept
+        { return static_cast<D*>(s.m_heap); }
+    static D* get(storage& s) noexcept { return get(is_inline(), s); }
+
+    template <class... Args>
+    static void create(true_type, storage& s, const allocator& a,
+                       Args&&... args) {
+        Cpp20::uninitialized_construct_using_allocator(
+            get(true_type(), s), a, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    static void create(false_type, storage& s, const allocator& a,
+                       Args&&... args) {
+        block_allocator ba(a);
+        D* p = ba.allocate(1);
+        try {
+            Cpp20::uninitialized_construct_using_allocator(
+                p, a, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            ba.deallocate(p, 1);
+            throw;
+        }
+        s.m_heap = p;
+    }
+
+    // Construct a `D` in `s` from `args` by uses-allocator construction with
+    // `a`, in the inline buffer if it fits and otherwise in a block obtained
+    // from `a`.
+    template <class... Args>
+    static void create(storage& s, const allocator& a, Args&&... args) {
+        create(is_inline(), s, a, std::forward<Args>(args)...);
+    }
+
+    static void destroy(storage& s, const allocator& a) {
+        D* p = get(s);
+        p->~D();
+        if (! is_inline::value)
+            block_allocator(a).deallocate(p, 1);
+    }
+
+    static void copy(const storage& from, storage& to, const allocator& a) {
+        create(to, a,
+               static_cast<const D&>(*get(const_cast<storage&>(from))));
+    }
+
+    // Move the object in `from`, which was created with `from_alloc`, into
+    // `to`, using `to_alloc`, and destroy the original.  A block obtained
+    // from the allocator changes hands without touching the object if the
+    // allocators are equal.
+    static void move(storage& from, storage& to,
+                     const allocator& from_alloc, const allocator& to_alloc) {
+        if (! is_inline::value && from_alloc == to_alloc) {
+            to.m_heap = from.m_heap;
+            return;
+        }
+        create(to, to_alloc, std::move(*get(from)));
+        destroy(from, from_alloc);
+    }
+
+    static const type_info& type() { return typeid(D); }
+
+    static const erased_ops<InlineSize>* ops() noexcept {
+        static const erased_ops<InlineSize> table = {
+            &destroy, &copy, &move, &type
+        };
+        return &table;
+    }
+};
+
+// Calls the `D` held in an `erased_storage` with arguments of types
+// `Args...`, converting the result to `R` (or discarding it if `R` is
+// `void`).
+template <class D, size_t InlineSize, class R, class... Args>
+struct erased_invoker
+{
+    typedef erased_handler<D, InlineSize> handler;
+
+    static void invoke(true_type, erased_storage<InlineSize>& s,
+                       Args&&... args)
+        { (*handler::get(s))(std::forward<Args>(args)...); }
+
+    static R invoke(false_type, erased_storage<InlineSize>& s,
+                    Args&&... args)
+        { return (*handler::get(s))(std::forward<Args>(args)...); }
+
+    static R invoke(erased_storage<InlineSize>& s, Args&&... args)
+        { return invoke(is_void<R>(), s, std::forward<Args>(args)...); }
+};
+
+// True if an lvalue of type `F` can be called with arguments of types
+// `Args...` and the result converted to `R`.
+template <class F, class Signature, class = void>
+struct is_callable_as : false_type { };
+
+template <class F, class R, class... Args>
+struct is_callable_as<F, R(Args...),
+                      decltype(void(declval<F&>()(declval<Args>()...)))>
+    : boolean_constant<is_void<R>::value ||
+                       is_convertible<decltype(declval<F&>()(
+                                          declval<Args>()...)), R>::value> { };
+
+} // close namespace internal
+
+} // close namespace Cpp20
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+// Polymorphic-allocator-aware replacement for `std::function`.  A callable
+// that fits in `InlineSize` bytes (and can be moved without throwing) is
+// stored inline; a larger one is placed in storage obtained from the
+// wrapper's allocator.  Either way, the callable is constructed by
+// uses-allocator construction with the wrapper's allocator, so an
+// allocator-aware callable and its allocator-aware members use the same
+// memory resource as the wrapper.  (A lambda is not allocator-aware, so its
+// captures are copied with their own allocators.)  A `pmr_function` is
+// called like the callable it wraps, so it can be passed wherever a
+// `function_ref` or a template callback of the same signature is expected.
+// As for other pmr types, the allocator is not propagated on assignment or
+// swap, and a copy uses the default resource unless an allocator is given.
+template <class Signature, size_t InlineSize = 3 * sizeof(void*)>
+class pmr_function;
+
+template <class R, class... Args, size_t InlineSize>
+class pmr_function<R(Args...), InlineSize>
+{
+    typedef Cpp20::internal::erased_storage<InlineSize> storage;
+    typedef Cpp20::internal::erased_ops<InlineSize>     ops;
+
+    template <class F>
+    using enable_if_callable = enable_if_t<
+        ! is_same<decay_t<F>, pmr_function>::value &&
+        Cpp20::internal::is_callable_as<decay_t<F>, R(Args...)>::value>;
+
+    polymorphic_allocator<> m_alloc;
+    mutable storage         m_storage;
+    const ops*              m_ops;    // Null if empty
+    R                     (*m_invoke)(storage&, Args&&...);
+
+    // Move the callable held by `other`, which must have an equal allocator,
+    // into this empty wrapper, leaving `other` empty.
+    void take(pmr_function& other) noexcept {
+        if (other.m_ops) {
+            other.m_ops->m_move(other.m_storage, m_storage,
+                                other.m_alloc, m_alloc);
+            m_ops = other.m_ops;
+            m_invoke = other.m_invoke;
+            other.m_ops = nullptr;
+        }
+    }
+
+public:
+    typedef R                       result_type;
+    typedef polymorphic_allocator<> allocator_type;
+
+    pmr_function() noexcept : m_ops(nullptr), m_invoke(nullptr) { }
+    pmr_function(nullptr_t) noexcept : pmr_function() { }
+
+    explicit pmr_function(allocator_arg_t, const allocator_type& a) noexcept
+        : m_alloc(a), m_ops(nullptr), m_invoke(nullptr) { }
+
+    pmr_function(allocator_arg_t, const allocator_type& a, nullptr_t) noexcept
+        : pmr_function(allocator_arg, a) { }
+
+    template <class F, class = enable_if_callable<F>>
+    pmr_function(F&& f)
+        : pmr_function(allocator_arg, allocator_type(), std::forward<F>(f)) { }
+
+    template <class F, class = enable_if_callable<F>>
+    pmr_function(allocator_arg_t, const allocator_type& a, F&& f)
+        : m_alloc(a), m_ops(nullptr), m_invoke(nullptr)
+    {
+        typedef decay_t<F> D;
+        static_assert(is_copy_constructible<D>::value,
+                      "pmr_function requires a copyable callable");
+        typedef Cpp20::internal::erased_handler<D, InlineSize> handler;
+        handler::create(m_storage, m_alloc, std::forward<F>(f));
+        m_ops = handler::ops();
+        m_invoke = &Cpp20::internal::erased_invoker<D, InlineSize, R,
+                                                    Args...>::invoke;
+    }
+
+    pmr_function(const pmr_function& other)
+        : pmr_function(allocator_arg,
+                       other.m_alloc.select_on_container_copy_construction(),
+                       other) { }
+
+    pmr_function(allocator_arg_t, const allocator_type& a,
+                 const pmr_function& other)
+        : m_alloc(a), m_ops(nullptr), m_invoke(other.m_invoke)
+    {
+        if (other.m_ops) {
+            other.m_ops->m_copy(other.m_storage, m_storage, m_alloc);
+            m_ops = other.m_ops;
+        }
+    }
+
+    pmr_function(pmr_function&& other) noexcept
+        : m_alloc(other.m_alloc), m_ops(nullptr), m_invoke(nullptr)
+        { take(other); }
+
+    pmr_function(allocator_arg_t, const allocator_type& a,
+                 pmr_function&& other)
+        : m_alloc(a), m_ops(nullptr), m_invoke(other.m_invoke)
+    {
+        if (other.m_ops) {
+            other.m_ops->m_move(other.m_storage, m_storage,
+                                other.m_alloc, m_alloc);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    ~pmr_function() { reset(); }
+
+    pmr_function& operator=(const pmr_function& rhs) {
+        if (this != &rhs) {
+            pmr_function tmp(allocator_arg, m_alloc, rhs);
+            reset();
+            take(tmp);
+        }
+        return *this;
+    }
+
+    pmr_function& operator=(pmr_function&& rhs) {
+        if (this != &rhs) {
+            pmr_function tmp(allocator_arg, m_alloc, std::move(rhs));
+            reset();
+            take(tmp);
+        }
+        return *this;
+    }
+
+    pmr_function& operator=(nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    template <class F, class = enable_if_callable<F>>
+    pmr_function& operator=(F&& f) {
+        pmr_function tmp(allocator_arg, m_alloc, std::forward<F>(f));
+        reset();
+        take(tmp);
+        return *this;
+    }
+
+    // Destroy the callable, if any, leaving the wrapper empty.
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->m_destroy(m_storage, m_alloc);
+            m_ops = nullptr;
+        }
+    }
+
+    // Exchange callables with `other`, which must have an equal allocator.
+    void swap(pmr_function& other) noexcept {
+        pmr_function tmp(allocator_arg, m_alloc);
+        tmp.take(*this);
+        take(other);
+        other.take(tmp);
+    }
+
+    R operator()(Args... args) const {
+        if (! m_ops)
+            throw bad_function_call();
+        return m_invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    const type_info& target_type() const noexcept
+        { return m_ops ? m_ops->m_type() : typeid(void); }
+
+    template <class T>
+    T* target() noexcept {
+        if (m_ops != Cpp20::internal::erased_handler<T, InlineSize>::ops())
+            return nullptr;
+        return Cpp20::internal::erased_handler<T, InlineSize>::get(m_storage);
+    }
+
+    template <class T>
+    const T* target() const noexcept {
+        return const_cast<pmr_function*>(this)->template target<T>();
+    }
+
+    allocator_type get_allocator() const noexcept { return m_alloc; }
+};
+
+template <class Signature, size_t InlineSize>
+inline void swap(pmr_function<Signature, InlineSize>& a,
+                 pmr_function<Signature, InlineSize>& b) noexcept
+{
+    a.swap(b);
+}
+
+template <class Signature, size_t InlineSize>
+inline bool operator==(const pmr_function<Signature, InlineSize>& f,
+                       nullptr_t) noexcept
+{
+    return ! f;
+}
+
+template <class Signature, size_t InlineSize>
+inline bool operator!=(const pmr_function<Signature, InlineSize>& f,
+                       nullptr_t) noexcept
+{
+    return static_cast<bool>(f);
+}
+
+// Polymorphic-allocator-aware replacement for `std::any`, using the same
+// storage strategy as `pmr_function`: a value that fits in `InlineSize`
+// bytes is stored inline, and a larger one in storage obtained from the
+// wrapper's allocator, constructed in either case by uses-allocator
+// construction with the wrapper's allocator.  The stored value is retrieved
+// with `any_cast`, which throws `bad_cast` on a type mismatch.
+template <size_t InlineSize = 3 * sizeof(void*)>
+class pmr_any
+{
+    typedef Cpp20::internal::erased_storage<InlineSize> storage;
+    typedef Cpp20::internal::erased_ops<InlineSize>     ops;
+
+    template <class T>
+    using enable_if_value = enable_if_t<! is_same<decay_t<T>, pmr_any>::value>;
+
+    template <class T, size_t N> friend T* any_cast(pmr_any<N>*) noexcept;
+
+    polymorphic_allocator<> m_alloc;
+    storage                 m_storage;
+    const ops*              m_ops;    // Null if empty
+
+    void take(pmr_any& other) noexcept {
+        if (other.m_ops) {
+            other.m_ops->m_move(other.m_storage, m_storage,
+                                other.m_alloc, m_alloc);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+public:
+    typedef polymorphic_allocator<> allocator_type;
+
+    pmr_any() noexcept : m_ops(nullptr) { }
+
+    explicit pmr_any(allocator_arg_t, const allocator_type& a) noexcept
+        : m_alloc(a), m_ops(nullptr) { }
+
+    template <class T, class = enable_if_value<T>>
+    pmr_any(T&& v)
+        : pmr_any(allocator_arg, allocator_type(), std::forward<T>(v)) { }
+
+    template <class T, class = enable_if_value<T>>
+    pmr_any(allocator_arg_t, const allocator_type& a, T&& v)
+        : m_alloc(a), m_ops(nullptr)
+        { emplace<decay_t<T>>(std::forward<T>(v)); }
+
+    pmr_any(const pmr_any& other)
+        : pmr_any(allocator_arg,
+                  other.m_alloc.select_on_container_copy_construction(),
+                  other) { }
+
+    pmr_any(allocator_arg_t, const allocator_type& a, const pmr_any& other)
+        : m_alloc(a), m_ops(nullptr)
+    {
+        if (other.m_ops) {
+            other.m_ops->m_copy(other.m_storage, m_storage, m_alloc);
+            m_ops = other.m_ops;
+        }
+    }
+
+    pmr_any(pmr_any&& other) noexcept
+        : m_alloc(other.m_alloc), m_ops(nullptr) { take(other); }
+
+    pmr_any(allocator_arg_t, const allocator_type& a, pmr_any&& other)
+        : m_alloc(a), m_ops(nullptr)
+    {
+        if (other.m_ops) {
+            other.m_ops->m_move(other.m_storage, m_storage,
+                                other.m_alloc, m_alloc);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    ~pmr_any() { reset(); }
+
+    pmr_any& operator=(const pmr_any& rhs) {
+        if (this != &rhs) {
+            pmr_any tmp(allocator_arg, m_alloc, rhs);
+            reset();
+            take(tmp);
+        }
+        return *this;
+    }
+
+    pmr_any& operator=(pmr_any&& rhs) {
+        if (this != &rhs) {
+            pmr_any tmp(allocator_arg, m_alloc, std::move(rhs));
+            reset();
+            take(tmp);
+        }
+        return *this;
+    }
+
+    template <class T, class = enable_if_value<T>>
+    pmr_any& operator=(T&& v) {
+        pmr_any tmp(allocator_arg, m_alloc, std::forward<T>(v));
+        reset();
+        take(tmp);
+        return *this;
+    }
+
+    // Replace the value with a `T` constructed from `args` by uses-allocator
+    // construction with this wrapper's allocator.  If construction throws,
+    // the wrapper is left empty.
+    template <class T, class... Args>
+    T& emplace(Args&&... args) {
+        typedef Cpp20::internal::erased_handler<T, InlineSize> handler;
+        static_assert(is_copy_constructible<T>::value,
+                      "pmr_any requires a copyable value");
+        reset();
+        handler::create(m_storage, m_alloc, std::forward<Args>(args)...);
+        m_ops = handler::ops();
+        return *handler::get(m_storage);
+    }
+
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->m_destroy(m_storage, m_alloc);
+            m_ops = nullptr;
+        }
+    }
+
+    // Exchange values with `other`, which must have an equal allocator.
+    void swap(pmr_any& other) noexcept {
+        pmr_any tmp(allocator_arg, m_alloc);
+        tmp.take(*this);
+        take(other);
+        other.take(tmp);
+    }
+
+    bool has_value() const noexcept { return m_ops != nullptr; }
+
+    const type_info& type() const noexcept
+        { return m_ops ? m_ops->m_type() : typeid(void); }
+
+    allocator_type get_allocator() const noexcept { return m_alloc; }
+};
+
+template <size_t InlineSize>
+inline void swap(pmr_any<InlineSize>& a, pmr_any<InlineSize>& b) noexcept
+{
+    a.swap(b);
+}
+
+// Return a pointer to the value held by `*a` if it has type `T`, and null
+// otherwise.
+template <class T, size_t InlineSize>
+inline T* any_cast(pmr_any<InlineSize>* a) noexcept
+{
+    typedef Cpp20::internal::erased_handler<remove_cv_t<T>,
+                                            InlineSize> handler;
+    if (! a || a->m_ops != handler::ops())
+        return nullptr;
+    return handler::get(a->m_storage);
+}
+
+template <class T, size_t InlineSize>
+inline const T* any_cast(const pmr_any<InlineSize>* a) noexcept
+{
+    return any_cast<const T>(const_cast<pmr_any<InlineSize>*>(a));
+}
+
+template <class T, size_t InlineSize>
+inline T any_cast(const pmr_any<InlineSize>& a)
+{
+    typedef remove_cv_t<remove_reference_t<T>> U;
+    const U* p = any_cast<U>(&a);
+    if (! p)
+        throw bad_cast();
+    return static_cast<T>(*p);
+}
+
+template <class T, size_t InlineSize>
+inline T any_cast(pmr_any<InlineSize>& a)
+{
+    typedef remove_cv_t<remove_reference_t<T>> U;
+    U* p = any_cast<U>(&a);
+    if (! p)
+        throw bad_cast();
+    return static_cast<T>(*p);
+}
+
+template <class T, size_t InlineSize>
+inline T any_cast(pmr_any<InlineSize>&& a)
+{
+    typedef remove_cv_t<remove_reference_t<T>> U;
+    U* p = any_cast<U>(&a);
+    if (! p)
+        throw bad_cast();
+    return static_cast<T>(std::move(*p));
+}
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_PMR_FUNCTION_DOT_H)
@@ -0,0 +1,283 @@
+/* pmr_function.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <pmr_function.h>
+
+#include <stats_resource.h>
+#include <functional>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+
+typedef std::basic_string<char, std::char_traits<char>,
+                          pmr::polymorphic_allocator<char>> PmrString;
+
+// Allocator-aware callable, too large for the default inline buffer, that
+// appends its argument to a prefix.
+class Appender
+{
+    PmrString m_prefix;
+
+public:
+    typedef pmr::polymorphic_allocator<char> allocator_type;
+
+    static int s_live;
+
+    Appender(const char* prefix, const allocator_type& a = {})
+        : m_prefix(prefix, a) { ++s_live; }
+    Appender(const Appender& other, const allocator_type& a = {})
+        : m_prefix(other.m_prefix, a) { ++s_live; }
+    Appender(Appender&& other, const allocator_type& a)
+        : m_prefix(std::move(other.m_prefix), a) { ++s_live; }
+    ~Appender() { --s_live; }
+
+    std::size_t operator()(const char* s) { return (m_prefix += s).size(); }
+
+    pmr::memory_resource* resource() const
+        { return m_prefix.get_allocator().resource(); }
+};
+
+int Appender::s_live = 0;
+
+// Small allocator-aware value that fits in the inline buffer.
+struct Tagged
+{
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    allocator_type m_alloc;
+    int            m_value;
+
+    Tagged(std::allocator_arg_t, const allocator_type& a, int v) noexcept
+        : m_alloc(a), m_value(v) { }
+    Tagged(std::allocator_arg_t, const allocator_type& a,
+           const Tagged& other) noexcept
+        : m_alloc(a), m_value(other.m_value) { }
+    Tagged(const Tagged& other) noexcept
+        : m_alloc(), m_value(other.m_value) { }
+};
+
+// Callable whose copy constructor throws once `s_copiesLeft` reaches zero.
+struct ThrowingCopy
+{
+    static int s_copiesLeft;
+    char       m_padding[64];
+
+    ThrowingCopy() { }
+    ThrowingCopy(const ThrowingCopy&) {
+        if (0 == s_copiesLeft--)
+            throw 1;
+    }
+
+    int operator()() const { return 7; }
+};
+
+int ThrowingCopy::s_copiesLeft = 0;
+
+int main()
+{
+    // Small callables are stored inline
+    {
+        pmr::stats_resource sr;
+        int calls = 0;
+        pmr::pmr_function<int(int)> f(std::allocator_arg, &sr,
+                                      [&calls](int x) {
+                                          ++calls;
+                                          return x + 1;
+                                      });
+        TEST_ASSERT(f);
+        TEST_ASSERT(3 == f(2));
+        TEST_ASSERT(1 == calls);
+        TEST_ASSERT(0 == sr.snapshot().allocations);
+        TEST_ASSERT(&sr == f.get_allocator().resource());
+
+        pmr::pmr_function<void(int)> g(std::allocator_arg, &sr, f);
+        g(5);
+        TEST_ASSERT(2 == calls);
+
+        pmr::pmr_function<int(int)> empty;
+        TEST_ASSERT(! empty);
+        TEST_ASSERT(empty == nullptr);
+        TEST_ASSERT(typeid(void) == empty.target_type());
+        int caught = 0;
+        try {
+            empty(1);
+        }
+        catch (std::bad_function_call&) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+    }
+
+    // A callable that spills is built in storage from the wrapper's
+    // resource, and its allocator-aware members use the same resource
+    {
+        pmr::stats_resource sr;
+        {
+            pmr::pmr_function<std::size_t(const char*)> f(
+                std::allocator_arg, &sr, Appender("hello "));
+            TEST_ASSERT(1 == Appender::s_live);
+            TEST_ASSERT(11 == f("world"));
+            TEST_ASSERT(typeid(Appender) == f.target_type());
+            TEST_ASSERT(&sr == f.target<Appender>()->resource());
+            TEST_ASSERT(! f.target<int>());
+            TEST_ASSERT(1 <= sr.snapshot().allocations);
+            const std::size_t blocks = sr.snapshot().live_allocations;
+
+            // Moving between equal allocators transfers the block
+            pmr::pmr_function<std::size_t(const char*)> g(std::move(f));
+            TEST_ASSERT(! f);
+            TEST_ASSERT(1 == Appender::s_live);
+            TEST_ASSERT(blocks == sr.snapshot().live_allocations);
+            TEST_ASSERT(12 == g("!"));
+
+            // A copy with a different resource uses only that resource
+            pmr::stats_resource sr2;
+            pmr::pmr_function<std::size_t(const char*)> h(
+                std::allocator_arg, &sr2, g);
+            TEST_ASSERT(2 == Appender::s_live);
+            TEST_ASSERT(&sr2 == h.target<Appender>()->resource());
+            TEST_ASSERT(blocks == sr2.snapshot().live_allocations);
+            TEST_ASSERT(blocks == sr.snapshot().live_allocations);
+            TEST_ASSERT(13 == h("?"));
+            TEST_ASSERT(13 == g("?"));
+
+            // Assignment keeps the target's allocator
+            h = std::move(g);
+            TEST_ASSERT(&sr2 == h.get_allocator().resource());
+            TEST_ASSERT(&sr2 == h.target<Appender>()->resource());
+            TEST_ASSERT(1 == Appender::s_live);
+            TEST_ASSERT(14 == h("."));
+
+            h = nullptr;
+            TEST_ASSERT(0 == Appender::s_live);
+            TEST_ASSERT(0 == sr2.snapshot().live_bytes);
+        }
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    // Swap between equal allocators, inline and spilled callables
+    {
+        pmr::stats_resource sr;
+        pmr::pmr_function<std::size_t(const char*)> a(
+            std::allocator_arg, &sr, Appender("ab"));
+        pmr::pmr_function<std::size_t(const char*)> b(
+            std::allocator_arg, &sr,
+            [](const char*) { return std::size_t(); });
+        swap(a, b);
+        TEST_ASSERT(0 == a("x"));
+        TEST_ASSERT(3 == b("c"));
+        TEST_ASSERT(&sr == b.target<Appender>()->resource());
+    }
+    TEST_ASSERT(0 == Appender::s_live);
+
+    // A throwing copy leaves nothing behind
+    {
+        pmr::stats_resource sr;
+        ThrowingCopy::s_copiesLeft = 0;
+        int caught = 0;
+        try {
+            pmr::pmr_function<int()> f(std::allocator_arg, &sr,
+                                       ThrowingCopy());
+        }
+        catch (int) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+        TEST_ASSERT(1 == sr.snapshot().allocations);
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+
+        ThrowingCopy::s_copiesLeft = 1;
+        pmr::pmr_function<int()> f(std::allocator_arg, &sr, ThrowingCopy());
+        pmr::pmr_function<int()> g(std::allocator_arg, &sr, [] { return 1; });
+        try {
+            g = f;
+        }
+        catch (int) {
+            ++caught;
+        }
+        TEST_ASSERT(2 == caught);
+        TEST_ASSERT(1 == g());
+        TEST_ASSERT(7 == f());
+    }
+
+    // Configurable inline buffer
+    {
+        struct Big {
+            char m_bytes[64];
+            int operator()() const { return 8; }
+        };
+        pmr::stats_resource sr;
+        pmr::pmr_function<int()> f(std::allocator_arg, &sr, Big());
+        pmr::pmr_function<int(), 128> g(std::allocator_arg, &sr, Big());
+        TEST_ASSERT(1 == sr.snapshot().allocations);
+        TEST_ASSERT(8 == f());
+        TEST_ASSERT(8 == g());
+    }
+
+    // pmr_any: inline values get the allocator too
+    {
+        pmr::stats_resource sr;
+        pmr::pmr_any<> a(std::allocator_arg, &sr);
+        TEST_ASSERT(! a.has_value());
+        TEST_ASSERT(typeid(void) == a.type());
+
+        a = 5;
+        TEST_ASSERT(a.has_value());
+        TEST_ASSERT(typeid(int) == a.type());
+        TEST_ASSERT(5 == pmr::any_cast<int>(a));
+        TEST_ASSERT(! pmr::any_cast<long>(&a));
+
+        Tagged& t = a.emplace<Tagged>(6);
+        TEST_ASSERT(&sr == t.m_alloc.resource());
+        TEST_ASSERT(6 == pmr::any_cast<const Tagged&>(a).m_value);
+        TEST_ASSERT(0 == sr.snapshot().allocations);
+
+        int caught = 0;
+        try {
+            pmr::any_cast<int>(a);
+        }
+        catch (std::bad_cast&) {
+            ++caught;
+        }
+        TEST_ASSERT(1 == caught);
+    }
+
+    // pmr_any: spilled values come from the wrapper's resource
+    {
+        pmr::stats_resource sr;
+        {
+            const PmrString s("a string too long for the small buffer");
+            pmr::pmr_any<> a(std::allocator_arg, &sr, s);
+            TEST_ASSERT(2 == sr.snapshot().live_allocations);
+            const PmrString* p = pmr::any_cast<PmrString>(&a);
+            TEST_ASSERT(p && s == *p);
+            TEST_ASSERT(&sr == p->get_allocator().resource());
+
+            pmr::pmr_any<> b(std::move(a));
+            TEST_ASSERT(! a.has_value());
+            TEST_ASSERT(p == pmr::any_cast<PmrString>(&b));
+            TEST_ASSERT(2 == sr.snapshot().live_allocations);
+
+            pmr::stats_resource sr2;
+            pmr::pmr_any<> c(std::allocator_arg, &sr2, b);
+            TEST_ASSERT(&sr2 ==
+                        pmr::any_cast<PmrString&>(c).get_allocator()
+                        .resource());
+            TEST_ASSERT(2 == sr2.snapshot().live_allocations);
+
+            PmrString moved = pmr::any_cast<PmrString&&>(std::move(c));
+            TEST_ASSERT(s == moved);
+            c.reset();
+            TEST_ASSERT(1 == sr2.snapshot().live_allocations);
+        }
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    return errorCount();
+}
@@ -0,0 +1,111 @@
+/* pool_resource.bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Multi-threaded benchmark of `make_obj_using_allocator` for an
+ * allocator-aware type whose constructor allocates from its memory resource.
+ * Reports, for each resource and thread count, the wall-clock time divided
+ * by the total number of objects built, so that perfect scaling halves the
+ * figure each time the thread count doubles (up to the number of cores).
+ */
+
+#include <pool_resource.h>
+
+#include <bench.h>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware type that owns a small heap block, like a short string
+// that does not fit in a small-string buffer.
+class Payload
+{
+    pmr::polymorphic_allocator<char> m_alloc;
+    char*                            m_data;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static constexpr std::size_t k_SIZE = 48;
+
+    Payload(int v, const allocator_type& a)
+        : m_alloc(a), m_data(m_alloc.allocate(k_SIZE)) {
+        m_data[0] = char(v);
+    }
+
+    Payload(Payload&& other)
+        : m_alloc(other.m_alloc), m_data(other.m_data) {
+        other.m_data = nullptr;
+    }
+
+    ~Payload() {
+        if (m_data)
+            m_alloc.deallocate(m_data, k_SIZE);
+    }
+
+    char value() const { return m_data[0]; }
+};
+
+// An `unsynchronized_pool_resource` protected by a single mutex: the
+// "one shared pool" baseline.
+class LockedPoolResource : public pmr::memory_resource
+{
+    std::mutex                        m_mutex;
+    pmr::unsynchronized_pool_resource m_pool;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_pool.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_pool.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept
+        override { return this == &other; }
+};
+
+void runSuite(const char* suite, pmr::memory_resource* r, int maxThreads)
+{
+    pmr::polymorphic_allocator<> a(r);
+    for (int n = 1; n <= maxThreads; n *= 2) {
+        std::string name = "threads=" + std::to_string(n);
+        bench::runThreads(suite, name.c_str(), n, [a](int, long i) {
+                Payload obj = exp::make_obj_using_allocator<Payload>(a,
+                                                                     int(i));
+                bench::doNotOptimize(obj.value());
+            });
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench::parseArgs(argc, argv);
+    bench::printHeader();
+
+    int maxThreads = int(std::thread::hardware_concurrency());
+    if (maxThreads < 8)
+        maxThreads = 8;
+
+    runSuite("new_delete", pmr::new_delete_resource(), maxThreads);
+
+    {
+        LockedPoolResource locked;
+        runSuite("locked_pool", &locked, maxThreads);
+    }
+
+    {
+        pmr::synchronized_pool_resource sync;
+        runSuite("synchronized_pool", &sync, maxThreads);
+    }
+
+    return 0;
+}
@@ -0,0 +1,1020 @@
+/* pool_resource.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Implementation of C++17 `pmr::pool_options`,
+ * `pmr::unsynchronized_pool_resource`, and `pmr::synchronized_pool_resource`,
+ * with extensions for user-specified size classes, per-pool statistics, and
+ * batched deallocation.
+ */
+
+#ifndef INCLUDED_POOL_RESOURCE_DOT_H
+#define INCLUDED_POOL_RESOURCE_DOT_H
+
+#include <memory_resource.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+#include <vector>
+
+namespace std {
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+struct pool_options {
+    size_t max_blocks_per_chunk = 0;
+    size_t largest_required_pool_block = 0;
+};
+
+// Statistics for one pool of a pool resource (extension).
+struct pool_statistics {
+    size_t block_size;          // Size of each block in the pool
+    size_t block_alignment;     // Alignment of each block in the pool
+    size_t chunks;              // Chunks obtained from upstream
+    size_t upstream_bytes;      // Bytes obtained from upstream
+    size_t blocks_in_use;       // Blocks allocated and not yet deallocated
+    size_t total_allocations;   // Blocks allocated since last `release()`
+    size_t next_chunk_blocks;   // Number of blocks in the next chunk
+};
+
+namespace internal {
+
+// A pool of fixed-size blocks carved out of chunks obtained from an upstream
+// resource.  Freed blocks are kept on an intrusive singly-linked free list.
+// Each new chunk is formatted lazily: blocks are handed out by bumping a
+// pointer through the unused part of the most recent chunk, so a chunk's
+// memory is touched only as it is used.
+class block_pool
+{
+public:
+    // Footer placed at the end of each chunk.  Putting it at the end keeps
+    // the first block aligned to the chunk alignment.
+    struct chunk_footer {
+        chunk_footer* m_next;
+        void*         m_begin;
+        size_t        m_size;
+        size_t        m_alignment;
+    };
+
+private:
+    struct free_block {
+        free_block* m_next;
+    };
+
+    static constexpr size_t initial_chunk_blocks = 16;
+
+    size_t          m_block_size;
+    size_t          m_block_alignment;
+    size_t          m_max_chunk_blocks;
+    size_t          m_next_chunk_blocks;
+    free_block*     m_free_list;
+    char*           m_unused_begin;    // Unformatted part of newest chunk
+    char*           m_unused_end;
+    chunk_footer*   m_chunks;
+    pool_statistics m_stats;
+
+    // Largest power of two that divides `size`.
+    static size_t natural_alignment(size_t size)
+        { return size & (~size + 1); }
+
+    static size_t footer_offset(size_t blocks_bytes) {
+        constexpr size_t align = alignof(chunk_footer);
+        return (blocks_bytes + align - 1) / align * align;
+    }
+
+public:
+    block_pool(size_t block_size, size_t max_chunk_blocks)
+        : m_block_size(block_size)
+        , m_block_alignment(natural_alignment(block_size))
+        , m_max_chunk_blocks(max_chunk_blocks)
+        , m_next_chunk_blocks(std::min(size_t(initial_chunk_blocks),
+                                       max_chunk_blocks))
+        , m_free_list(nullptr)
+        , m_unused_begin(nullptr), m_unused_end(nullptr)
+        , m_chunks(nullptr)
+        , m_stats()
+    {
+        m_stats.block_size = m_block_size;
+        m_stats.block_alignment = m_block_alignment;
+        m_stats.next_chunk_blocks = m_next_chunk_blocks;
+    }
+
+    block_pool(const block_pool&) = delete;
+    block_pool& operator=(const block_pool&) = delete;
+
+    size_t block_size() const { return m_block_size; }
+    size_t block_alignment() const { return m_block_alignment; }
+
+    // Size and alignment of a chunk holding `blocks` blocks.
+    size_t chunk_size(size_t blocks) const
+        { return footer_offset(blocks * m_block_size) + sizeof(chunk_footer); }
+    size_t chunk_alignment() const
+        { return std::max(m_block_alignment, alignof(chunk_footer)); }
+
+    // Number of blocks in the next chunk to be obtained from upstream.
+    size_t next_chunk_blocks() const { return m_next_chunk_blocks; }
+
+    // Add `mem`, a chunk of `blocks` blocks obtained from upstream with
+    // `chunk_size(blocks)` and `chunk_alignment()`.  Blocks not yet handed
+    // out from the previous chunk are moved to the free list.
+    void add_chunk(void* mem, size_t blocks) {
+        while (m_unused_begin != m_unused_end) {
+            free_block* block = reinterpret_cast<free_block*>(m_unused_begin);
+            block->m_next = m_free_list;
+            m_free_list = block;
+            m_unused_begin += m_block_size;
+        }
+
+        char* begin = static_cast<char*>(mem);
+        size_t blocks_bytes = blocks * m_block_size;
+        chunk_footer* footer = reinterpret_cast<chunk_footer*>(
+            begin + footer_offset(blocks_bytes));
+        footer->m_next = m_chunks;
+        footer->m_begin = begin;
+        footer->m_size = chunk_size(blocks);
+        footer->m_alignment = chunk_alignment();
+        m_chunks = footer;
+
+        ++m_stats.chunks;
+        m_stats.upstream_bytes += footer->m_size;
+
+        m_unused_begin = begin;
+        m_unused_end = begin + blocks_bytes;
+
+        // Geometric growth up to the configured maximum.
+        if (blocks == m_next_chunk_blocks) {
+            m_next_chunk_blocks = std::min(m_next_chunk_blocks * 2,
+                                           m_max_chunk_blocks);
+            m_stats.next_chunk_blocks = m_next_chunk_blocks;
+        }
+    }
+
+    // Allocate a block without going to upstream.  Return null if every
+    // chunk is in use.
+    void* try_allocate() {
+        void* block;
+        if (m_free_list) {
+            block = m_free_list;
+            m_free_list = m_free_list->m_next;
+        }
+        else if (m_unused_begin != m_unused_end) {
+            block = m_unused_begin;
+            m_unused_begin += m_block_size;
+        }
+        else
+            return nullptr;
+        ++m_stats.blocks_in_use;
+        ++m_stats.total_allocations;
+        return block;
+    }
+
+    void* allocate(memory_resource* upstream) {
+        if (void* block = try_allocate())
+            return block;
+        size_t blocks = m_next_chunk_blocks;
+        add_chunk(upstream->allocate(chunk_size(blocks), chunk_alignment()),
+                  blocks);
+        return try_allocate();
+    }
+
+    void deallocate(void* p) {
+        free_block* block = static_cast<free_block*>(p);
+        block->m_next = m_free_list;
+        m_free_list = block;
+        --m_stats.blocks_in_use;
+    }
+
+    // Push the `n` blocks `blocks[0]` through `blocks[n - 1]` onto the free
+    // list as a single chain.
+    void deallocate_bulk(void* const* blocks, size_t n) {
+        if (0 == n)
+            return;
+        free_block* head = m_free_list;
+        for (size_t i = n; i-- > 0; ) {
+            free_block* block = static_cast<free_block*>(blocks[i]);
+            block->m_next = head;
+            head = block;
+        }
+        m_free_list = head;
+        m_stats.blocks_in_use -= n;
+    }
+
+    // Return the chunks in the list `chunks` to `upstream`.
+    static void release_chunks(chunk_footer* chunks,
+                               memory_resource* upstream) {
+        while (chunks) {
+            chunk_footer* next = chunks->m_next;
+            upstream->deallocate(chunks->m_begin, chunks->m_size,
+                                 chunks->m_alignment);
+            chunks = next;
+        }
+    }
+
+    // Return all chunks to `upstream`.
+    void release(memory_resource* upstream)
+        { release_chunks(detach_chunks(), upstream); }
+
+    // Reset the pool as if by `release`, but return its chunks as a list
+    // for `release_chunks` instead of freeing them.
+    chunk_footer* detach_chunks() {
+        chunk_footer* chunks = m_chunks;
+        m_chunks = nullptr;
+        m_free_list = nullptr;
+        m_unused_begin = m_unused_end = nullptr;
+        m_next_chunk_blocks = std::min(size_t(initial_chunk_blocks),
+                                       m_max_chunk_blocks);
+
+        m_stats.chunks = 0;
+        m_stats.upstream_bytes = 0;
+        m_stats.blocks_in_use = 0;
+        m_stats.total_allocations = 0;
+        m_stats.next_chunk_blocks = m_next_chunk_blocks;
+        return chunks;
+    }
+
+    const pool_statistics& stats() const { return m_stats; }
+};
+
+// The set of pools and the list of oversized allocations that make up a
+// pool resource.  Oversized blocks (too large or too strictly aligned for
+// any pool) are allocated directly from upstream and kept on a
+// doubly-linked list so that they can be freed individually or all at once.
+class pool_set
+{
+    struct large_header {
+        large_header* m_prev;
+        large_header* m_next;
+        void*         m_raw;
+        size_t        m_raw_size;
+        size_t        m_raw_alignment;
+    };
+
+    static constexpr size_t default_max_chunk_blocks  = 1024;
+    static constexpr size_t default_largest_block     = 4096;
+    static constexpr size_t min_block_size            = sizeof(void*);
+
+    // Implementation limit on both `largest_required_pool_block` and
+    // `max_blocks_per_chunk` (and on explicitly specified block sizes),
+    // chosen so that neither the size classes nor the size of a chunk (at
+    // most their product) can overflow.  Larger blocks are allocated
+    // directly from upstream.
+    static constexpr size_t size_limit =
+                                      size_t(1) << (sizeof(size_t) * 4 - 1);
+
+    memory_resource* m_upstream;
+    block_pool*      m_pools;       // Sorted by increasing block size
+    size_t           m_num_pools;
+    pool_options     m_options;
+    large_header     m_large;       // Sentinel for oversized blocks
+
+    void create_pools(const size_t* sizes, size_t n) {
+        m_pools = static_cast<block_pool*>(
+            m_upstream->allocate(n * sizeof(block_pool),
+                                 alignof(block_pool)));
+        for (m_num_pools = 0; m_num_pools < n; ++m_num_pools)
+            ::new(static_cast<void*>(m_pools + m_num_pools))
+                block_pool(sizes[m_num_pools], m_options.max_blocks_per_chunk);
+    }
+
+public:
+    // Allocate `bytes` bytes with the specified `alignment` directly from
+    // upstream without recording the block; `link_large` records it.
+    void* allocate_large_unlinked(size_t bytes, size_t alignment) {
+        size_t align = std::max(alignment, alignof(large_header));
+        size_t offset = (sizeof(large_header) + align - 1) / align * align;
+        size_t size = offset + bytes;
+        char* raw = static_cast<char*>(m_upstream->allocate(size, align));
+
+        large_header* h = reinterpret_cast<large_header*>(raw + offset) - 1;
+        h->m_raw = raw;
+        h->m_raw_size = size;
+        h->m_raw_alignment = align;
+        return raw + offset;
+    }
+
+    // Record the oversized block `p` so that `release` can free it.
+    void link_large(void* p) {
+        large_header* h = static_cast<large_header*>(p) - 1;
+        h->m_prev = &m_large;
+        h->m_next = m_large.m_next;
+        m_large.m_next->m_prev = h;
+        m_large.m_next = h;
+    }
+
+    // Forget the oversized block `p`, which must then be freed with
+    // `deallocate_large_unlinked`.
+    void unlink_large(void* p) {
+        large_header* h = static_cast<large_header*>(p) - 1;
+        h->m_prev->m_next = h->m_next;
+        h->m_next->m_prev = h->m_prev;
+    }
+
+    void deallocate_large_unlinked(void* p) {
+        large_header* h = static_cast<large_header*>(p) - 1;
+        m_upstream->deallocate(h->m_raw, h->m_raw_size, h->m_raw_alignment);
+    }
+
+    void* allocate_large(size_t bytes, size_t alignment) {
+        void* p = allocate_large_unlinked(bytes, alignment);
+        link_large(p);
+        return p;
+    }
+
+    void deallocate_large(void* p) {
+        unlink_large(p);
+        deallocate_large_unlinked(p);
+    }
+
+    pool_set(const pool_options& opts, memory_resource* upstream)
+        : m_upstream(upstream), m_pools(nullptr), m_num_pools(0)
+        , m_options(opts)
+    {
+        m_large.m_prev = m_large.m_next = &m_large;
+
+        if (0 == m_options.max_blocks_per_chunk)
+            m_options.max_blocks_per_chunk = default_max_chunk_blocks;
+        if (0 == m_options.largest_required_pool_block)
+            m_options.largest_required_pool_block = default_largest_block;
+        if (m_options.max_blocks_per_chunk > size_limit)
+            m_options.max_blocks_per_chunk = size_limit;
+        if (m_options.largest_required_pool_block > size_limit)
+            m_options.largest_required_pool_block = size_limit;
+
+        // Power-of-two size classes from `min_block_size` up to the
+        // smallest power of two >= `largest_required_pool_block`, which is
+        // at most `size_limit`.
+        size_t sizes[sizeof(size_t) * 8];
+        size_t n = 0;
+        size_t size = min_block_size;
+        for (;;) {
+            sizes[n++] = size;
+            if (size >= m_options.largest_required_pool_block)
+                break;
+            size *= 2;
+        }
+        m_options.largest_required_pool_block = size;
+        create_pools(sizes, n);
+    }
+
+    pool_set(initializer_list<size_t> block_sizes, const pool_options& opts,
+             memory_resource* upstream)
+        : m_upstream(upstream), m_pools(nullptr), m_num_pools(0)
+        , m_options(opts)
+    {
+        m_large.m_prev = m_large.m_next = &m_large;
+
+        if (0 == m_options.max_blocks_per_chunk)
+            m_options.max_blocks_per_chunk = default_max_chunk_blocks;
+        if (m_options.max_blocks_per_chunk > size_limit)
+            m_options.max_blocks_per_chunk = size_limit;
+
+        // Round each size up to a multiple of `min_block_size` so that every
+        // block can hold a free-list link, then sort and remove duplicates.
+        // Sizes above `size_limit` get no pool.
+        vector<size_t> sizes;
+        sizes.reserve(block_sizes.size());
+        for (size_t s : block_sizes) {
+            if (s <= size_limit)
+                sizes.push_back((std::max(s, size_t(1)) + min_block_size - 1)
+                                / min_block_size * min_block_size);
+        }
+        std::sort(sizes.begin(), sizes.end());
+        sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+        m_options.largest_required_pool_block =
+            sizes.empty() ? 0 : sizes.back();
+        create_pools(sizes.data(), sizes.size());
+    }
+
+    pool_set(const pool_set&) = delete;
+    pool_set& operator=(const pool_set&) = delete;
+
+    ~pool_set() {
+        release();
+        for (size_t i = 0; i < m_num_pools; ++i)
+            m_pools[i].~block_pool();
+        m_upstream->deallocate(m_pools, m_num_pools * sizeof(block_pool),
+                               alignof(block_pool));
+    }
+
+    // Return the index of the smallest pool that can satisfy a request for
+    // `bytes` bytes with alignment `alignment`, or `pool_count()` if no pool
+    // is suitable.
+    size_t pool_index(size_t bytes, size_t alignment) const {
+        size_t i = 0;
+        while (i < m_num_pools &&
+               (m_pools[i].block_size() < bytes ||
+                m_pools[i].block_alignment() < alignment))
+            ++i;
+        return i;
+    }
+
+    // Allocate or deallocate a block from the pool at index `i`.
+    void* allocate_block(size_t i) { return m_pools[i].allocate(m_upstream); }
+    void deallocate_block(size_t i, void* p) { m_pools[i].deallocate(p); }
+    void deallocate_blocks(size_t i, void* const* blocks, size_t n)
+        { m_pools[i].deallocate_bulk(blocks, n); }
+
+    // Allocate a block from the pool at index `i` without going to
+    // upstream, or return null.  If the pool is exhausted, the caller can
+    // obtain a chunk of `next_chunk_blocks(i)` blocks from upstream, with
+    // `chunk_size` and `chunk_alignment`, and hand it to `add_chunk`.
+    void* try_allocate_block(size_t i) { return m_pools[i].try_allocate(); }
+    size_t next_chunk_blocks(size_t i) const
+        { return m_pools[i].next_chunk_blocks(); }
+    size_t chunk_size(size_t i, size_t blocks) const
+        { return m_pools[i].chunk_size(blocks); }
+    size_t chunk_alignment(size_t i) const
+        { return m_pools[i].chunk_alignment(); }
+    void add_chunk(size_t i, void* chunk, size_t blocks)
+        { m_pools[i].add_chunk(chunk, blocks); }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        size_t i = pool_index(bytes, alignment);
+        if (i < m_num_pools)
+            return allocate_block(i);
+        return allocate_large(bytes, alignment);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment) {
+        size_t i = pool_index(bytes, alignment);
+        if (i < m_num_pools)
+            deallocate_block(i, p);
+        else
+            deallocate_large(p);
+    }
+
+    // Deallocate `n` blocks of the same size and alignment, looking up
+    // their pool only once.
+    void deallocate_bulk(void* const* blocks, size_t n, size_t bytes,
+                         size_t alignment) {
+        size_t i = pool_index(bytes, alignment);
+        if (i < m_num_pools)
+            deallocate_blocks(i, blocks, n);
+        else
+            for (size_t j = 0; j < n; ++j)
+                deallocate_large(blocks[j]);
+    }
+
+    // Chunks and oversized blocks taken from a pool set by `detach`, to be
+    // returned to upstream by `release_detached`.  Not movable, since the
+    // oversized blocks are linked to `m_large`.
+    struct detached_memory {
+        block_pool::chunk_footer* m_chunks;
+        large_header              m_large;   // Sentinel
+
+        detached_memory() : m_chunks(nullptr)
+            { m_large.m_prev = m_large.m_next = &m_large; }
+        detached_memory(const detached_memory&) = delete;
+        detached_memory& operator=(const detached_memory&) = delete;
+    };
+
+    // Reset the pool set as if by `release`, but move its memory to `d`
+    // instead of returning it to upstream, so that a caller holding a lock
+    // can call upstream after releasing it.
+    void detach(detached_memory& d) {
+        for (size_t i = 0; i < m_num_pools; ++i) {
+            block_pool::chunk_footer* chunks = m_pools[i].detach_chunks();
+            while (chunks) {
+                block_pool::chunk_footer* next = chunks->m_next;
+                chunks->m_next = d.m_chunks;
+                d.m_chunks = chunks;
+                chunks = next;
+            }
+        }
+        if (m_large.m_next != &m_large) {
+            large_header* first = m_large.m_next;
+            large_header* last = m_large.m_prev;
+            first->m_prev = d.m_large.m_prev;
+            d.m_large.m_prev->m_next = first;
+            last->m_next = &d.m_large;
+            d.m_large.m_prev = last;
+            m_large.m_prev = m_large.m_next = &m_large;
+        }
+    }
+
+    void release_detached(detached_memory& d) {
+        block_pool::release_chunks(d.m_chunks, m_upstream);
+        d.m_chunks = nullptr;
+        while (d.m_large.m_next != &d.m_large) {
+            large_header* h = d.m_large.m_next;
+            d.m_large.m_next = h->m_next;
+            deallocate_large_unlinked(h + 1);
+        }
+        d.m_large.m_prev = &d.m_large;
+    }
+
+    void release() {
+        detached_memory d;
+        detach(d);
+        release_detached(d);
+    }
+
+    memory_resource* upstream_resource() const { return m_upstream; }
+    pool_options options() const { return m_options; }
+    size_t pool_count() const { return m_num_pools; }
+    size_t block_size(size_t i) const { return m_pools[i].block_size(); }
+    const pool_statistics& pool_stats(size_t i) const
+        { return m_pools[i].stats(); }
+};
+
+} // close namespace internal
+
+// Memory resource that serves small allocations from pools of fixed-size
+// blocks, one pool per size class.  Not safe for concurrent use.
+// Allocations too large (or too strictly aligned) for the largest pool are
+// forwarded to the upstream resource.  By default, the size classes are
+// powers of two from `sizeof(void*)` through
+// `options().largest_required_pool_block`; the size classes can instead be
+// supplied explicitly (extension).
+class unsynchronized_pool_resource : public memory_resource
+{
+    internal::pool_set m_pools;
+
+public:
+    unsynchronized_pool_resource(const pool_options& opts,
+                                 memory_resource* upstream)
+        : m_pools(opts, upstream) { }
+
+    unsynchronized_pool_resource()
+        : unsynchronized_pool_resource(pool_options(),
+                                       get_default_resource()) { }
+
+    explicit unsynchronized_pool_resource(memory_resource* upstream)
+        : unsynchronized_pool_resource(pool_options(), upstream) { }
+
+    explicit unsynchronized_pool_resource(const pool_options& opts)
+        : unsynchronized_pool_resource(opts, get_default_resource()) { }
+
+    // Create a pool resource with one pool for each of the specified
+    // `block_sizes` (extension).  Sizes are rounded up to a multiple of
+    // `sizeof(void*)`.
+    unsynchronized_pool_resource(initializer_list<size_t> block_sizes,
+                                 const pool_options& opts = pool_options(),
+                                 memory_resource* upstream =
+                                                       get_default_resource())
+        : m_pools(block_sizes, opts, upstream) { }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource&
+        operator=(const unsynchronized_pool_resource&) = delete;
+
+    // Return all memory to upstream.
+    void release() { m_pools.release(); }
+
+    memory_resource* upstream_resource() const
+        { return m_pools.upstream_resource(); }
+
+    pool_options options() const { return m_pools.options(); }
+
+    // Per-pool statistics (extension).
+    size_t pool_count() const { return m_pools.pool_count(); }
+    pool_statistics pool_stats(size_t i) const
+        { return m_pools.pool_stats(i); }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+        { return m_pools.allocate(bytes, alignment); }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        { m_pools.deallocate(p, bytes, alignment); }
+
+    void do_deallocate_bulk(void* const* blocks, size_t n, size_t bytes,
+                            size_t alignment) override
+        { m_pools.deallocate_bulk(blocks, n, bytes, alignment); }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+namespace internal {
+
+// A bounded stack of free blocks belonging to one size class, cached by one
+// thread.
+struct magazine {
+    static constexpr size_t max_capacity = 64;
+
+    size_t m_count;
+    size_t m_capacity;
+    void*  m_blocks[max_capacity];
+};
+
+// The per-thread cache for one `shared_pool_set`: one magazine per pool.
+struct thread_cache {
+    thread_cache* m_next;        // Next cache owned by the same pool set
+    bool          m_active;      // True while owned by a running thread
+    magazine*     m_magazines;   // Array of `pool_count()` magazines
+};
+
+class shared_pool_set;
+
+// Thread-local map from `shared_pool_set` identity to this thread's cache
+// for it.  When the thread exits, the blocks in each cache whose owner is
+// still alive are returned to the owner's shared pools.
+class thread_cache_map
+{
+    struct entry {
+        unsigned long long m_id;
+        shared_pool_set*   m_owner;
+        thread_cache*      m_cache;
+    };
+
+    unsigned long long m_last_id;      // Most recent lookup
+    thread_cache*      m_last_cache;
+    vector<entry>      m_entries;
+
+    thread_cache_map() : m_last_id(0), m_last_cache(nullptr) { }
+
+public:
+    ~thread_cache_map();
+
+    static thread_cache_map& instance() {
+        // Header-only thread-local variable
+        static thread_local thread_cache_map map;
+        return map;
+    }
+
+    thread_cache* find(unsigned long long id) {
+        if (id == m_last_id)
+            return m_last_cache;
+        for (const entry& e : m_entries) {
+            if (e.m_id == id) {
+                m_last_id = id;
+                m_last_cache = e.m_cache;
+                return e.m_cache;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(unsigned long long id, shared_pool_set* owner,
+                thread_cache* cache);
+};
+
+// A `pool_set` shared by many threads.  Each thread allocates from and
+// deallocates to its own cache of free blocks without locking; the shared
+// pools (the depot) are locked only to refill an empty magazine or drain a
+// full one, half a magazine at a time.
+class shared_pool_set
+{
+    mutable mutex      m_mutex;
+    pool_set           m_pools;         // Guarded by `m_mutex`
+    thread_cache*      m_caches;        // Guarded by `m_mutex`
+    unsigned long long m_id;
+
+    // Registry of live pool sets, consulted by exiting threads.
+    static mutex& registry_mutex() {
+        // Header-only static variable
+        static mutex m;
+        return m;
+    }
+
+    static unordered_set<unsigned long long>& registry() {
+        // Header-only static variable
+        static unordered_set<unsigned long long> ids;
+        return ids;
+    }
+
+    static unsigned long long next_id() {
+        // Header-only static variable.  Ids are never reused, so a stale
+        // thread-local entry can never match a new pool set.
+        static atomic<unsigned long long> counter(0);
+        return ++counter;
+    }
+
+    size_t magazine_capacity(size_t i) const {
+        size_t capacity = 16384 / m_pools.block_size(i);
+        return std::max(size_t(4), std::min(capacity,
+                                            size_t(magazine::max_capacity)));
+    }
+
+    static size_t cache_bytes(size_t num_pools)
+        { return sizeof(thread_cache) + num_pools * sizeof(magazine); }
+
+    // Return the calling thread's cache, creating it if necessary.  Memory
+    // is never obtained from upstream with `m_mutex` held: the upstream may
+    // itself be a `synchronized_pool_resource`, whose allocation path can
+    // take the registry mutex, which an exiting thread holds while taking
+    // `m_mutex`.
+    thread_cache* local_cache() {
+        thread_cache_map& map = thread_cache_map::instance();
+        thread_cache* cache = map.find(m_id);
+        if (cache)
+            return cache;
+
+        {
+            // Adopt a cache retired by an exited thread, if any.
+            lock_guard<mutex> guard(m_mutex);
+            for (cache = m_caches; cache && cache->m_active;
+                 cache = cache->m_next) { }
+            if (cache)
+                cache->m_active = true;
+        }
+
+        if (! cache) {
+            const size_t n = m_pools.pool_count();
+            void* mem = m_pools.upstream_resource()->allocate(
+                cache_bytes(n), alignof(thread_cache));
+            cache = static_cast<thread_cache*>(mem);
+            cache->m_active = true;
+            cache->m_magazines = reinterpret_cast<magazine*>(cache + 1);
+            for (size_t i = 0; i < n; ++i) {
+                cache->m_magazines[i].m_count = 0;
+                cache->m_magazines[i].m_capacity = magazine_capacity(i);
+            }
+
+            lock_guard<mutex> guard(m_mutex);
+            cache->m_next = m_caches;
+            m_caches = cache;
+        }
+
+        map.insert(m_id, this, cache);
+        return cache;
+    }
+
+    // Move half a magazine of blocks from the depot into `mag`.  New chunks
+    // are obtained from upstream with `m_mutex` released.
+    void refill(size_t i, magazine& mag) {
+        const size_t batch = mag.m_capacity / 2;
+        for (;;) {
+            size_t blocks;
+            {
+                lock_guard<mutex> guard(m_mutex);
+                while (mag.m_count < batch) {
+                    void* block = m_pools.try_allocate_block(i);
+                    if (! block)
+                        break;
+                    mag.m_blocks[mag.m_count++] = block;
+                }
+                if (mag.m_count == batch)
+                    return;
+                blocks = m_pools.next_chunk_blocks(i);
+            }
+
+            void* chunk;
+            try {
+                chunk = m_pools.upstream_resource()->allocate(
+                    m_pools.chunk_size(i, blocks), m_pools.chunk_alignment(i));
+            }
+            catch (...) {
+                if (0 == mag.m_count)
+                    throw;
+                return;
+            }
+
+            lock_guard<mutex> guard(m_mutex);
+            m_pools.add_chunk(i, chunk, blocks);
+        }
+    }
+
+    // Move half a magazine of blocks from `mag` back to the depot.
+    void drain(size_t i, magazine& mag) {
+        lock_guard<mutex> guard(m_mutex);
+        const size_t keep = mag.m_capacity / 2;
+        while (mag.m_count > keep)
+            m_pools.deallocate_block(i, mag.m_blocks[--mag.m_count]);
+    }
+
+    // Return all blocks in `cache` to the depot.  `m_mutex` must be held.
+    void flush(thread_cache* cache) {
+        for (size_t i = 0; i < m_pools.pool_count(); ++i) {
+            magazine& mag = cache->m_magazines[i];
+            while (mag.m_count > 0)
+                m_pools.deallocate_block(i, mag.m_blocks[--mag.m_count]);
+        }
+    }
+
+public:
+    template <class... Args>
+    explicit shared_pool_set(Args&&... args)
+        : m_pools(std::forward<Args>(args)...)
+        , m_caches(nullptr)
+        , m_id(next_id())
+    {
+        lock_guard<mutex> guard(registry_mutex());
+        registry().insert(m_id);
+    }
+
+    shared_pool_set(const shared_pool_set&) = delete;
+    shared_pool_set& operator=(const shared_pool_set&) = delete;
+
+    ~shared_pool_set() {
+        {
+            // After this, no exiting thread will touch our caches.
+            lock_guard<mutex> guard(registry_mutex());
+            registry().erase(m_id);
+        }
+        const size_t n = m_pools.pool_count();
+        while (m_caches) {
+            thread_cache* next = m_caches->m_next;
+            m_pools.upstream_resource()->deallocate(m_caches, cache_bytes(n),
+                                                   alignof(thread_cache));
+            m_caches = next;
+        }
+    }
+
+    // Called by an exiting thread for a pool set that is known to be alive
+    // (the registry mutex is held by the caller).
+    void retire_cache(thread_cache* cache) {
+        lock_guard<mutex> guard(m_mutex);
+        flush(cache);
+        cache->m_active = false;
+    }
+
+    static bool is_alive(unsigned long long id)
+        { return registry().count(id) != 0; }
+
+    static mutex& registry_lock() { return registry_mutex(); }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        // `pool_index` reads only data that is immutable after construction.
+        size_t i = m_pools.pool_index(bytes, alignment);
+        if (i == m_pools.pool_count()) {
+            void* p = m_pools.allocate_large_unlinked(bytes, alignment);
+            lock_guard<mutex> guard(m_mutex);
+            m_pools.link_large(p);
+            return p;
+        }
+
+        magazine& mag = local_cache()->m_magazines[i];
+        if (0 == mag.m_count)
+            refill(i, mag);
+        return mag.m_blocks[--mag.m_count];
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment) {
+        size_t i = m_pools.pool_index(bytes, alignment);
+        if (i == m_pools.pool_count()) {
+            {
+                lock_guard<mutex> guard(m_mutex);
+                m_pools.unlink_large(p);
+            }
+            m_pools.deallocate_large_unlinked(p);
+            return;
+        }
+
+        magazine& mag = local_cache()->m_magazines[i];
+        if (mag.m_count == mag.m_capacity)
+            drain(i, mag);
+        mag.m_blocks[mag.m_count++] = p;
+    }
+
+    // Deallocate `n` blocks of the same size and alignment.  Blocks are
+    // cached in the calling thread's magazine while it has room; the rest
+    // are returned to the depot under a single lock.
+    void deallocate_bulk(void* const* blocks, size_t n, size_t bytes,
+                         size_t alignment) {
+        size_t i = m_pools.pool_index(bytes, alignment);
+        if (i == m_pools.pool_count()) {
+            {
+                lock_guard<mutex> guard(m_mutex);
+                for (size_t j = 0; j < n; ++j)
+                    m_pools.unlink_large(blocks[j]);
+            }
+            for (size_t j = 0; j < n; ++j)
+                m_pools.deallocate_large_unlinked(blocks[j]);
+            return;
+        }
+
+        magazine& mag = local_cache()->m_magazines[i];
+        while (n > 0 && mag.m_count < mag.m_capacity)
+            mag.m_blocks[mag.m_count++] = blocks[--n];
+        if (n > 0) {
+            lock_guard<mutex> guard(m_mutex);
+            m_pools.deallocate_blocks(i, blocks, n);
+        }
+    }
+
+    // Empty every thread's cache and return all memory to upstream, with
+    // `m_mutex` released.  Must not be called while other threads are
+    // allocating from this pool set.
+    void release() {
+        pool_set::detached_memory d;
+        {
+            lock_guard<mutex> guard(m_mutex);
+            for (thread_cache* c = m_caches; c; c = c->m_next)
+                for (size_t i = 0; i < m_pools.pool_count(); ++i)
+                    c->m_magazines[i].m_count = 0;
+            m_pools.detach(d);
+        }
+        m_pools.release_detached(d);
+    }
+
+    memory_resource* upstream_resource() const
+        { return m_pools.upstream_resource(); }
+    pool_options options() const { return m_pools.options(); }
+    size_t pool_count() const { return m_pools.pool_count(); }
+
+    pool_statistics pool_stats(size_t i) const {
+        lock_guard<mutex> guard(m_mutex);
+        return m_pools.pool_stats(i);
+    }
+};
+
+inline thread_cache_map::~thread_cache_map()
+{
+    lock_guard<mutex> guard(shared_pool_set::registry_lock());
+    for (const entry& e : m_entries)
+        if (shared_pool_set::is_alive(e.m_id))
+            e.m_owner->retire_cache(e.m_cache);
+}
+
+inline void thread_cache_map::insert(unsigned long long id,
+                                     shared_pool_set* owner,
+                                     thread_cache* cache)
+{
+    {
+        // Forget entries for pool sets that have been destroyed.
+        lock_guard<mutex> guard(shared_pool_set::registry_lock());
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                       [](const entry& e) {
+                                   return ! shared_pool_set::is_alive(e.m_id);
+                                       }),
+                        m_entries.end());
+    }
+    m_entries.push_back(entry{ id, owner, cache });
+    m_last_id = id;
+    m_last_cache = cache;
+}
+
+} // close namespace internal
+
+// Memory resource with the same pools as `unsynchronized_pool_resource` that
+// may be used concurrently from multiple threads.  Each thread keeps a
+// magazine of free blocks for every size class, so most allocations and
+// deallocations take no lock.  Magazines are refilled from, and drained to,
+// the shared pools in batches.  Blocks held in a thread's magazines are
+// counted as in use by `pool_stats`, and are returned to the shared pools
+// when the thread exits.
+class synchronized_pool_resource : public memory_resource
+{
+    internal::shared_pool_set m_pools;
+
+public:
+    synchronized_pool_resource(const pool_options& opts,
+                               memory_resource* upstream)
+        : m_pools(opts, upstream) { }
+
+    synchronized_pool_resource()
+        : synchronized_pool_resource(pool_options(),
+                                     get_default_resource()) { }
+
+    explicit synchronized_pool_resource(memory_resource* upstream)
+        : synchronized_pool_resource(pool_options(), upstream) { }
+
+    explicit synchronized_pool_resource(const pool_options& opts)
+        : synchronized_pool_resource(opts, get_default_resource()) { }
+
+    // Create a pool resource with one pool for each of the specified
+    // `block_sizes` (extension).
+    synchronized_pool_resource(initializer_list<size_t> block_sizes,
+                               const pool_options& opts = pool_options(),
+                               memory_resource* upstream =
+                                                       get_default_resource())
+        : m_pools(block_sizes, opts, upstream) { }
+
+    synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+    synchronized_pool_resource&
+        operator=(const synchronized_pool_resource&) = delete;
+
+    // Return all memory to upstream.  Must not be called concurrently with
+    // allocation or deallocation from other threads.
+    void release() { m_pools.release(); }
+
+    memory_resource* upstream_resource() const
+        { return m_pools.upstream_resource(); }
+
+    pool_options options() const { return m_pools.options(); }
+
+    // Per-pool statistics (extension).
+    size_t pool_count() const { return m_pools.pool_count(); }
+    pool_statistics pool_stats(size_t i) const
+        { return m_pools.pool_stats(i); }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+        { return m_pools.allocate(bytes, alignment); }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        { m_pools.deallocate(p, bytes, alignment); }
+
+    void do_deallocate_bulk(void* const* blocks, size_t n, size_t bytes,
+                            size_t alignment) override
+        { m_pools.deallocate_bulk(blocks, n, bytes, alignment); }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_POOL_RESOURCE_DOT_H)
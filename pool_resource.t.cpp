@@ -0,0 +1,490 @@
+/* pool_resource.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <pool_resource.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Upstream resource that counts outstanding allocations.  Thread safe only
+// if used from a synchronized resource.
+class CountingResource : public pmr::memory_resource
+{
+public:
+    std::size_t m_allocations = 0;
+    std::size_t m_outstanding = 0;
+    std::size_t m_lastBytes = 0;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++m_allocations;
+        ++m_outstanding;
+        m_lastBytes = bytes;
+        return pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override {
+        --m_outstanding;
+        pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept
+        override { return this == &other; }
+};
+
+// Counting upstream resource that calls back into a synchronized pool
+// resource, which deadlocks if the pool holds its lock while calling
+// upstream.
+class ReentrantResource : public CountingResource
+{
+public:
+    pmr::synchronized_pool_resource* m_pool = nullptr;
+    std::size_t                      m_reentries = 0;
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (m_pool) {
+            m_pool->pool_stats(0);
+            ++m_reentries;
+        }
+        return CountingResource::do_allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t alignment) override {
+        if (m_pool) {
+            m_pool->pool_stats(0);
+            ++m_reentries;
+        }
+        CountingResource::do_deallocate(p, bytes, alignment);
+    }
+};
+
+bool isAligned(void* p, std::size_t alignment)
+{
+    return 0 == reinterpret_cast<std::uintptr_t>(p) % alignment;
+}
+
+// Allocator-aware node type using a prefix polymorphic allocator.
+struct Node
+{
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    allocator_type m_alloc;
+    Node*          m_next;
+    int            m_value;
+
+    Node(std::allocator_arg_t, const allocator_type& a, int v)
+        : m_alloc(a), m_next(nullptr), m_value(v) { }
+};
+
+int main()
+{
+    // Default size classes
+    {
+        CountingResource upstream;
+        pmr::unsynchronized_pool_resource pr(&upstream);
+        TEST_ASSERT(&upstream == pr.upstream_resource());
+
+        pmr::pool_options opts = pr.options();
+        TEST_ASSERT(opts.max_blocks_per_chunk > 0);
+        TEST_ASSERT(opts.largest_required_pool_block >= 4096);
+        TEST_ASSERT(pr.pool_count() > 0);
+        for (std::size_t i = 1; i < pr.pool_count(); ++i)
+            TEST_ASSERT(pr.pool_stats(i).block_size ==
+                        2 * pr.pool_stats(i - 1).block_size);
+        TEST_ASSERT(opts.largest_required_pool_block ==
+                    pr.pool_stats(pr.pool_count() - 1).block_size);
+        std::size_t bookkeeping = upstream.m_allocations;
+
+        // A deallocated block is reused for the next allocation of the same
+        // size.
+        void* p1 = pr.allocate(24, 8);
+        void* p2 = pr.allocate(24, 8);
+        TEST_ASSERT(p1 != p2);
+        pr.deallocate(p1, 24, 8);
+        TEST_ASSERT(p1 == pr.allocate(24, 8));
+
+        // Chunks are obtained in batches
+        TEST_ASSERT(bookkeeping + 1 == upstream.m_allocations);
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100; ++i)
+            blocks.push_back(pr.allocate(20, 4));
+        TEST_ASSERT(bookkeeping + 4 > upstream.m_allocations);
+
+        std::size_t pool = 0;
+        while (pr.pool_stats(pool).block_size < 24)
+            ++pool;
+        pmr::pool_statistics st = pr.pool_stats(pool);
+        TEST_ASSERT(32 == st.block_size);
+        TEST_ASSERT(102 == st.blocks_in_use);
+        TEST_ASSERT(103 == st.total_allocations);
+        TEST_ASSERT(st.chunks == upstream.m_allocations - bookkeeping);
+        TEST_ASSERT(st.upstream_bytes >= 102 * 32);
+
+        for (void* p : blocks)
+            pr.deallocate(p, 20, 4);
+        TEST_ASSERT(2 == pr.pool_stats(pool).blocks_in_use);
+
+        // Alignment is honored by choosing a larger size class
+        void* pa = pr.allocate(8, 64);
+        TEST_ASSERT(isAligned(pa, 64));
+        pr.deallocate(pa, 8, 64);
+        for (int i = 0; i < 10; ++i) {
+            void* q = pr.allocate(40, 16);
+            TEST_ASSERT(isAligned(q, 16));
+        }
+
+        // Oversized blocks go directly to upstream
+        std::size_t before = upstream.m_outstanding;
+        void* big = pr.allocate(100000, 8);
+        TEST_ASSERT(before + 1 == upstream.m_outstanding);
+        TEST_ASSERT(upstream.m_lastBytes >= 100000);
+        void* big2 = pr.allocate(100000, 8);
+        pr.deallocate(big, 100000, 8);
+        TEST_ASSERT(before + 1 == upstream.m_outstanding);
+        (void) big2;
+
+        // release() returns everything but the bookkeeping
+        pr.release();
+        TEST_ASSERT(bookkeeping == upstream.m_outstanding);
+        TEST_ASSERT(0 == pr.pool_stats(pool).blocks_in_use);
+        TEST_ASSERT(0 == pr.pool_stats(pool).chunks);
+    }
+
+    // Chunk size grows geometrically up to max_blocks_per_chunk
+    {
+        CountingResource upstream;
+        pmr::pool_options opts;
+        opts.max_blocks_per_chunk = 64;
+        opts.largest_required_pool_block = 100;
+        pmr::unsynchronized_pool_resource pr(opts, &upstream);
+        TEST_ASSERT(64 == pr.options().max_blocks_per_chunk);
+        TEST_ASSERT(128 == pr.options().largest_required_pool_block);
+
+        for (int i = 0; i < 1000; ++i)
+            pr.allocate(8, 8);
+        pmr::pool_statistics st = pr.pool_stats(0);
+        TEST_ASSERT(8 == st.block_size);
+        TEST_ASSERT(64 == st.next_chunk_blocks);
+        // 16 + 32 + 64 * 15 >= 1000
+        TEST_ASSERT(17 == st.chunks);
+
+        // Requests above the largest pool go upstream
+        std::size_t before = upstream.m_allocations;
+        void* p = pr.allocate(129, 8);
+        TEST_ASSERT(before + 1 == upstream.m_allocations);
+        pr.deallocate(p, 129, 8);
+    }
+    // (destructor releases everything, including bookkeeping)
+
+    // User-specified size classes
+    {
+        CountingResource upstream;
+        {
+            pmr::unsynchronized_pool_resource pr({ 24, 40, 3, 40 },
+                                                 pmr::pool_options(),
+                                                 &upstream);
+            TEST_ASSERT(3 == pr.pool_count());
+            TEST_ASSERT(8  == pr.pool_stats(0).block_size);
+            TEST_ASSERT(24 == pr.pool_stats(1).block_size);
+            TEST_ASSERT(40 == pr.pool_stats(2).block_size);
+            TEST_ASSERT(8  == pr.pool_stats(1).block_alignment);
+            TEST_ASSERT(40 == pr.options().largest_required_pool_block);
+
+            void* p1 = pr.allocate(17, 8);
+            void* p2 = pr.allocate(17, 8);
+            TEST_ASSERT(static_cast<char*>(p1) + 24 == p2);
+            TEST_ASSERT(1 == pr.pool_stats(1).chunks);
+            TEST_ASSERT(0 == pr.pool_stats(2).chunks);
+        }
+        TEST_ASSERT(0 == upstream.m_outstanding);
+    }
+
+    // Options beyond the implementation limit are clamped
+    {
+        CountingResource upstream;
+        {
+            pmr::pool_options opts;
+            opts.max_blocks_per_chunk = std::size_t(-1);
+            opts.largest_required_pool_block = std::size_t(-1);
+            pmr::unsynchronized_pool_resource pr(opts, &upstream);
+            const std::size_t largest =
+                                   pr.options().largest_required_pool_block;
+            TEST_ASSERT(largest >= 4096);
+            TEST_ASSERT(0 == (largest & (largest - 1)));
+            TEST_ASSERT(pr.options().max_blocks_per_chunk >= 1024);
+            TEST_ASSERT(pr.options().max_blocks_per_chunk < std::size_t(-1));
+            TEST_ASSERT(largest ==
+                        pr.pool_stats(pr.pool_count() - 1).block_size);
+
+            void* p = pr.allocate(100, 8);
+            pr.deallocate(p, 100, 8);
+        }
+        TEST_ASSERT(0 == upstream.m_outstanding);
+    }
+
+    // Any number of user-specified size classes
+    {
+        CountingResource upstream;
+        {
+            pmr::unsynchronized_pool_resource pr({
+                    8, 16, 24, 32, 40, 48, 56, 64, 72, 80, 88, 96, 104, 112,
+                    120, 128, 136, 144, 152, 160, 168, 176, 184, 192, 200,
+                    208, 216, 224, 232, 240, 248, 256, 264, 272, 280, 288,
+                    296, 304, 312, 320, 328, 336, 344, 352, 360, 368, 376,
+                    384, 392, 400, 408, 416, 424, 432, 440, 448, 456, 464,
+                    472, 480, 488, 496, 504, 512, 520, 528, 536, 544,
+                    std::size_t(-1) }, pmr::pool_options(), &upstream);
+            TEST_ASSERT(68 == pr.pool_count());
+            TEST_ASSERT(544 == pr.options().largest_required_pool_block);
+
+            void* p = pr.allocate(540, 8);
+            TEST_ASSERT(1 == pr.pool_stats(67).blocks_in_use);
+            pr.deallocate(p, 540, 8);
+        }
+        TEST_ASSERT(0 == upstream.m_outstanding);
+    }
+
+    // Uses-allocator construction of nodes
+    {
+        CountingResource upstream;
+        pmr::unsynchronized_pool_resource pr(&upstream);
+        pmr::polymorphic_allocator<Node> a(&pr);
+
+        Node* head = nullptr;
+        for (int i = 0; i < 50; ++i) {
+            Node* n = a.allocate(1);
+            exp::uninitialized_construct_using_allocator(n, a, i);
+            TEST_ASSERT(&pr == n->m_alloc.resource());
+            n->m_next = head;
+            head = n;
+        }
+        std::size_t allocations = upstream.m_allocations;
+
+        // Freeing and reallocating nodes doesn't touch upstream
+        for (int round = 0; round < 10; ++round) {
+            while (head) {
+                Node* n = head;
+                head = head->m_next;
+                n->~Node();
+                a.deallocate(n, 1);
+            }
+            for (int i = 0; i < 50; ++i) {
+                Node* n = a.allocate(1);
+                exp::uninitialized_construct_using_allocator(n, a, i);
+                n->m_next = head;
+                head = n;
+            }
+        }
+        TEST_ASSERT(allocations == upstream.m_allocations);
+    }
+
+    // synchronized_pool_resource from a single thread
+    {
+        CountingResource upstream;
+        {
+            pmr::pool_options opts;
+            opts.largest_required_pool_block = 256;
+            pmr::synchronized_pool_resource pr(opts, &upstream);
+            TEST_ASSERT(&upstream == pr.upstream_resource());
+            TEST_ASSERT(256 == pr.options().largest_required_pool_block);
+
+            void* p1 = pr.allocate(16, 8);
+            pr.deallocate(p1, 16, 8);
+            TEST_ASSERT(p1 == pr.allocate(16, 8));  // From thread cache
+
+            void* p2 = pr.allocate(64, 64);
+            TEST_ASSERT(isAligned(p2, 64));
+
+            std::size_t before = upstream.m_outstanding;
+            void* big = pr.allocate(1000, 8);
+            TEST_ASSERT(before + 1 == upstream.m_outstanding);
+            pr.deallocate(big, 1000, 8);
+            TEST_ASSERT(before == upstream.m_outstanding);
+
+            // Many allocations and deallocations of one size: the thread
+            // cache is refilled and drained in batches.
+            std::vector<void*> blocks;
+            for (int i = 0; i < 1000; ++i)
+                blocks.push_back(pr.allocate(24, 8));
+            for (void* p : blocks)
+                pr.deallocate(p, 24, 8);
+
+            // Reallocation reuses the freed blocks without going upstream
+            std::size_t allocations = upstream.m_allocations;
+            for (void*& p : blocks)
+                p = pr.allocate(24, 8);
+            TEST_ASSERT(allocations == upstream.m_allocations);
+
+            pr.release();
+            TEST_ASSERT(0 != upstream.m_outstanding);  // Bookkeeping remains
+        }
+        TEST_ASSERT(0 == upstream.m_outstanding);
+    }
+
+    // synchronized_pool_resource from many threads
+    {
+        pmr::synchronized_pool_resource pr;
+        pmr::polymorphic_allocator<Node> a(&pr);
+
+        const int numThreads = 8;
+        const int numNodes = 2000;
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                Node* head = nullptr;
+                for (int i = 0; i < numNodes; ++i) {
+                    Node* n = a.allocate(1);
+                    exp::uninitialized_construct_using_allocator(n, a,
+                                                                 t * i);
+                    n->m_next = head;
+                    head = n;
+                }
+                for (int i = numNodes; i-- > 0; ) {
+                    Node* n = head;
+                    if (n->m_value != t * i || n->m_alloc.resource() != &pr)
+                        ++errors;
+                    head = n->m_next;
+                    n->~Node();
+                    a.deallocate(n, 1);
+                }
+            });
+        }
+        for (std::thread& th : threads)
+            th.join();
+        TEST_ASSERT(0 == errors);
+
+        // Exited threads return their cached blocks to the shared pools
+        for (std::size_t i = 0; i < pr.pool_count(); ++i)
+            TEST_ASSERT(0 == pr.pool_stats(i).blocks_in_use);
+    }
+
+    // synchronized_pool_resource does not hold its lock while calling
+    // upstream, which may itself lock (e.g., another synchronized pool).
+    {
+        ReentrantResource upstream;
+        {
+            pmr::synchronized_pool_resource pr(&upstream);
+            const std::size_t base = upstream.m_outstanding;
+            upstream.m_pool = &pr;
+
+            std::thread th([&]() {
+                std::vector<void*> blocks;
+                for (int i = 0; i < 1000; ++i)
+                    blocks.push_back(pr.allocate(32));
+                void* big = pr.allocate(100000);
+                pr.deallocate(big, 100000);
+                for (void* p : blocks)
+                    pr.deallocate(p, 32);
+            });
+            th.join();
+            TEST_ASSERT(0 != upstream.m_reentries);
+
+            // `release` returns chunks and oversized blocks to upstream
+            // without the lock; only the exited thread's cache remains.
+            pr.allocate(100000);
+            const std::size_t reentries = upstream.m_reentries;
+            pr.release();
+            TEST_ASSERT(reentries < upstream.m_reentries);
+            TEST_ASSERT(base + 1 == upstream.m_outstanding);
+            upstream.m_pool = nullptr;
+        }
+        TEST_ASSERT(0 == upstream.m_outstanding);
+    }
+
+    // A thread that outlives a synchronized_pool_resource it has used
+    {
+        std::atomic<bool> used(false), destroyed(false);
+        pmr::synchronized_pool_resource* ppr =
+            new pmr::synchronized_pool_resource;
+
+        std::thread th([&]() {
+            void* p = ppr->allocate(32);
+            ppr->deallocate(p, 32);
+            used = true;
+            while (! destroyed)
+                std::this_thread::yield();
+            // Thread exit must not touch the destroyed resource.
+        });
+        while (! used)
+            std::this_thread::yield();
+        delete ppr;
+        destroyed = true;
+        th.join();
+
+        // A new resource (possibly at the same address) is unaffected.
+        pmr::synchronized_pool_resource pr2;
+        void* p = pr2.allocate(32);
+        pr2.deallocate(p, 32);
+    }
+
+    // Bulk deallocation returns a batch of blocks to their pool at once
+    {
+        CountingResource upstream;
+        pmr::unsynchronized_pool_resource pr(&upstream);
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100; ++i)
+            blocks.push_back(pr.allocate(24, 8));
+
+        std::size_t pool = 0;
+        while (pr.pool_stats(pool).block_size < 24)
+            ++pool;
+        TEST_ASSERT(100 == pr.pool_stats(pool).blocks_in_use);
+        pr.deallocate_bulk(blocks.data(), blocks.size(), 24, 8);
+        TEST_ASSERT(0 == pr.pool_stats(pool).blocks_in_use);
+
+        // The batch is reused in order
+        TEST_ASSERT(blocks[0] == pr.allocate(24, 8));
+        TEST_ASSERT(blocks[1] == pr.allocate(24, 8));
+
+        // Oversized blocks go back to upstream
+        std::size_t before = upstream.m_outstanding;
+        void* big[3];
+        for (void*& p : big)
+            p = pr.allocate(100000, 8);
+        TEST_ASSERT(before + 3 == upstream.m_outstanding);
+        pr.deallocate_bulk(big, 3, 100000, 8);
+        TEST_ASSERT(before == upstream.m_outstanding);
+    }
+
+    // Bulk deallocation to a synchronized_pool_resource fills the calling
+    // thread's magazine and returns the rest to the shared pools
+    {
+        CountingResource upstream;
+        pmr::synchronized_pool_resource pr(&upstream);
+        std::vector<void*> blocks;
+        for (int i = 0; i < 1000; ++i)
+            blocks.push_back(pr.allocate(32));
+
+        std::size_t pool = 0;
+        while (pr.pool_stats(pool).block_size < 32)
+            ++pool;
+        const std::size_t chunks = pr.pool_stats(pool).chunks;
+        pr.deallocate_bulk(blocks.data(), blocks.size(), 32);
+        TEST_ASSERT(pr.pool_stats(pool).blocks_in_use <= 64);
+
+        for (void*& p : blocks)
+            p = pr.allocate(32);
+        TEST_ASSERT(chunks == pr.pool_stats(pool).chunks);
+
+        void* big[2] = { pr.allocate(100000), pr.allocate(100000) };
+        std::size_t before = upstream.m_outstanding;
+        pr.deallocate_bulk(big, 2, 100000);
+        TEST_ASSERT(before - 2 == upstream.m_outstanding);
+        pr.deallocate_bulk(blocks.data(), blocks.size(), 32);
+    }
+
+    return errorCount();
+}
@@ -0,0 +1,152 @@
+/* smart_ptr.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `allocate_shared_using_allocator` and `allocate_unique`, which create an
+ * object managed by a smart pointer using uses-allocator construction, with
+ * the storage for the object obtained from the same allocator (extension).
+ */
+
+#ifndef INCLUDED_SMART_PTR_DOT_H
+#define INCLUDED_SMART_PTR_DOT_H
+
+#include <uses_allocator.h>
+#include <memory>
+#include <utility>
+
+namespace std {
+
+inline namespace Cpp20 {
+
+namespace internal {
+
+// Allocator that obtains memory from a copy of `Alloc` rebound to `T`, and
+// whose `construct` member performs uses-allocator construction with the
+// original `Alloc`, whether or not `Alloc` itself defines `construct`.
+// `allocate_shared` rebinds it to allocate the control block and the object
+// together and then uses it to construct the object.
+template <class T, class Alloc>
+class uses_allocator_construct_adaptor
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<T>
+        storage_alloc;
+    typedef allocator_traits<storage_alloc> storage_traits;
+
+    template <class, class> friend class uses_allocator_construct_adaptor;
+
+    Alloc m_alloc;
+
+public:
+    typedef T                                  value_type;
+    typedef typename storage_traits::pointer   pointer;
+    typedef typename storage_traits::size_type size_type;
+
+    explicit uses_allocator_construct_adaptor(const Alloc& a) noexcept
+        : m_alloc(a) { }
+
+    template <class U>
+    uses_allocator_construct_adaptor(
+        const uses_allocator_construct_adaptor<U, Alloc>& other) noexcept
+        : m_alloc(other.m_alloc) { }
+
+    pointer allocate(size_type n) {
+        storage_alloc a(m_alloc);
+        return storage_traits::allocate(a, n);
+    }
+
+    void deallocate(pointer p, size_type n) {
+        storage_alloc a(m_alloc);
+        storage_traits::deallocate(a, p, n);
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        Cpp20::uninitialized_construct_using_allocator(
+            p, m_alloc, std::forward<Args>(args)...);
+    }
+
+    const Alloc& inner_allocator() const noexcept { return m_alloc; }
+
+    template <class U>
+    bool operator==(
+        const uses_allocator_construct_adaptor<U, Alloc>& other) const
+        { return m_alloc == other.m_alloc; }
+
+    template <class U>
+    bool operator!=(
+        const uses_allocator_construct_adaptor<U, Alloc>& other) const
+        { return ! (m_alloc == other.m_alloc); }
+};
+
+} // close namespace internal
+
+// Return a `shared_ptr` to a new object of type `T` constructed by
+// uses-allocator construction with allocator `a` and `args`, so that `a` is
+// passed to `T` (or to the members of a `pair`) according to the
+// uses-allocator protocol of `T`.  The control block and the object are
+// obtained from `a` (rebound) in a single allocation.
+template <class T, class Alloc, class... Args>
+inline shared_ptr<T> allocate_shared_using_allocator(const Alloc& a,
+                                                     Args&&... args)
+{
+    return std::allocate_shared<T>(
+        internal::uses_allocator_construct_adaptor<T, Alloc>(a),
+        std::forward<Args>(args)...);
+}
+
+// Deleter for an object created by `allocate_unique`: destroys the object
+// and returns its storage to the copy of the allocator that it holds.
+template <class T, class Alloc>
+class allocator_delete
+{
+    typedef typename allocator_traits<Alloc>::template rebind_alloc<T>
+        storage_alloc;
+    typedef allocator_traits<storage_alloc> storage_traits;
+
+    storage_alloc m_alloc;
+
+public:
+    typedef typename storage_traits::pointer pointer;
+    typedef storage_alloc                    allocator_type;
+
+    explicit allocator_delete(const Alloc& a) noexcept : m_alloc(a) { }
+
+    void operator()(pointer p) noexcept {
+        Cpp20::destroy_n_using_allocator(std::addressof(*p), 1, m_alloc);
+        storage_traits::deallocate(m_alloc, p, 1);
+    }
+
+    allocator_type get_allocator() const noexcept { return m_alloc; }
+};
+
+// Return a `unique_ptr` to a new object of type `T` constructed by
+// uses-allocator construction with allocator `a` and `args`.  The object is
+// obtained from `a` (rebound) in a single allocation, and the deleter holds
+// the allocator that frees it.  If the constructor throws, the storage is
+// returned to `a` and the exception is propagated.
+template <class T, class Alloc, class... Args>
+unique_ptr<T, allocator_delete<T, Alloc>> allocate_unique(const Alloc& a,
+                                                          Args&&... args)
+{
+    typedef allocator_delete<T, Alloc>       deleter;
+    typedef typename deleter::allocator_type storage_alloc;
+    typedef allocator_traits<storage_alloc>  storage_traits;
+
+    storage_alloc sa(a);
+    typename storage_traits::pointer p = storage_traits::allocate(sa, 1);
+    try {
+        Cpp20::uninitialized_construct_using_allocator(
+            std::addressof(*p), a, std::forward<Args>(args)...);
+    }
+    catch (...) {
+        storage_traits::deallocate(sa, p, 1);
+        throw;
+    }
+    return unique_ptr<T, deleter>(p, deleter(a));
+}
+
+} // close namespace Cpp20
+} // close namespace std
+
+#endif // ! defined(INCLUDED_SMART_PTR_DOT_H)
@@ -0,0 +1,153 @@
+/* smart_ptr.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <smart_ptr.h>
+
+#include <stats_resource.h>
+#include <memory>
+#include <utility>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware type that takes the allocator as a trailing constructor
+// argument.  The constructor throws if the value is `s_throwOn`.
+class Entry
+{
+    pmr::polymorphic_allocator<> m_alloc;
+    int                          m_value;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    static int s_live;
+    static int s_throwOn;
+
+    Entry(int v, const allocator_type& a) : m_alloc(a), m_value(v) {
+        if (v == s_throwOn)
+            throw v;
+        ++s_live;
+    }
+
+    ~Entry() { --s_live; }
+
+    pmr::memory_resource* resource() const { return m_alloc.resource(); }
+    int value() const { return m_value; }
+};
+
+int Entry::s_live = 0;
+int Entry::s_throwOn = -1;
+
+// Allocator-aware type that takes the allocator after `allocator_arg`.
+struct PrefixEntry
+{
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    allocator_type m_alloc;
+    int            m_value;
+
+    PrefixEntry(std::allocator_arg_t, const allocator_type& a, int v)
+        : m_alloc(a), m_value(v) { }
+};
+
+int main()
+{
+    // allocate_shared_using_allocator: one allocation, allocator passed in
+    {
+        pmr::stats_resource sr;
+        pmr::polymorphic_allocator<char> a(&sr);
+
+        std::shared_ptr<Entry> p =
+            exp::allocate_shared_using_allocator<Entry>(a, 5);
+        TEST_ASSERT(5 == p->value());
+        TEST_ASSERT(&sr == p->resource());
+        TEST_ASSERT(1 == Entry::s_live);
+        TEST_ASSERT(1 == sr.snapshot().allocations);
+
+        std::shared_ptr<PrefixEntry> q =
+            exp::allocate_shared_using_allocator<PrefixEntry>(a, 6);
+        TEST_ASSERT(6 == q->m_value);
+        TEST_ASSERT(&sr == q->m_alloc.resource());
+        TEST_ASSERT(2 == sr.snapshot().allocations);
+
+        p.reset();
+        q.reset();
+        TEST_ASSERT(0 == Entry::s_live);
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    // Pair members get the allocator too
+    {
+        typedef std::pair<Entry, PrefixEntry> Pair;
+        pmr::stats_resource sr;
+        pmr::polymorphic_allocator<Pair> a(&sr);
+
+        std::shared_ptr<Pair> p =
+            exp::allocate_shared_using_allocator<Pair>(a, 1, 2);
+        TEST_ASSERT(1 == p->first.value());
+        TEST_ASSERT(&sr == p->first.resource());
+        TEST_ASSERT(2 == p->second.m_value);
+        TEST_ASSERT(&sr == p->second.m_alloc.resource());
+        TEST_ASSERT(1 == sr.snapshot().allocations);
+
+        auto u = exp::allocate_unique<Pair>(a, std::piecewise_construct,
+                                            std::make_tuple(3),
+                                            std::make_tuple(4));
+        TEST_ASSERT(3 == u->first.value());
+        TEST_ASSERT(&sr == u->first.resource());
+        TEST_ASSERT(&sr == u->second.m_alloc.resource());
+        TEST_ASSERT(2 == sr.snapshot().allocations);
+    }
+    TEST_ASSERT(0 == Entry::s_live);
+
+    // allocate_unique: the deleter returns the object to the allocator
+    {
+        pmr::stats_resource sr;
+        pmr::polymorphic_allocator<char> a(&sr);
+
+        auto u = exp::allocate_unique<Entry>(a, 7);
+        TEST_ASSERT(7 == u->value());
+        TEST_ASSERT(&sr == u->resource());
+        TEST_ASSERT(&sr == u.get_deleter().get_allocator().resource());
+        TEST_ASSERT(1 == sr.snapshot().allocations);
+        TEST_ASSERT(sizeof(Entry) == sr.snapshot().live_bytes);
+
+        u.reset();
+        TEST_ASSERT(0 == Entry::s_live);
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+
+        auto i = exp::allocate_unique<int>(a, 8);
+        TEST_ASSERT(8 == *i);
+    }
+
+    // A throwing constructor leaks nothing
+    {
+        pmr::stats_resource sr;
+        pmr::polymorphic_allocator<char> a(&sr);
+
+        Entry::s_throwOn = 9;
+        int caught = 0;
+        try {
+            exp::allocate_shared_using_allocator<Entry>(a, 9);
+        }
+        catch (int v) {
+            caught += v;
+        }
+        try {
+            exp::allocate_unique<Entry>(a, 9);
+        }
+        catch (int v) {
+            caught += v;
+        }
+        Entry::s_throwOn = -1;
+        TEST_ASSERT(18 == caught);
+        TEST_ASSERT(0 == Entry::s_live);
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+    }
+
+    return errorCount();
+}
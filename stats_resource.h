@@ -0,0 +1,176 @@
+/* stats_resource.h                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * `pmr::stats_resource`, a memory resource adaptor that forwards every
+ * request to an upstream resource and keeps allocation statistics
+ * (extension).
+ */
+
+#ifndef INCLUDED_STATS_RESOURCE_DOT_H
+#define INCLUDED_STATS_RESOURCE_DOT_H
+
+#include <memory_resource.h>
+#include <atomic>
+#include <cstddef>
+
+namespace std {
+
+namespace experimental {
+inline namespace fundamentals_v3 {
+namespace pmr {
+
+// A point-in-time copy of the counters of a `stats_resource`.  Bucket `i` of
+// `size_histogram` counts allocations of more than `2^(i-1)` and at most
+// `2^i` bytes (bucket 0 counts allocations of 0 or 1 byte); the last bucket
+// also counts everything larger.  Bucket `i` of `alignment_histogram`
+// counts allocations with alignment `2^i`, the last bucket also counting
+// larger alignments.
+struct allocation_statistics {
+    static constexpr size_t size_buckets = 32;
+    static constexpr size_t alignment_buckets = 16;
+
+    size_t allocations;         // Calls to `allocate`
+    size_t deallocations;       // Calls to `deallocate`
+    size_t bytes_allocated;     // Total bytes requested from `allocate`
+    size_t bytes_deallocated;   // Total bytes returned to `deallocate`
+    size_t live_allocations;    // Blocks allocated and not yet deallocated
+    size_t live_bytes;          // Bytes allocated and not yet deallocated
+    size_t high_water_bytes;    // Largest value reached by `live_bytes`
+    size_t size_histogram[size_buckets];
+    size_t alignment_histogram[alignment_buckets];
+};
+
+// Memory resource that forwards to an upstream resource and counts what
+// passes through it.  Counters are updated with relaxed atomic operations,
+// so a `stats_resource` may be shared between threads if its upstream
+// resource can be, and the cost of counting is a handful of uncontended
+// atomic increments per call.
+class stats_resource : public memory_resource
+{
+    typedef atomic<size_t> counter;
+
+    memory_resource* m_upstream;
+    counter          m_allocations;
+    counter          m_deallocations;
+    counter          m_bytes_allocated;
+    counter          m_bytes_deallocated;
+    counter          m_live_allocations;
+    counter          m_live_bytes;
+    counter          m_high_water_bytes;
+    counter          m_size_histogram[allocation_statistics::size_buckets];
+    counter m_alignment_histogram[allocation_statistics::alignment_buckets];
+
+    // Return the index of the smallest `i` such that `value <= 2^i`, but no
+    // more than `limit - 1`.
+    static size_t log2_bucket(size_t value, size_t limit) {
+        size_t i = 0;
+        while (i + 1 < limit && (size_t(1) << i) < value)
+            ++i;
+        return i;
+    }
+
+    static size_t load(const counter& c)
+        { return c.load(memory_order_relaxed); }
+
+    static void add(counter& c, size_t n)
+        { c.fetch_add(n, memory_order_relaxed); }
+
+public:
+    explicit stats_resource(memory_resource* upstream = get_default_resource())
+        : m_upstream(upstream), m_live_allocations(0), m_live_bytes(0) {
+        reset();
+    }
+
+    stats_resource(const stats_resource&) = delete;
+    stats_resource& operator=(const stats_resource&) = delete;
+
+    memory_resource* upstream_resource() const { return m_upstream; }
+
+    // Return a copy of the current counters.  If other threads are using
+    // this resource, each counter is read atomically but the counters are
+    // not read as a single consistent set.
+    allocation_statistics snapshot() const {
+        allocation_statistics ret;
+        ret.allocations       = load(m_allocations);
+        ret.deallocations     = load(m_deallocations);
+        ret.bytes_allocated   = load(m_bytes_allocated);
+        ret.bytes_deallocated = load(m_bytes_deallocated);
+        ret.live_allocations  = load(m_live_allocations);
+        ret.live_bytes        = load(m_live_bytes);
+        ret.high_water_bytes  = load(m_high_water_bytes);
+        for (size_t i = 0; i < allocation_statistics::size_buckets; ++i)
+            ret.size_histogram[i] = load(m_size_histogram[i]);
+        for (size_t i = 0; i < allocation_statistics::alignment_buckets; ++i)
+            ret.alignment_histogram[i] = load(m_alignment_histogram[i]);
+        return ret;
+    }
+
+    // Reset the cumulative counters and histograms to zero and the
+    // high-water mark to the current number of live bytes.
+    // `live_allocations` and `live_bytes` are left unchanged, since blocks
+    // allocated before the reset may still be deallocated after it.
+    void reset() {
+        m_allocations.store(0, memory_order_relaxed);
+        m_deallocations.store(0, memory_order_relaxed);
+        m_bytes_allocated.store(0, memory_order_relaxed);
+        m_bytes_deallocated.store(0, memory_order_relaxed);
+        m_high_water_bytes.store(load(m_live_bytes), memory_order_relaxed);
+        for (counter& c : m_size_histogram)
+            c.store(0, memory_order_relaxed);
+        for (counter& c : m_alignment_histogram)
+            c.store(0, memory_order_relaxed);
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = m_upstream->allocate(bytes, alignment);
+
+        add(m_allocations, 1);
+        add(m_live_allocations, 1);
+        add(m_bytes_allocated, bytes);
+        add(m_size_histogram[log2_bucket(bytes,
+                                  allocation_statistics::size_buckets)], 1);
+        add(m_alignment_histogram[log2_bucket(alignment,
+                             allocation_statistics::alignment_buckets)], 1);
+
+        size_t live = m_live_bytes.fetch_add(bytes, memory_order_relaxed) +
+                      bytes;
+        size_t high = load(m_high_water_bytes);
+        while (high < live &&
+               ! m_high_water_bytes.compare_exchange_weak(
+                                            high, live, memory_order_relaxed))
+            ;
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        m_upstream->deallocate(p, bytes, alignment);
+        add(m_deallocations, 1);
+        m_live_allocations.fetch_sub(1, memory_order_relaxed);
+        add(m_bytes_deallocated, bytes);
+        m_live_bytes.fetch_sub(bytes, memory_order_relaxed);
+    }
+
+    // Forward the whole batch, so that the upstream resource can return it
+    // in one operation.
+    void do_deallocate_bulk(void* const* blocks, size_t n, size_t bytes,
+                            size_t alignment) override {
+        m_upstream->deallocate_bulk(blocks, n, bytes, alignment);
+        add(m_deallocations, n);
+        m_live_allocations.fetch_sub(n, memory_order_relaxed);
+        add(m_bytes_deallocated, n * bytes);
+        m_live_bytes.fetch_sub(n * bytes, memory_order_relaxed);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+        { return this == &other; }
+};
+
+} // close namespace pmr
+} // close namespace fundamentals_v3
+} // close namespace experimental
+} // close namespace std
+
+#endif // ! defined(INCLUDED_STATS_RESOURCE_DOT_H)
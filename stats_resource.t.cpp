@@ -0,0 +1,207 @@
+/* stats_resource.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ */
+
+#include <stats_resource.h>
+
+#include <pool_resource.h>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <test_assert.h>
+
+namespace pmr = std::experimental::pmr;
+namespace exp = std::Cpp20;
+
+// Allocator-aware type that allocates `m_size` bytes from its resource.
+class Buffer
+{
+    pmr::polymorphic_allocator<char> m_alloc;
+    std::size_t                      m_size;
+    char*                            m_data;
+
+public:
+    typedef pmr::polymorphic_allocator<> allocator_type;
+
+    Buffer(std::size_t size, const allocator_type& a)
+        : m_alloc(a), m_size(size), m_data(m_alloc.allocate(size)) { }
+
+    Buffer(const Buffer& other, const allocator_type& a)
+        : Buffer(other.m_size, a) { }
+
+    ~Buffer() { m_alloc.deallocate(m_data, m_size); }
+
+    std::size_t size() const { return m_size; }
+};
+
+int main()
+{
+    // Counters, live bytes, and high-water mark
+    {
+        pmr::stats_resource sr;
+        TEST_ASSERT(pmr::new_delete_resource() == sr.upstream_resource());
+        TEST_ASSERT(sr == sr);
+        TEST_ASSERT(sr != *pmr::new_delete_resource());
+
+        pmr::allocation_statistics st = sr.snapshot();
+        TEST_ASSERT(0 == st.allocations);
+        TEST_ASSERT(0 == st.live_bytes);
+        TEST_ASSERT(0 == st.high_water_bytes);
+
+        void* p1 = sr.allocate(100, 8);
+        void* p2 = sr.allocate(20, 4);
+        sr.deallocate(p1, 100, 8);
+        void* p3 = sr.allocate(50, 64);
+
+        st = sr.snapshot();
+        TEST_ASSERT(3 == st.allocations);
+        TEST_ASSERT(1 == st.deallocations);
+        TEST_ASSERT(2 == st.live_allocations);
+        TEST_ASSERT(170 == st.bytes_allocated);
+        TEST_ASSERT(100 == st.bytes_deallocated);
+        TEST_ASSERT(70 == st.live_bytes);
+        TEST_ASSERT(120 == st.high_water_bytes);
+
+        // Size histogram: 100 -> (64, 128], 20 -> (16, 32], 50 -> (32, 64]
+        TEST_ASSERT(1 == st.size_histogram[7]);
+        TEST_ASSERT(1 == st.size_histogram[5]);
+        TEST_ASSERT(1 == st.size_histogram[6]);
+        TEST_ASSERT(0 == st.size_histogram[4]);
+
+        // Alignment histogram: 8 -> 3, 4 -> 2, 64 -> 6
+        TEST_ASSERT(1 == st.alignment_histogram[3]);
+        TEST_ASSERT(1 == st.alignment_histogram[2]);
+        TEST_ASSERT(1 == st.alignment_histogram[6]);
+        TEST_ASSERT(0 == st.alignment_histogram[0]);
+
+        // Reset clears the cumulative counters but not the live counts
+        sr.reset();
+        st = sr.snapshot();
+        TEST_ASSERT(0 == st.allocations);
+        TEST_ASSERT(0 == st.bytes_allocated);
+        TEST_ASSERT(0 == st.size_histogram[7]);
+        TEST_ASSERT(2 == st.live_allocations);
+        TEST_ASSERT(70 == st.live_bytes);
+        TEST_ASSERT(70 == st.high_water_bytes);
+
+        sr.deallocate(p2, 20, 4);
+        sr.deallocate(p3, 50, 64);
+        st = sr.snapshot();
+        TEST_ASSERT(2 == st.deallocations);
+        TEST_ASSERT(0 == st.live_allocations);
+        TEST_ASSERT(0 == st.live_bytes);
+        TEST_ASSERT(70 == st.high_water_bytes);
+
+        // Extreme sizes and alignments go to the first and last buckets
+        void* p4 = sr.allocate(1, 1);
+        void* p5 = sr.allocate(16, 1024 * 1024);
+        st = sr.snapshot();
+        TEST_ASSERT(1 == st.size_histogram[0]);
+        TEST_ASSERT(1 == st.alignment_histogram[0]);
+        const std::size_t last =
+            pmr::allocation_statistics::alignment_buckets - 1;
+        TEST_ASSERT(1 == st.alignment_histogram[last]);
+        sr.deallocate(p4, 1, 1);
+        sr.deallocate(p5, 16, 1024 * 1024);
+    }
+
+    // Accounting for uses-allocator construction
+    {
+        pmr::stats_resource sr;
+        pmr::polymorphic_allocator<Buffer> a(&sr);
+
+        Buffer* p = a.allocate(1);
+        {
+            // Constructing a `Buffer` allocates its data and nothing else
+            TEST_ALLOCATION_BUDGET(sr, 1, 40);
+            exp::uninitialized_construct_using_allocator(p, a, 40);
+        }
+        TEST_ASSERT(2 == sr.snapshot().allocations);
+
+        typedef std::pair<Buffer, Buffer> BufferPair;
+        pmr::polymorphic_allocator<BufferPair> pa(a);
+        BufferPair* pp = pa.allocate(1);
+        {
+            // The pair members are built directly with the allocator, not
+            // built with another allocator and copied.
+            TEST_ALLOCATION_BUDGET(sr, 2, 16 + 32);
+            pa.construct(pp, 16, 32);
+        }
+        TEST_ASSERT(16 == pp->first.size());
+        TEST_ASSERT(32 == pp->second.size());
+
+        pa.destroy(pp);
+        pa.deallocate(pp, 1);
+        p->~Buffer();
+        a.deallocate(p, 1);
+        TEST_ASSERT(0 == sr.snapshot().live_bytes);
+        TEST_ASSERT(0 == sr.snapshot().live_allocations);
+    }
+
+    // Counting between a pool and its upstream
+    {
+        pmr::stats_resource upstream;
+        pmr::unsynchronized_pool_resource pr(&upstream);
+        pmr::polymorphic_allocator<Buffer> a(&pr);
+
+        Buffer* p = a.allocate(100);
+        exp::uninitialized_construct_n_using_allocator(p, 100, a, 24);
+        upstream.reset();
+        {
+            // Reusing blocks after the pool has warmed up is free
+            TEST_ALLOCATION_BUDGET(upstream, 0, 0);
+            for (int round = 0; round < 10; ++round) {
+                for (int i = 0; i < 100; ++i)
+                    p[i].~Buffer();
+                exp::uninitialized_construct_n_using_allocator(p, 100, a, 24);
+            }
+        }
+        for (int i = 0; i < 100; ++i)
+            p[i].~Buffer();
+        a.deallocate(p, 100);
+    }
+
+    // Bulk deallocation is forwarded as one batch and counted per block
+    {
+        pmr::stats_resource sr;
+        void* blocks[10];
+        for (void*& p : blocks)
+            p = sr.allocate(16);
+        sr.deallocate_bulk(blocks, 10, 16);
+
+        pmr::allocation_statistics st = sr.snapshot();
+        TEST_ASSERT(10 == st.deallocations);
+        TEST_ASSERT(160 == st.bytes_deallocated);
+        TEST_ASSERT(0 == st.live_bytes);
+        TEST_ASSERT(0 == st.live_allocations);
+    }
+
+    // Concurrent use
+    {
+        pmr::stats_resource sr;
+        const int numThreads = 4;
+        const int numAllocs = 1000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&sr]() {
+                for (int i = 0; i < numAllocs; ++i)
+                    sr.deallocate(sr.allocate(32, 8), 32, 8);
+            });
+        }
+        for (std::thread& th : threads)
+            th.join();
+
+        pmr::allocation_statistics st = sr.snapshot();
+        TEST_ASSERT(numThreads * numAllocs == st.allocations);
+        TEST_ASSERT(numThreads * numAllocs == st.deallocations);
+        TEST_ASSERT(numThreads * numAllocs * 32 == st.bytes_allocated);
+        TEST_ASSERT(numThreads * numAllocs == st.size_histogram[5]);
+        TEST_ASSERT(0 == st.live_bytes);
+        TEST_ASSERT(st.high_water_bytes >= 32);
+        TEST_ASSERT(st.high_water_bytes <= numThreads * 32);
+    }
+
+    return errorCount();
+}
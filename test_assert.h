@@ -8,6 +8,8 @@
 #define INCLUDED_TEST_ASSERT_DOT_H
 
 #include <iostream>
+#include <type_traits>
+#include <cstddef>
 
 class TestContext
 {
@@ -48,16 +50,73 @@ int& errorCount()
     return errorCount;
 }
 
+// Print a failure message for the expression `str` at `file` and `line`,
+// followed by the active test contexts, and increment `errorCount()`.
+inline
+void reportFailure(const char* file, int line, const char* str)
+{
+    std::cout << file << ':' << line << ": Assertion failed: " << str
+              << std::endl;
+    for (const TestContext* ctx = TestContext::currContext();
+         ctx; ctx = ctx->prevContext())
+        std::cout << ctx->file() << ':' << ctx->line()
+                  << ":  Context: " << ctx->str() << std::endl;
+    ++errorCount();
+}
+
 #define TEST_ASSERT(c) do {                                             \
-        if (! (c)) {                                                    \
-            std::cout << __FILE__ << ':' << __LINE__                    \
-                      << ": Assertion failed: " #c << std::endl;        \
-            for (const TestContext* ctx = TestContext::currContext();   \
-                 ctx; ctx = ctx->prevContext())                         \
-                std::cout << ctx->file() << ':' << ctx->line()          \
-                          << ":  Context: " << ctx->str() << std::endl; \
-            ++errorCount();                                             \
-        }                                                               \
+        if (! (c))                                                      \
+            reportFailure(__FILE__, __LINE__, #c);                      \
     } while (false)
 
+// Scoped guard that, on destruction, reports a failure if more than
+// `maxAllocations` allocations or more than `maxBytes` bytes were obtained
+// through `stats` (a `pmr::stats_resource` or any type with a compatible
+// `snapshot()`) during its lifetime.
+template <class StatsResource>
+class AllocationBudget
+{
+    const StatsResource& m_stats;
+    const char*          m_file;
+    int                  m_line;
+    std::size_t          m_maxAllocations;
+    std::size_t          m_maxBytes;
+    std::size_t          m_startAllocations;
+    std::size_t          m_startBytes;
+
+public:
+    AllocationBudget(const char* file, int line, const StatsResource& stats,
+                     std::size_t maxAllocations, std::size_t maxBytes)
+        : m_stats(stats), m_file(file), m_line(line)
+        , m_maxAllocations(maxAllocations), m_maxBytes(maxBytes)
+        , m_startAllocations(stats.snapshot().allocations)
+        , m_startBytes(stats.snapshot().bytes_allocated) { }
+
+    ~AllocationBudget() {
+        std::size_t allocations =
+            m_stats.snapshot().allocations - m_startAllocations;
+        std::size_t bytes = m_stats.snapshot().bytes_allocated - m_startBytes;
+        if (allocations > m_maxAllocations) {
+            std::cout << m_file << ':' << m_line << ": " << allocations
+                      << " allocations exceed budget" << std::endl;
+            reportFailure(m_file, m_line, "allocations within budget");
+        }
+        if (bytes > m_maxBytes) {
+            std::cout << m_file << ':' << m_line << ": " << bytes
+                      << " bytes exceed budget" << std::endl;
+            reportFailure(m_file, m_line, "bytes within budget");
+        }
+    }
+};
+
+#define TEST_ALLOCATION_BUDGET_CAT2(a, b) a ## b
+#define TEST_ALLOCATION_BUDGET_CAT(a, b) TEST_ALLOCATION_BUDGET_CAT2(a, b)
+
+// Assert that no more than `maxAllocations` allocations and `maxBytes` bytes
+// are obtained through `stats` from here to the end of the enclosing scope.
+#define TEST_ALLOCATION_BUDGET(stats, maxAllocations, maxBytes)          \
+    AllocationBudget<typename std::decay<decltype(stats)>::type>        \
+        TEST_ALLOCATION_BUDGET_CAT(allocationBudget, __LINE__)(         \
+            __FILE__, __LINE__, (stats), (maxAllocations), (maxBytes))
+
 #endif // ! defined(INCLUDED_TEST_ASSERT_DOT_H)
@@ -0,0 +1,214 @@
+/* uses_allocator.bench.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Micro-benchmarks comparing the construction utilities in `uses_allocator.h`
+ * and `make_from_tuple.h` against hand-written constructor calls.
+ */
+
+#include "uses_allocator.h"
+
+#include <bench.h>
+#include <memory>
+#include <vector>
+
+namespace exp = std::Cpp20;
+
+// Minimal stateful allocator.  Only its identity matters for construction.
+template <class T>
+class BenchAlloc
+{
+    int m_id;
+public:
+    typedef T value_type;
+
+    explicit BenchAlloc(int id = 0) : m_id(id) { }
+
+    template <class U>
+    BenchAlloc(const BenchAlloc<U>& other) : m_id(other.id()) { }
+
+    int id() const { return m_id; }
+};
+
+typedef BenchAlloc<int> Alloc;
+
+enum Protocol { e_NONE, e_PREFIX, e_SUFFIX };
+
+class Unused { };
+
+// Element type whose copy and move constructors are counted.  `P` selects
+// how (or whether) the allocator is passed to the constructor.
+template <Protocol P>
+class BenchType
+{
+    typedef typename std::conditional<P == e_PREFIX,
+                                      Alloc, Unused>::type PrefixAlloc;
+    typedef typename std::conditional<P == e_SUFFIX,
+                                      Alloc, Unused>::type SuffixAlloc;
+
+    int m_allocId;
+    int m_value;
+
+public:
+    typedef typename std::conditional<P == e_NONE,
+                                      Unused, Alloc>::type allocator_type;
+
+    explicit BenchType(int v = 0) : m_allocId(0), m_value(v) { }
+    BenchType(std::allocator_arg_t, const PrefixAlloc& a, int v = 0)
+        : m_allocId(a.id()), m_value(v) { }
+    BenchType(int v, const SuffixAlloc& a) : m_allocId(a.id()), m_value(v) { }
+
+    BenchType(const BenchType& other)
+        : m_allocId(0), m_value(other.m_value)
+        { bench::OpCounts::countCopy(); }
+    BenchType(BenchType&& other)
+        : m_allocId(other.m_allocId), m_value(other.m_value)
+        { bench::OpCounts::countMove(); }
+
+    int value() const { return m_value; }
+    int allocId() const { return m_allocId; }
+};
+
+typedef BenchType<e_NONE>   NoAllocObj;
+typedef BenchType<e_PREFIX> PrefixObj;
+typedef BenchType<e_SUFFIX> SuffixObj;
+
+// Run the standard set of benchmarks for constructing an object of type
+// `Obj` from allocator `a` and the arguments produced by `args(i)`, which
+// must return a tuple of values.  `manual` is the hand-written placement
+// construction used as the baseline.
+template <class Obj, class Args, class Manual>
+void runSuite(const char* suite, const Alloc& a, Args args, Manual manual)
+{
+    char buffer alignas(Obj) [sizeof(Obj)];
+    Obj *p = reinterpret_cast<Obj*>(buffer);
+
+    bench::run(suite, "manual", [&](long i) {
+            Obj *obj = manual(p, a, int(i));
+            bench::doNotOptimize(*obj);
+            obj->~Obj();
+        });
+
+    bench::run(suite, "uninitialized_construct_using_allocator", [&](long i) {
+            Obj *obj = std::apply([&](auto&&... v) {
+                    return exp::uninitialized_construct_using_allocator(p, a,
+                                              std::forward<decltype(v)>(v)...);
+                }, args(int(i)));
+            bench::doNotOptimize(*obj);
+            obj->~Obj();
+        });
+
+    bench::run(suite, "make_obj_using_allocator", [&](long i) {
+            Obj obj = std::apply([&](auto&&... v) {
+                    return exp::make_obj_using_allocator<Obj>(a,
+                                              std::forward<decltype(v)>(v)...);
+                }, args(int(i)));
+            bench::doNotOptimize(obj);
+        });
+
+    bench::run(suite, "make_from_tuple", [&](long i) {
+            Obj obj = std::make_from_tuple<Obj>(
+                std::apply([&](auto&&... v) {
+                    return exp::uses_allocator_construction_args<Obj>(a,
+                                              std::forward<decltype(v)>(v)...);
+                }, args(int(i))));
+            bench::doNotOptimize(obj);
+        });
+
+    bench::run(suite, "apply", [&](long i) {
+            Obj *obj = std::apply([p](auto&&... ctorArgs) {
+                    return ::new(static_cast<void*>(p))
+                        Obj(std::forward<decltype(ctorArgs)>(ctorArgs)...);
+                }, std::apply([&](auto&&... v) {
+                    return exp::uses_allocator_construction_args<Obj>(a,
+                                              std::forward<decltype(v)>(v)...);
+                }, args(int(i))));
+            bench::doNotOptimize(*obj);
+            obj->~Obj();
+        });
+}
+
+// Time constructing a batch of `iterations()` objects of type `Obj` from a
+// range of `int` values using allocator `a`, once with a loop calling
+// `uninitialized_construct_using_allocator` for each element and once with
+// a single call to `uninitialized_copy_using_allocator`.
+template <class Obj>
+void runRangeSuite(const char* suite, const Alloc& a)
+{
+    const long n = bench::iterations();
+    std::vector<int> from(std::size_t(n), 0);
+    for (long i = 0; i < n; ++i)
+        from[std::size_t(i)] = int(i);
+    std::allocator<Obj> sa;
+    Obj* p = sa.allocate(std::size_t(n));
+    auto reset = [&]() { exp::internal::destroy_range(p, p + n); };
+
+    bench::runBatch(suite, "loop", n, [&]() {
+            for (long i = 0; i < n; ++i)
+                exp::uninitialized_construct_using_allocator(p + i, a,
+                                                        from[std::size_t(i)]);
+        }, reset);
+
+    bench::runBatch(suite, "uninitialized_copy_using_allocator", n, [&]() {
+            exp::uninitialized_copy_using_allocator(from.data(),
+                                                    from.data() + n, p, a);
+        }, reset);
+
+    sa.deallocate(p, std::size_t(n));
+}
+
+int main(int argc, char *argv[])
+{
+    bench::parseArgs(argc, argv);
+    bench::printHeader();
+
+    const Alloc a(1);
+
+    auto oneInt = [](int v) { return std::make_tuple(v); };
+    auto twoInts = [](int v) { return std::make_tuple(v, v); };
+
+    runSuite<NoAllocObj>("no_allocator", a, oneInt,
+        [](NoAllocObj* p, const Alloc&, int v) {
+            return ::new(static_cast<void*>(p)) NoAllocObj(v);
+        });
+
+    runSuite<PrefixObj>("prefix", a, oneInt,
+        [](PrefixObj* p, const Alloc& a, int v) {
+            return ::new(static_cast<void*>(p))
+                PrefixObj(std::allocator_arg, a, v);
+        });
+
+    runSuite<SuffixObj>("suffix", a, oneInt,
+        [](SuffixObj* p, const Alloc& a, int v) {
+            return ::new(static_cast<void*>(p)) SuffixObj(v, a);
+        });
+
+    typedef std::pair<PrefixObj, SuffixObj> Pair;
+    runSuite<Pair>("pair", a, twoInts,
+        [](Pair* p, const Alloc& a, int v) {
+            return ::new(static_cast<void*>(p))
+                Pair(std::piecewise_construct,
+                     std::forward_as_tuple(std::allocator_arg, a, v),
+                     std::forward_as_tuple(v, a));
+        });
+
+    // Nested pair, constructed from a pair value and a scalar.
+    typedef std::pair<std::pair<PrefixObj, SuffixObj>, NoAllocObj> Nested;
+    runSuite<Nested>("nested_pair", a,
+        [](int v) { return std::make_tuple(std::make_pair(v, v), v); },
+        [](Nested* p, const Alloc& a, int v) {
+            return ::new(static_cast<void*>(p))
+                Nested(std::piecewise_construct,
+                       std::forward_as_tuple(
+                           std::piecewise_construct,
+                           std::forward_as_tuple(std::allocator_arg, a, v),
+                           std::forward_as_tuple(v, a)),
+                       std::forward_as_tuple(v));
+        });
+
+    runRangeSuite<int>("range_copy_int", a);
+    runRangeSuite<PrefixObj>("range_copy_prefix", a);
+
+    return 0;
+}
@@ -9,6 +9,20 @@
 
 #include <make_from_tuple.h>
 #include <memory>
+#include <iterator>
+#include <cstring>
+
+// In C++17 and later, `uses_allocator_construction_args` selects among the
+// argument protocols with `if constexpr` in a single function body, which
+// instantiates far fewer function templates (and emits less debug
+// information) than the C++14 tag-dispatched overload set.  Define
+// `USES_ALLOCATOR_TAG_DISPATCH` to use the overload set in every mode, e.g.,
+// to compare the two.
+#if __cplusplus >= 201703L && ! defined(USES_ALLOCATOR_TAG_DISPATCH)
+#define USES_ALLOCATOR_IF_CONSTEXPR 1
+#else
+#define USES_ALLOCATOR_IF_CONSTEXPR 0
+#endif
 
 namespace std {
 
@@ -18,7 +32,9 @@ inline namespace Cpp20 {
 
 // Forward declaration
 template <class T, class Alloc, class... Args>
-auto uses_allocator_construction_args(const Alloc& a, Args&&... args);
+CPP20_CONSTEXPR
+auto uses_allocator_construction_args(const Alloc& a,
+                                      Args&&... args) noexcept;
 
 namespace internal {
 
@@ -33,6 +49,38 @@ struct has_allocator<pair<T1, T2>, A>
 {
 };
 
+template <bool... B> struct bool_pack;
+
+// True if any of `B...` is true.
+template <bool... B>
+struct any_true
+    : integral_constant<bool, ! is_same<bool_pack<false, B...>,
+                                        bool_pack<B..., false>>::value>
+{
+};
+
+// Specialization of `has_allocator` for `std::tuple`: true if any element
+// uses the allocator.  (`std::uses_allocator` is true for every tuple.)
+template <class... E, class A>
+struct has_allocator<tuple<E...>, A>
+    : any_true<has_allocator<E, A>::value...>
+{
+};
+
+// Construct a `T` at `p` from `args`, with `std::construct_at` in C++20 so
+// that it can be done during constant evaluation.
+template <class T, class... Args>
+CPP20_CONSTEXPR
+T* construct_at(T* p, Args&&... args)
+    noexcept(is_nothrow_constructible<T, Args...>::value)
+{
+#if __cplusplus > 201703L
+    return std::construct_at(p, std::forward<Args>(args)...);
+#else
+    return ::new(static_cast<void*>(p)) T(std::forward<Args>(args)...);
+#endif
+}
+
 template <bool V> using boolean_constant = integral_constant<bool, V>;
 
 template <class T> struct is_pair : false_type { };
@@ -40,10 +88,132 @@ template <class T> struct is_pair : false_type { };
 template <class T1, class T2>
 struct is_pair<std::pair<T1, T2>> : true_type { };
 
+template <class T> struct is_tuple : false_type { };
+
+template <class... E>
+struct is_tuple<std::tuple<E...>> : true_type { };
+
+// True if all of `B...` are true.
+template <bool... B>
+struct all_true
+    : integral_constant<bool, is_same<bool_pack<true, B...>,
+                                      bool_pack<B..., true>>::value>
+{
+};
+
+// Tag for a specialization of `std::tuple`, in place of `true_type` or
+// `false_type` for whether a type is a pair.
+struct tuple_tag { };
+
+// `tuple_tag` for a tuple, otherwise `true_type` or `false_type` depending
+// on whether `T` is a pair.
+template <class T>
+using pair_or_tuple_tag = conditional_t<is_tuple<T>::value, tuple_tag,
+                                        typename is_pair<T>::type>;
+
+// True if `T` is a pair that uses the allocator `A`, or a tuple with such an
+// element.  The allocator-extended constructors of `std::tuple` construct
+// each element in place by uses-allocator construction, but as defined by
+// `std::uses_allocator`, which does not reach the members of a pair.
+template <class T, class A>
+struct has_pair_using_allocator : false_type { };
+
+template <class T1, class T2, class A>
+struct has_pair_using_allocator<pair<T1, T2>, A>
+    : has_allocator<pair<T1, T2>, A>
+{
+};
+
+template <class... E, class A>
+struct has_pair_using_allocator<tuple<E...>, A>
+    : any_true<has_pair_using_allocator<E, A>::value...>
+{
+};
+
+// True if the allocator-extended constructor of `std::tuple` constructs the
+// element `E` from allocator `Alloc` and the (zero or one) arguments `X`
+// without throwing.  A nested tuple of element arguments, as built by
+// `tuple_element_arg`, is checked element by element.
+template <class E, class Alloc, class... X>
+struct is_nothrow_tuple_element
+    : conditional_t<! uses_allocator<E, Alloc>::value,
+                    is_nothrow_constructible<E, X...>,
+          conditional_t<is_constructible<E, allocator_arg_t, const Alloc&,
+                                         X...>::value,
+                        is_nothrow_constructible<E, allocator_arg_t,
+                                                 const Alloc&, X...>,
+                        is_nothrow_constructible<E, X..., const Alloc&>>>
+{
+};
+
+template <class... F, class Alloc, class... Y>
+struct is_nothrow_tuple_element<tuple<F...>, Alloc, tuple<Y...>>
+    : all_true<is_nothrow_tuple_element<F, Alloc, Y>::value...>
+{
+};
+
+// True if constructing a `T` from the uses-allocator argument tuple
+// `ArgsTuple` cannot throw.  The piecewise constructor of `std::pair` and
+// the allocator-extended constructors of `std::tuple` are not `noexcept`,
+// so for a pair built from `piecewise_construct` and a tuple of arguments
+// for each member, the members are checked instead, and likewise for the
+// elements of a tuple built from `allocator_arg` and an allocator.
+template <class T, class ArgsTuple>
+struct is_nothrow_constructible_from_args
+    : Cpp17::internal::is_nothrow_constructible_from_tuple<T, ArgsTuple>
+{
+};
+
+template <class T1, class T2, class Tuple1, class Tuple2>
+struct is_nothrow_constructible_from_args<pair<T1, T2>,
+                              tuple<piecewise_construct_t, Tuple1, Tuple2>>
+    : integral_constant<bool,
+                    is_nothrow_constructible_from_args<T1, Tuple1>::value &&
+                    is_nothrow_constructible_from_args<T2, Tuple2>::value>
+{
+};
+
+// A pair that does not use the allocator gets its arguments forwarded
+// unchanged, as references.
+template <class T1, class T2, class Tuple1, class Tuple2>
+struct is_nothrow_constructible_from_args<pair<T1, T2>,
+                       tuple<const piecewise_construct_t&, Tuple1, Tuple2>>
+    : is_nothrow_constructible_from_args<pair<T1, T2>,
+                       tuple<piecewise_construct_t, decay_t<Tuple1>,
+                             decay_t<Tuple2>>>
+{
+};
+
+template <class T1, class T2, class Tuple1, class Tuple2>
+struct is_nothrow_constructible_from_args<pair<T1, T2>,
+                            tuple<piecewise_construct_t&&, Tuple1, Tuple2>>
+    : is_nothrow_constructible_from_args<pair<T1, T2>,
+                       tuple<piecewise_construct_t, decay_t<Tuple1>,
+                             decay_t<Tuple2>>>
+{
+};
+
+template <class... E, class Alloc>
+struct is_nothrow_constructible_from_args<tuple<E...>,
+                                  tuple<allocator_arg_t, const Alloc&>>
+    : all_true<is_nothrow_tuple_element<E, Alloc>::value...>
+{
+};
+
+template <class... E, class Alloc, class... X>
+struct is_nothrow_constructible_from_args<tuple<E...>,
+                                  tuple<allocator_arg_t, const Alloc&, X...>>
+    : all_true<is_nothrow_tuple_element<E, Alloc, X>::value...>
+{
+};
+
+#if ! USES_ALLOCATOR_IF_CONSTEXPR
+
 // Return a tuple of arguments appropriate for uses-allocator construction
 // with allocator `Alloc` and ctor arguments `Args`.
 // This overload is handles types for which `has_allocator<T, Alloc>` is false.
 template <class T, class Unused1, class Unused2, class Alloc, class... Args>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(Unused1      /* is_pair */,
                              false_type   /* has_allocator */,
                              Unused2      /* uses prefix allocator arg */,
@@ -59,6 +229,7 @@ auto uses_allocator_args_imp(Unused1      /* is_pair */,
 // This overload handles non-pair `T` for which `has_allocator<T, Alloc>` is
 // true and constructor `T(allocator_arg_t, a, args...)` is valid.
 template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(false_type /* is_pair */,
                              true_type  /* has_allocator */,
                              true_type  /* uses prefix allocator arg */,
@@ -76,6 +247,7 @@ auto uses_allocator_args_imp(false_type /* is_pair */,
 // true and constructor `T(allocator_arg_t, a, args...)` NOT valid.
 // This function will produce invalid results unless `T(args..., a)` is valid.
 template <class T1, class Alloc, class... Args>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(false_type /* is_pair */,
                              true_type  /* has_allocator */,
                              false_type /* prefix allocator arg */,
@@ -92,6 +264,7 @@ auto uses_allocator_args_imp(false_type /* is_pair */,
 // `has_allocator<T, Alloc>` is true for either or both of the elements and
 // piecewise_construct arguments are passed in.
 template <class T, class Alloc, class Tuple1, class Tuple2>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(true_type  /* is_pair */,
                              true_type  /* has_allocator */,
                              false_type /* prefix allocator arg */,
@@ -104,12 +277,14 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
 
     return make_tuple(piecewise_construct,
                       apply([&a](auto&&... args1) -> auto {
-                              return uses_allocator_construction_args<T1>(a,
-                                     std::forward<decltype(args1)>(args1)...);
+                              return Cpp20::uses_allocator_construction_args<
+                                  T1>(a,
+                                      std::forward<decltype(args1)>(args1)...);
                           }, std::forward<Tuple1>(x)),
                       apply([&a](auto&&... args2) -> auto {
-                              return uses_allocator_construction_args<T2>(a,
-                                     std::forward<decltype(args2)>(args2)...);
+                              return Cpp20::uses_allocator_construction_args<
+                                  T2>(a,
+                                      std::forward<decltype(args2)>(args2)...);
                           }, std::forward<Tuple2>(y))
         );
 }
@@ -120,6 +295,7 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
 // `has_allocator<T, Alloc>` is true for either or both of the elements and
 // no other constructor arguments are passed in.
 template <class T, class Alloc>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(true_type  /* is_pair */,
                              true_type  /* has_allocator */,
                              false_type /* prefix allocator arg */,
@@ -132,8 +308,8 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
     //     piecewise_construct,
     //     uses_allocator_construction_args<T1>(a),
     //     uses_allocator_construction_args<T2>(a));
-    return uses_allocator_construction_args<T>(a, piecewise_construct,
-                                               tuple<>{}, tuple<>{});
+    return Cpp20::uses_allocator_construction_args<T>(a, piecewise_construct,
+                                                      tuple<>{}, tuple<>{});
 }
 
 // Return a tuple of arguments appropriate for uses-allocator construction
@@ -142,6 +318,7 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
 // `has_allocator<T, Alloc>` is true for either or both of the elements and
 // a single argument of type const-lvalue-of-pair is passed in.
 template <class T, class Alloc, class U1, class U2>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(true_type  /* is_pair */,
                                 true_type  /* has_allocator */,
                                 false_type /* prefix allocator arg */,
@@ -155,7 +332,7 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
     //     piecewise_construct,
     //     uses_allocator_construction_args<T1>(a, arg.first),
     //     uses_allocator_construction_args<T2>(a, arg.second));
-    return uses_allocator_construction_args<T>(a, piecewise_construct,
+    return Cpp20::uses_allocator_construction_args<T>(a, piecewise_construct,
                                                forward_as_tuple(arg.first),
                                                forward_as_tuple(arg.second));
 }
@@ -166,6 +343,7 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
 // `has_allocator<T, Alloc>` is true for either or both of the elements and
 // a single argument of type rvalue-of-pair is passed in.
 template <class T, class Alloc, class U1, class U2>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(true_type  /* is_pair */,
                                 true_type  /* has_allocator */,
                                 false_type /* prefix allocator arg */,
@@ -179,7 +357,7 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
     //     piecewise_construct,
     //     uses_allocator_construction_args<T1>(a, forward<U1>(arg.first)),
     //     uses_allocator_construction_args<T2>(a, forward<U2>(arg.second)));
-    return uses_allocator_construction_args<T>(a, piecewise_construct,
+    return Cpp20::uses_allocator_construction_args<T>(a, piecewise_construct,
                                    forward_as_tuple(forward<U1>(arg.first)),
                                    forward_as_tuple(forward<U2>(arg.second)));
 }
@@ -190,6 +368,7 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
 // `has_allocator<T, Alloc>` is true for either or both of the elements and
 // two additional constructor arguments are passed in.
 template <class T, class Alloc, class U1, class U2>
+CPP20_CONSTEXPR
 auto uses_allocator_args_imp(true_type  /* is_pair */,
                              true_type  /* has_allocator */,
                              false_type /* prefix allocator arg */,
@@ -203,40 +382,1162 @@ auto uses_allocator_args_imp(true_type  /* is_pair */,
     //     piecewise_construct,
     //     uses_allocator_construction_args<T1>(a, forward<U1>(arg1)),
     //     uses_allocator_construction_args<T2>(a, forward<U2>(arg2)));
-    return uses_allocator_construction_args<T>(a, piecewise_construct,
+    return Cpp20::uses_allocator_construction_args<T>(a, piecewise_construct,
                                    forward_as_tuple(forward<U1>(arg1)),
                                    forward_as_tuple(forward<U2>(arg2)));
 }
 
+#endif // ! USES_ALLOCATOR_IF_CONSTEXPR
+
+// An object that converts to a `T` constructed from the uses-allocator
+// argument tuple `ArgsTuple`.  `std::tuple` has no piecewise constructor,
+// so a tuple element that its allocator-extended constructors cannot build
+// (a pair using the allocator, or any element of a tuple whose
+// allocator-extended constructor is unavailable) is passed as one of these
+// and initialized from the result of the conversion.  The arguments are
+// forwarded, so the conversion can be performed only once.
+template <class T, class ArgsTuple>
+class uses_allocator_element
+{
+    ArgsTuple m_args;
+
+public:
+    CPP20_CONSTEXPR explicit uses_allocator_element(ArgsTuple&& args) noexcept
+        : m_args(std::move(args)) { }
+
+    CPP20_CONSTEXPR operator T()
+        noexcept(is_nothrow_constructible_from_args<T, ArgsTuple>::value)
+        { return make_from_tuple<T>(std::move(m_args)); }
+};
+
+// Return an object that converts to a `T` constructed by uses-allocator
+// construction from allocator `a` and ctor arguments `args`.
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+auto make_uses_allocator_element(const Alloc& a, Args&&... args)
+{
+    using ArgsTuple = decltype(Cpp20::uses_allocator_construction_args<T>(
+                                              a, std::forward<Args>(args)...));
+    return uses_allocator_element<T, ArgsTuple>(
+        Cpp20::uses_allocator_construction_args<T>(a,
+                                                 std::forward<Args>(args)...));
+}
+
+template <class E, class Alloc, class U>
+CPP20_CONSTEXPR
+decltype(auto) tuple_element_arg(const Alloc& a, U&& u);
+
+// Return the argument from which the allocator-extended constructor of
+// `std::tuple` constructs the element `E` with allocator `a`.  An element
+// that is not and does not contain a pair using the allocator is
+// constructed in place from `u` itself.
+template <class E, class Unused, class Alloc, class U>
+CPP20_CONSTEXPR
+U&& tuple_element_arg_imp(Unused     /* is_pair */,
+                          false_type /* has_pair_using_allocator */,
+                          const Alloc&, U&& u)
+{
+    return std::forward<U>(u);
+}
+
+// Return the argument from which the allocator-extended constructor of
+// `std::tuple` constructs the pair `E`, which uses allocator `a`.
+template <class E, class Alloc, class U>
+CPP20_CONSTEXPR
+auto tuple_element_arg_imp(true_type /* is_pair */,
+                           true_type /* has_pair_using_allocator */,
+                           const Alloc& a, U&& u)
+{
+    return make_uses_allocator_element<E>(a, std::forward<U>(u));
+}
+
+// Return the argument from which the allocator-extended constructor of
+// `std::tuple` constructs the tuple `E`, which has a pair element using
+// allocator `a`: a tuple of arguments for each element of `E`, taken from
+// the elements of the tuple `u`.
+template <class E, class Alloc, class U, size_t... I>
+CPP20_CONSTEXPR
+auto nested_tuple_element_args(const Alloc& a, U&& u, index_sequence<I...>)
+{
+    return tuple<decltype(tuple_element_arg<tuple_element_t<I, E>>(
+                              a, get<I>(std::forward<U>(u))))...>(
+        tuple_element_arg<tuple_element_t<I, E>>(
+            a, get<I>(std::forward<U>(u)))...);
+}
+
+template <class E, class Alloc, class U>
+CPP20_CONSTEXPR
+auto tuple_element_arg_imp(tuple_tag /* is_pair */,
+                           true_type /* has_pair_using_allocator */,
+                           const Alloc& a, U&& u)
+{
+    static_assert(tuple_size<decay_t<U>>::value == tuple_size<E>::value,
+                  "Wrong number of elements in tuple argument");
+    return nested_tuple_element_args<E>(a, std::forward<U>(u),
+                                 make_index_sequence<tuple_size<E>::value>{});
+}
+
+template <class E, class Alloc, class U>
+CPP20_CONSTEXPR
+decltype(auto) tuple_element_arg(const Alloc& a, U&& u)
+{
+    return tuple_element_arg_imp<E>(pair_or_tuple_tag<E>(),
+                                    has_pair_using_allocator<E, Alloc>(),
+                                    a, std::forward<U>(u));
+}
+
+// The type of the argument from which the allocator-extended constructor
+// of `std::tuple` constructs the element `E` with an allocator of type
+// `Alloc`, given an argument of type `U`.
+template <class E, class Alloc, class U>
+using tuple_element_arg_t =
+    decltype(tuple_element_arg<E>(std::declval<const Alloc&>(),
+                                  std::declval<U>()));
+
+template <class T, class Alloc, class Tuple, class Indexes>
+struct is_tuple_constructible_in_place_imp;
+
+template <class T, class Alloc, class Tuple, size_t... I>
+struct is_tuple_constructible_in_place_imp<T, Alloc, Tuple,
+                                           index_sequence<I...>>
+    : is_constructible<T, allocator_arg_t, const Alloc&,
+                       tuple_element_arg_t<tuple_element_t<I, T>, Alloc,
+                          decltype(get<I>(std::declval<Tuple>()))>...>
+{
+};
+
+// True if the allocator-extended constructor of the tuple type `T` accepts
+// allocator `Alloc` and an argument for each element taken from the tuple
+// `Tuple`.  It is constrained on each element being constructible from its
+// argument without the allocator.
+template <class T, class Alloc, class Tuple>
+using is_tuple_constructible_in_place =
+    is_tuple_constructible_in_place_imp<T, Alloc, Tuple,
+                                 make_index_sequence<tuple_size<T>::value>>;
+
+// Return a tuple of arguments for constructing the tuple type `T` with
+// allocator `a`, the `I`th element being constructed from `get<I>(args)`.
+// The allocator-extended constructor of `std::tuple` constructs each
+// element in place by uses-allocator construction.
+template <class T, class Alloc, class Tuple, size_t... I>
+CPP20_CONSTEXPR
+auto tuple_elements_from_tuple_imp(true_type /* in place */,
+                                   const Alloc& a, Tuple&& args,
+                                   index_sequence<I...>)
+{
+    return tuple<allocator_arg_t, const Alloc&,
+                 tuple_element_arg_t<tuple_element_t<I, T>, Alloc,
+                     decltype(get<I>(std::forward<Tuple>(args)))>...>(
+        allocator_arg, a,
+        tuple_element_arg<tuple_element_t<I, T>>(
+            a, get<I>(std::forward<Tuple>(args)))...);
+}
+
+// Return a tuple of arguments for constructing the tuple type `T` with
+// allocator `a`, the `I`th element being constructed from `get<I>(args)`,
+// when the allocator-extended constructor of `T` is not available.  Every
+// element is passed as a `uses_allocator_element` and must therefore be
+// move constructible.
+template <class T, class Alloc, class Tuple, size_t... I>
+CPP20_CONSTEXPR
+auto tuple_elements_from_tuple_imp(false_type /* in place */,
+                                   const Alloc& a, Tuple&& args,
+                                   index_sequence<I...>)
+{
+    return make_tuple(make_uses_allocator_element<tuple_element_t<I, T>>(
+                          a, get<I>(std::forward<Tuple>(args)))...);
+}
+
+// Return a tuple of arguments for constructing the tuple type `T` with
+// allocator `a`, the `I`th element being constructed from `get<I>(args)`.
+template <class T, class Alloc, class Tuple, size_t... I>
+CPP20_CONSTEXPR
+auto tuple_elements_from_tuple(const Alloc& a, Tuple&& args,
+                               index_sequence<I...> i)
+{
+    return tuple_elements_from_tuple_imp<T>(
+        is_tuple_constructible_in_place<T, Alloc, Tuple&&>(),
+        a, std::forward<Tuple>(args), i);
+}
+
+// True if the tuple type `T` can be constructed from allocator `Alloc`
+// alone by its allocator-extended constructor: no element is a pair using
+// the allocator, and the constructor is available (libstdc++ provides it
+// only if every element is implicitly default constructible).
+template <class T, class Alloc>
+using is_tuple_constructible_from_alloc =
+    boolean_constant<! has_pair_using_allocator<T, Alloc>::value &&
+                     is_constructible<T, allocator_arg_t,
+                                      const Alloc&>::value>;
+
+// Return a tuple of arguments for constructing the tuple type `T` from
+// allocator `a` alone, with its allocator-extended constructor.
+template <class T, class Alloc, size_t... I>
+CPP20_CONSTEXPR
+auto tuple_elements_from_alloc_imp(true_type /* constructible from alloc */,
+                                   const Alloc& a, index_sequence<I...>)
+{
+    return tuple<allocator_arg_t, const Alloc&>(allocator_arg, a);
+}
+
+// Return a tuple of arguments for constructing the tuple type `T` from
+// allocator `a` alone, when `T` cannot be given only the allocator.  A
+// tuple constructor cannot be given arguments for some elements but not
+// others, so every element is passed as a `uses_allocator_element` and
+// must therefore be move constructible.
+template <class T, class Alloc, size_t... I>
+CPP20_CONSTEXPR
+auto tuple_elements_from_alloc_imp(false_type /* constructible from alloc */,
+                                   const Alloc& a, index_sequence<I...>)
+{
+    return make_tuple(
+        make_uses_allocator_element<tuple_element_t<I, T>>(a)...);
+}
+
+// Return a tuple of arguments for constructing the tuple type `T` from
+// allocator `a` alone.
+template <class T, class Alloc, size_t... I>
+CPP20_CONSTEXPR
+auto tuple_elements_from_alloc(const Alloc& a, index_sequence<I...> i)
+{
+    return tuple_elements_from_alloc_imp<T>(
+        is_tuple_constructible_from_alloc<T, Alloc>(), a, i);
+}
+
+#if USES_ALLOCATOR_IF_CONSTEXPR
+
+// Return a tuple of arguments appropriate for uses-allocator construction
+// of the `std::pair` `T` with allocator `Alloc` from `piecewise_construct`
+// and a tuple of arguments for each member.  Every form of pair construction
+// is reduced to this one.
+template <class T, class Alloc, class Tuple1, class Tuple2>
+CPP20_CONSTEXPR
+auto pair_piecewise_args(const Alloc& a, piecewise_construct_t,
+                         Tuple1&& x, Tuple2&& y)
+{
+    using T1 = typename T::first_type;
+    using T2 = typename T::second_type;
+
+    return make_tuple(piecewise_construct,
+                      apply([&a](auto&&... args1) -> auto {
+                              return Cpp20::uses_allocator_construction_args<
+                                  T1>(a,
+                                      std::forward<decltype(args1)>(args1)...);
+                          }, std::forward<Tuple1>(x)),
+                      apply([&a](auto&&... args2) -> auto {
+                              return Cpp20::uses_allocator_construction_args<
+                                  T2>(a,
+                                      std::forward<decltype(args2)>(args2)...);
+                          }, std::forward<Tuple2>(y))
+        );
+}
+
+// True if `Args` is a single tuple argument.
+template <class... Args>
+struct single_tuple_arg : false_type { };
+
+template <class A>
+struct single_tuple_arg<A> : is_tuple<decay_t<A>> { };
+
+// The type to which a pair or tuple argument of type `A&&` is forwarded: a
+// modifiable lvalue is treated as a const lvalue.
+template <class A>
+using const_lvalue_or_rvalue_t = conditional_t<is_lvalue_reference<A>::value,
+                                               const remove_reference_t<A>&,
+                                               A&&>;
+
+#else // if ! USES_ALLOCATOR_IF_CONSTEXPR
+
+// Return a tuple of arguments appropriate for uses-allocator construction
+// with allocator `Alloc` and ctor arguments `Args`.
+// This overload handles specializations of `T` = `std::tuple` for which
+// `has_allocator<T, Alloc>` is true for at least one of the elements and
+// no other constructor arguments are passed in.
+template <class T, class Unused, class Alloc>
+CPP20_CONSTEXPR
+auto uses_allocator_args_imp(tuple_tag  /* is_pair */,
+                             true_type  /* has_allocator */,
+                             Unused     /* prefix allocator arg */,
+                             const Alloc& a)
+{
+    return tuple_elements_from_alloc<T>(a,
+                                make_index_sequence<tuple_size<T>::value>{});
+}
+
+// Return a tuple of arguments appropriate for uses-allocator construction
+// with allocator `Alloc` and ctor arguments `Args`.
+// This overload handles specializations of `T` = `std::tuple` for which
+// `has_allocator<T, Alloc>` is true for at least one of the elements and
+// a single argument of type const-lvalue-of-tuple is passed in.
+template <class T, class Unused, class Alloc, class... U>
+CPP20_CONSTEXPR
+auto uses_allocator_args_imp(tuple_tag  /* is_pair */,
+                             true_type  /* has_allocator */,
+                             Unused     /* prefix allocator arg */,
+                             const Alloc& a,
+                             const tuple<U...>& arg)
+{
+    static_assert(sizeof...(U) == tuple_size<T>::value,
+                  "Wrong number of elements in tuple argument");
+    return tuple_elements_from_tuple<T>(a, arg,
+                                        index_sequence_for<U...>{});
+}
+
+// Return a tuple of arguments appropriate for uses-allocator construction
+// with allocator `Alloc` and ctor arguments `Args`.
+// This overload handles specializations of `T` = `std::tuple` for which
+// `has_allocator<T, Alloc>` is true for at least one of the elements and
+// a single argument of type modifiable-lvalue-of-tuple is passed in.
+template <class T, class Unused, class Alloc, class... U>
+CPP20_CONSTEXPR
+auto uses_allocator_args_imp(tuple_tag  /* is_pair */,
+                             true_type  /* has_allocator */,
+                             Unused     /* prefix allocator arg */,
+                             const Alloc& a,
+                             tuple<U...>& arg)
+{
+    return uses_allocator_args_imp<T>(tuple_tag{}, true_type{}, Unused{}, a,
+                                      static_cast<const tuple<U...>&>(arg));
+}
+
+// Return a tuple of arguments appropriate for uses-allocator construction
+// with allocator `Alloc` and ctor arguments `Args`.
+// This overload handles specializations of `T` = `std::tuple` for which
+// `has_allocator<T, Alloc>` is true for at least one of the elements and
+// a single argument of type rvalue-of-tuple is passed in.
+template <class T, class Unused, class Alloc, class... U>
+CPP20_CONSTEXPR
+auto uses_allocator_args_imp(tuple_tag  /* is_pair */,
+                             true_type  /* has_allocator */,
+                             Unused     /* prefix allocator arg */,
+                             const Alloc& a,
+                             tuple<U...>&& arg)
+{
+    static_assert(sizeof...(U) == tuple_size<T>::value,
+                  "Wrong number of elements in tuple argument");
+    return tuple_elements_from_tuple<T>(a, std::move(arg),
+                                        index_sequence_for<U...>{});
+}
+
+// Return a tuple of arguments appropriate for uses-allocator construction
+// with allocator `Alloc` and ctor arguments `Args`.
+// This overload handles specializations of `T` = `std::tuple` for which
+// `has_allocator<T, Alloc>` is true for at least one of the elements and
+// one constructor argument per element is passed in.
+template <class T, class Unused, class Alloc, class U1, class... U>
+CPP20_CONSTEXPR
+auto uses_allocator_args_imp(tuple_tag  /* is_pair */,
+                             true_type  /* has_allocator */,
+                             Unused     /* prefix allocator arg */,
+                             const Alloc& a,
+                             U1&& arg1, U&&... args)
+{
+    static_assert(1 + sizeof...(U) == tuple_size<T>::value,
+                  "Wrong number of arguments for tuple elements");
+    return tuple_elements_from_tuple<T>(a,
+                   forward_as_tuple(std::forward<U1>(arg1),
+                                    std::forward<U>(args)...),
+                   make_index_sequence<tuple_size<T>::value>{});
+}
+
+#endif // ! USES_ALLOCATOR_IF_CONSTEXPR
+
 } // close namespace internal
 
+// The returned tuple holds only references (or objects holding only
+// references), so building it cannot throw.
 template <class T, class Alloc, class... Args>
-auto uses_allocator_construction_args(const Alloc& a, Args&&... args)
+CPP20_CONSTEXPR
+auto uses_allocator_construction_args(const Alloc& a,
+                                      Args&&... args) noexcept
 {
     using namespace internal;
-    return uses_allocator_args_imp<T>(is_pair<T>(),
+#if USES_ALLOCATOR_IF_CONSTEXPR
+    if constexpr (! has_allocator<T, Alloc>::value) {
+        // Allocator is ignored
+        return std::forward_as_tuple(std::forward<Args>(args)...);
+    }
+    else if constexpr (is_pair<T>::value) {
+        if constexpr (sizeof...(Args) == 0) {
+            return pair_piecewise_args<T>(a, piecewise_construct,
+                                          tuple<>{}, tuple<>{});
+        }
+        else if constexpr (sizeof...(Args) == 1) {
+            // A single pair argument
+            return pair_piecewise_args<T>(a, piecewise_construct,
+                       std::forward_as_tuple(static_cast<
+                           const_lvalue_or_rvalue_t<Args>>(args).first...),
+                       std::forward_as_tuple(static_cast<
+                           const_lvalue_or_rvalue_t<Args>>(args).second...));
+        }
+        else if constexpr (sizeof...(Args) == 2) {
+            // One argument for each member
+            return pair_piecewise_args<T>(a, piecewise_construct,
+                       std::forward_as_tuple(std::forward<Args>(args))...);
+        }
+        else {
+            // `piecewise_construct` and a tuple of arguments for each member
+            return pair_piecewise_args<T>(a, std::forward<Args>(args)...);
+        }
+    }
+    else if constexpr (is_tuple<T>::value) {
+        constexpr size_t N = tuple_size<T>::value;
+        if constexpr (sizeof...(Args) == 0) {
+            return tuple_elements_from_alloc<T>(a, make_index_sequence<N>{});
+        }
+        else if constexpr (single_tuple_arg<Args...>::value) {
+            static_assert(((tuple_size<decay_t<Args>>::value == N) && ...),
+                          "Wrong number of elements in tuple argument");
+            return tuple_elements_from_tuple<T>(a,
+                        static_cast<const_lvalue_or_rvalue_t<Args>>(args)...,
+                        make_index_sequence<N>{});
+        }
+        else {
+            static_assert(sizeof...(Args) == N,
+                          "Wrong number of arguments for tuple elements");
+            return tuple_elements_from_tuple<T>(a,
+                           std::forward_as_tuple(std::forward<Args>(args)...),
+                           make_index_sequence<N>{});
+        }
+    }
+    else if constexpr (is_constructible<T, allocator_arg_t,
+                                        Alloc, Args...>::value) {
+        // Allocator added to front of argument list, after `allocator_arg`.
+        return tuple<allocator_arg_t, const Alloc&,
+                     Args&&...>(allocator_arg, a, std::forward<Args>(args)...);
+    }
+    else {
+        // Allocator added to end of argument list
+        return std::forward_as_tuple(std::forward<Args>(args)..., a);
+    }
+#else
+    return uses_allocator_args_imp<T>(pair_or_tuple_tag<T>(),
                                       has_allocator<T, Alloc>(),
                                       is_constructible<T, allocator_arg_t,
                                                        Alloc, Args...>(),
                                       a, std::forward<Args>(args)...);
+#endif
+}
+
+namespace internal {
+
+// True if uses-allocator construction of a `T` with allocator `Alloc` and
+// ctor arguments `Args` cannot throw, i.e., if the constructor selected by
+// `uses_allocator_construction_args` is `noexcept`.
+template <class T, class Alloc, class... Args>
+using is_nothrow_uses_allocator_constructible =
+    is_nothrow_constructible_from_args<T,
+        decltype(Cpp20::uses_allocator_construction_args<T>(
+                     std::declval<const Alloc&>(), std::declval<Args>()...))>;
+
+// Return `x` as an rvalue if uses-allocator construction of a `T` from an
+// rvalue `T` with allocator `Alloc` cannot throw (or `T` cannot be copied),
+// and as a const lvalue otherwise.  Unlike `std::move_if_noexcept`, this
+// checks the constructor that uses-allocator construction would actually
+// select, e.g., `T(allocator_arg, a, std::move(x))` or
+// `T(std::move(x), a)` rather than `T(std::move(x))`.
+template <class Alloc, class T>
+inline conditional_t<
+           ! is_nothrow_uses_allocator_constructible<T, Alloc, T&&>::value &&
+           is_copy_constructible<T>::value, const T&, T&&>
+move_if_noexcept_using_allocator(T& x) noexcept
+{
+    return std::move(x);
 }
 
+// True if uses-allocator construction of a `T` with allocator `Alloc` is
+// the piecewise construction of a pair whose members are passed the
+// allocator.
+template <class T, class Alloc>
+using is_pair_using_allocator =
+    boolean_constant<is_pair<T>::value && has_allocator<T, Alloc>::value>;
+
 template <class T, class Alloc, class... Args>
-T make_obj_using_allocator(const Alloc& a, Args&&... args)
+CPP20_CONSTEXPR
+auto pair_member_args(false_type /* is_pair_using_allocator */,
+                      const Alloc& a, Args&&... args) noexcept;
+
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+auto pair_member_args(true_type /* is_pair_using_allocator */,
+                      const Alloc& a, Args&&... args) noexcept;
+
+// Return `f(piecewise_construct, x1, x2)`, where `x1` and `x2` are the
+// arguments from which the members of the pair `T` are built by
+// uses-allocator construction with allocator `a` from `piecewise_construct`
+// and the argument tuples `x` and `y`.  Unlike the result of
+// `uses_allocator_construction_args`, no tuple holding the member argument
+// tuples is built at this level.  A member that is itself a pair is passed
+// one such tuple, of references, since `pair` has no other way to forward
+// piecewise arguments to a member.
+template <class T, class F, class Alloc, class Tuple1, class Tuple2>
+CPP20_CONSTEXPR
+decltype(auto) construct_pair_from_refs(F f, const Alloc& a,
+                                        piecewise_construct_t,
+                                        Tuple1&& x, Tuple2&& y)
+{
+    using T1 = typename T::first_type;
+    using T2 = typename T::second_type;
+
+    return f(piecewise_construct,
+             apply([&a](auto&&... args1) {
+                     return pair_member_args<T1>(
+                         is_pair_using_allocator<T1, Alloc>(), a,
+                         std::forward<decltype(args1)>(args1)...);
+                 }, std::forward<Tuple1>(x)),
+             apply([&a](auto&&... args2) {
+                     return pair_member_args<T2>(
+                         is_pair_using_allocator<T2, Alloc>(), a,
+                         std::forward<decltype(args2)>(args2)...);
+                 }, std::forward<Tuple2>(y)));
+}
+
+// The remaining forms of pair construction, reduced to the piecewise form.
+template <class T, class F, class Alloc>
+CPP20_CONSTEXPR
+decltype(auto) construct_pair_from_refs(F f, const Alloc& a)
+{
+    return construct_pair_from_refs<T>(f, a, piecewise_construct,
+                                       tuple<>{}, tuple<>{});
+}
+
+template <class T, class F, class Alloc, class U1, class U2>
+CPP20_CONSTEXPR
+decltype(auto) construct_pair_from_refs(F f, const Alloc& a,
+                                        const pair<U1, U2>& arg)
+{
+    return construct_pair_from_refs<T>(f, a, piecewise_construct,
+                                       std::forward_as_tuple(arg.first),
+                                       std::forward_as_tuple(arg.second));
+}
+
+template <class T, class F, class Alloc, class U1, class U2>
+CPP20_CONSTEXPR
+decltype(auto) construct_pair_from_refs(F f, const Alloc& a,
+                                        pair<U1, U2>&& arg)
+{
+    return construct_pair_from_refs<T>(f, a, piecewise_construct,
+                         std::forward_as_tuple(std::forward<U1>(arg.first)),
+                         std::forward_as_tuple(std::forward<U2>(arg.second)));
+}
+
+template <class T, class F, class Alloc, class U1, class U2>
+CPP20_CONSTEXPR
+decltype(auto) construct_pair_from_refs(F f, const Alloc& a,
+                                        U1&& arg1, U2&& arg2)
+{
+    return construct_pair_from_refs<T>(f, a, piecewise_construct,
+                               std::forward_as_tuple(std::forward<U1>(arg1)),
+                               std::forward_as_tuple(std::forward<U2>(arg2)));
+}
+
+// Return a tuple of the pieces passed to the call operator.
+struct make_pieces {
+    template <class... Args>
+    CPP20_CONSTEXPR tuple<decay_t<Args>...> operator()(Args&&... args) const
+        { return tuple<decay_t<Args>...>(std::forward<Args>(args)...); }
+};
+
+// Return the tuple of arguments from which the pair member `T` is built by
+// uses-allocator construction with allocator `a` and ctor arguments `args`.
+// For a member that is not itself a pair using the allocator, these are the
+// arguments returned by `uses_allocator_construction_args`, which are
+// references.  A pair member is instead passed `piecewise_construct` and
+// the argument tuples for its own members, so that it too is built in place
+// by the piecewise constructor of `pair`.
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+auto pair_member_args(false_type /* is_pair_using_allocator */,
+                      const Alloc& a, Args&&... args) noexcept
+{
+    return Cpp20::uses_allocator_construction_args<T>(
+                                               a, std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+auto pair_member_args(true_type /* is_pair_using_allocator */,
+                      const Alloc& a, Args&&... args) noexcept
+{
+    return construct_pair_from_refs<T>(make_pieces(), a,
+                                       std::forward<Args>(args)...);
+}
+
+// Return a `T` constructed from the pieces passed to the call operator.
+template <class T>
+struct construct_prvalue {
+    template <class... Args>
+    CPP20_CONSTEXPR T operator()(Args&&... args) const
+        { return T(std::forward<Args>(args)...); }
+};
+
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+T make_obj_using_allocator_imp(false_type /* is_pair_using_allocator */,
+                               const Alloc& a, Args&&... args)
 {
     return make_from_tuple<T>(
-        uses_allocator_construction_args<T>(a, forward<Args>(args)...));
+        Cpp20::uses_allocator_construction_args<T>(a,
+                                                   forward<Args>(args)...));
+}
+
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+T make_obj_using_allocator_imp(true_type /* is_pair_using_allocator */,
+                               const Alloc& a, Args&&... args)
+{
+    return construct_pair_from_refs<T>(construct_prvalue<T>(), a,
+                                       std::forward<Args>(args)...);
+}
+
+// Construct a `T` at `p` from the pieces passed to the call operator.
+template <class T>
+struct construct_at_pointer {
+    T* m_p;
+
+    template <class... Args>
+    CPP20_CONSTEXPR T* operator()(Args&&... args) const
+        { return internal::construct_at(m_p, std::forward<Args>(args)...); }
+};
+
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+T* uninitialized_construct_using_allocator_imp(
+                                 false_type /* is_pair_using_allocator */,
+                                 T* p, const Alloc& a, Args&&... args)
+{
+    return apply(construct_at_pointer<T>{ p },
+                 Cpp20::uses_allocator_construction_args<T>(a,
+                                                      forward<Args>(args)...));
 }
 
 template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+T* uninitialized_construct_using_allocator_imp(
+                                 true_type /* is_pair_using_allocator */,
+                                 T* p, const Alloc& a, Args&&... args)
+{
+    return construct_pair_from_refs<T>(construct_at_pointer<T>{ p }, a,
+                                       std::forward<Args>(args)...);
+}
+
+} // close namespace internal
+
+// A pair whose members use the allocator is constructed without building
+// the argument tuple returned by `uses_allocator_construction_args`: each
+// member is built in place from references to its arguments, at any depth
+// of nesting.  Each nested pair member is passed one tuple of references.
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
+T make_obj_using_allocator(const Alloc& a, Args&&... args)
+    noexcept(internal::is_nothrow_uses_allocator_constructible<T, Alloc,
+                                                               Args...>::value)
+{
+    return internal::make_obj_using_allocator_imp<T>(
+                               internal::is_pair_using_allocator<T, Alloc>(),
+                               a, std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc, class... Args>
+CPP20_CONSTEXPR
 T* uninitialized_construct_using_allocator(T* p,
                                            const Alloc& a,
                                            Args&&... args)
+    noexcept(internal::is_nothrow_uses_allocator_constructible<T, Alloc,
+                                                               Args...>::value)
+{
+    return internal::uninitialized_construct_using_allocator_imp(
+                               internal::is_pair_using_allocator<T, Alloc>(),
+                               p, a, std::forward<Args>(args)...);
+}
+
+namespace internal {
+
+// Return the address held by the raw or fancy pointer `p`, as
+// `std::to_address` does in C++20.
+template <class T>
+constexpr T* to_raw_pointer(T* p) noexcept
+{
+    return p;
+}
+
+template <class Ptr>
+inline auto to_raw_pointer(const Ptr& p) noexcept
+    -> decltype(internal::to_raw_pointer(p.operator->()))
+{
+    return internal::to_raw_pointer(p.operator->());
+}
+
+// True if `Ptr` is a fancy pointer: a class type with `operator->`, such as
+// the `pointer` type of an allocator that does not use raw pointers.
+template <class Ptr, class = void>
+struct is_fancy_pointer : false_type { };
+
+template <class Ptr>
+struct is_fancy_pointer<Ptr,
+                        decltype(void(declval<const Ptr&>().operator->()))>
+    : is_class<Ptr> { };
+
+} // close namespace internal
+
+// Construct an object at the address held by the fancy pointer `p` (e.g.,
+// `allocator_traits<Alloc>::pointer` for an allocator whose pointers are
+// `offset_ptr`) and return `p`.
+template <class Ptr, class Alloc, class... Args>
+inline enable_if_t<internal::is_fancy_pointer<Ptr>::value, Ptr>
+uninitialized_construct_using_allocator(Ptr p, const Alloc& a,
+                                        Args&&... args)
+    noexcept(noexcept(Cpp20::uninitialized_construct_using_allocator(
+                          internal::to_raw_pointer(p), a,
+                          std::forward<Args>(args)...)))
+{
+    Cpp20::uninitialized_construct_using_allocator(
+        internal::to_raw_pointer(p), a, std::forward<Args>(args)...);
+    return p;
+}
+
+namespace internal {
+
+// Construct a `T` at `p` from the already-computed uses-allocator argument
+// tuple `args`.  The tuple is passed as an lvalue so that the same argument
+// list can be reused for many elements.
+template <class T, class Tuple, size_t... I>
+inline T* construct_from_args(T* p, const Tuple& args, index_sequence<I...>)
+{
+    return ::new(static_cast<void*>(p)) T(get<I>(args)...);
+}
+
+// Destroy the objects in the range `[first, last)` in reverse order.  Used to
+// roll back a partially-constructed range.
+template <class T>
+inline void destroy_range(T* first, T* last) noexcept
+{
+    while (last != first)
+        (--last)->~T();
+}
+
+// Given `n` objects of trivially-copyable type `T` starting at `p`, where
+// `p[0]` has already been constructed, fill the remaining `n - 1` objects with
+// copies of `p[0]` using a logarithmic number of `memcpy` calls.
+template <class T>
+inline void replicate_first(T* p, size_t n)
+{
+    if (1 == sizeof(T)) {
+        std::memset(static_cast<void*>(p + 1),
+                    *reinterpret_cast<const unsigned char*>(p), n - 1);
+        return;
+    }
+
+    size_t done = 1;
+    while (done < n) {
+        size_t chunk = (n - done < done) ? n - done : done;
+        std::memcpy(static_cast<void*>(p + done), static_cast<const void*>(p),
+                    chunk * sizeof(T));
+        done += chunk;
+    }
+}
+
+// Construct `n` objects at `p` from the argument tuple `args`.
+// This overload is used when `T` does not use the allocator, is trivially
+// copyable, and is trivially constructible from `args`: the first element
+// is constructed normally and the others are bitwise copies of it.
+template <class T, class Tuple>
+inline T* construct_n_from_args(true_type /* bitwise replicable */,
+                                T* p, size_t n, const Tuple& args)
+{
+    if (0 == n)
+        return p;
+    using Indices = make_index_sequence<tuple_size<Tuple>::value>;
+    construct_from_args(p, args, Indices{});
+    replicate_first(p, n);
+    return p + n;
+}
+
+// Construct `n` objects at `p` from the argument tuple `args`.
+// This overload constructs each element individually.  If a constructor
+// throws, the elements constructed so far are destroyed before rethrowing.
+template <class T, class Tuple>
+inline T* construct_n_from_args(false_type /* bitwise replicable */,
+                                T* p, size_t n, const Tuple& args)
+{
+    using Indices = make_index_sequence<tuple_size<Tuple>::value>;
+    T* cur = p;
+    try {
+        for (T* const end = p + n; cur != end; ++cur)
+            construct_from_args(cur, args, Indices{});
+    }
+    catch (...) {
+        destroy_range(p, cur);
+        throw;
+    }
+    return cur;
+}
+
+// True if objects of type `T` constructed using allocator `Alloc` can be
+// copied with `memcpy`, i.e., `T` does not use the allocator and is
+// trivially copyable.
+template <class T, class Alloc>
+using is_bitwise_constructible =
+    boolean_constant<! has_allocator<T, Alloc>::value &&
+                     is_trivially_copyable<T>::value>;
+
+// True if `n` objects of type `T` constructed using allocator `Alloc` from
+// lvalues of type `Args` can be made by constructing the first and copying
+// its bytes to the others.  The constructor must also be trivial, as a
+// user-provided one (e.g., one that counts its calls or assigns serial
+// numbers) must run once per object.
+template <class T, class Alloc, class... Args>
+using is_bitwise_replicable =
+    boolean_constant<is_bitwise_constructible<T, Alloc>::value &&
+                     is_trivially_constructible<T, const Args&...>::value>;
+
+// True if value-initializing a `T` using allocator `Alloc` is equivalent to
+// filling it with zero bytes.  Pointers to members are excluded because their
+// null value is not all-bits-zero on common ABIs.
+template <class T, class Alloc>
+using is_zero_constructible =
+    boolean_constant<! has_allocator<T, Alloc>::value &&
+                     is_scalar<T>::value && ! is_member_pointer<T>::value>;
+
+// Value-initialize `n` objects at `p` using allocator `a`.
+// This overload is used for types whose value-initialized representation is
+// all zeros.
+template <class T, class Alloc>
+inline T* value_construct_n(true_type /* zero constructible */,
+                            T* p, size_t n, const Alloc&)
+{
+    if (n)
+        std::memset(static_cast<void*>(p), 0, n * sizeof(T));
+    return p + n;
+}
+
+// Value-initialize `n` objects at `p` using allocator `a`.
+template <class T, class Alloc>
+inline T* value_construct_n(false_type /* zero constructible */,
+                            T* p, size_t n, const Alloc& a)
+{
+    return construct_n_from_args(is_bitwise_replicable<T, Alloc>(), p, n,
+                                 Cpp20::uses_allocator_construction_args<T>(
+                                     a));
+}
+
+// Tags naming the constructor that uses-allocator construction selects,
+// so that the selection can be made once for a whole range of objects: the
+// allocator is ignored, passed after `allocator_arg`, passed as a trailing
+// argument, or (for `pair` and `tuple`) passed to the members.
+struct ignore_allocator_tag { };
+struct prefix_allocator_tag { };
+struct suffix_allocator_tag { };
+struct member_allocator_tag { };
+
+// The tag for uses-allocator construction of a `T` with allocator `Alloc`
+// and ctor arguments `Args`.
+template <class T, class Alloc, class... Args>
+using uses_allocator_protocol =
+    conditional_t<! has_allocator<T, Alloc>::value, ignore_allocator_tag,
+    conditional_t<is_pair<T>::value || is_tuple<T>::value,
+                  member_allocator_tag,
+    conditional_t<is_constructible<T, allocator_arg_t, Alloc,
+                                   Args...>::value,
+                  prefix_allocator_tag, suffix_allocator_tag>>>;
+
+// Construct a `T` at `p` from `args` using allocator `a` and the
+// constructor named by the tag, without building an argument tuple.
+template <class T, class Alloc, class... Args>
+inline T* construct_with_protocol(ignore_allocator_tag, T* p, const Alloc&,
+                                  Args&&... args)
+{
+    return internal::construct_at(p, std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc, class... Args>
+inline T* construct_with_protocol(prefix_allocator_tag, T* p, const Alloc& a,
+                                  Args&&... args)
+{
+    return internal::construct_at(p, allocator_arg, a,
+                                  std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc, class... Args>
+inline T* construct_with_protocol(suffix_allocator_tag, T* p, const Alloc& a,
+                                  Args&&... args)
+{
+    return internal::construct_at(p, std::forward<Args>(args)..., a);
+}
+
+template <class T, class Alloc, class... Args>
+inline T* construct_with_protocol(member_allocator_tag, T* p, const Alloc& a,
+                                  Args&&... args)
+{
+    return Cpp20::uninitialized_construct_using_allocator(
+        p, a, std::forward<Args>(args)...);
+}
+
+// True if constructing `T` objects using allocator `Alloc` from the
+// elements of a range with iterator type `InputIt` can be done with
+// `memmove`: the iterator is a pointer to `T` and `T` is bitwise
+// constructible.
+template <class InputIt, class T, class Alloc>
+using is_bitwise_copyable_range =
+    boolean_constant<is_pointer<InputIt>::value &&
+                     is_same<remove_cv_t<remove_pointer_t<InputIt>>,
+                             T>::value &&
+                     is_bitwise_constructible<T, Alloc>::value>;
+
+// Construct objects from the elements of `[first, last)` in the
+// uninitialized storage starting at `result` using allocator `a`.
+// This overload copies the bytes with a single `memmove`.
+template <class T, class Alloc>
+inline T* construct_range(true_type /* bitwise copyable */,
+                          const T* first, const T* last, T* result,
+                          const Alloc&)
+{
+    const size_t n = size_t(last - first);
+    if (n)
+        std::memmove(static_cast<void*>(result),
+                     static_cast<const void*>(first), n * sizeof(T));
+    return result + n;
+}
+
+// Construct objects from the elements of `[first, last)` in the
+// uninitialized storage starting at `result` using allocator `a`.
+// This overload constructs each element with the protocol selected once
+// for the range.  If a constructor throws, the objects constructed so far
+// are destroyed before rethrowing.
+template <class InputIt, class T, class Alloc>
+inline T* construct_range(false_type /* bitwise copyable */,
+                          InputIt first, InputIt last, T* result,
+                          const Alloc& a)
+{
+    typedef uses_allocator_protocol<T, Alloc,
+                        typename iterator_traits<InputIt>::reference> protocol;
+    T* cur = result;
+    try {
+        for (; first != last; ++first, (void) ++cur)
+            construct_with_protocol(protocol(), cur, a, *first);
+    }
+    catch (...) {
+        destroy_range(result, cur);
+        throw;
+    }
+    return cur;
+}
+
+// Move-construct objects from the elements of `[first, last)`.  Moving a
+// bitwise-copyable object copies its bytes.
+template <class T, class Alloc>
+inline T* move_construct_range(true_type /* bitwise copyable */,
+                               const T* first, const T* last, T* result,
+                               const Alloc& a)
+{
+    return construct_range(true_type(), first, last, result, a);
+}
+
+template <class InputIt, class T, class Alloc>
+inline T* move_construct_range(false_type /* bitwise copyable */,
+                               InputIt first, InputIt last, T* result,
+                               const Alloc& a)
+{
+    return construct_range(false_type(), std::make_move_iterator(first),
+                           std::make_move_iterator(last), result, a);
+}
+
+// Construct copies of the `n` objects starting at `from` in the
+// uninitialized storage starting at `to`, for relocation.  This overload
+// copies the bytes; the originals must then be treated as destroyed
+// without running their destructors.
+template <class T, class Alloc>
+inline void relocate_construct_n(true_type /* trivially relocatable */,
+                                 T* from, size_t n, T* to,
+                                 const Alloc&) noexcept
+{
+    if (n)
+        std::memcpy(static_cast<void*>(to), static_cast<const void*>(from),
+                    n * sizeof(T));
+}
+
+// Construct copies of the `n` objects starting at `from` in the
+// uninitialized storage starting at `to`, for relocation, using
+// uses-allocator construction with allocator `a`.  Each object is moved if
+// the constructor selected for an rvalue and `a` is `noexcept` and copied
+// otherwise, so that if a constructor throws, the new objects are destroyed
+// and the originals are left intact.
+template <class T, class Alloc>
+inline void relocate_construct_n(false_type /* trivially relocatable */,
+                                 T* from, size_t n, T* to, const Alloc& a)
+{
+    size_t i = 0;
+    try {
+        for (; i < n; ++i)
+            Cpp20::uninitialized_construct_using_allocator(
+                to + i, a, move_if_noexcept_using_allocator<Alloc>(from[i]));
+    }
+    catch (...) {
+        destroy_range(to, to + i);
+        throw;
+    }
+}
+
+// Finish relocating the `n` objects starting at `from`.  Nothing needs to
+// be done for trivially relocatable objects.
+template <class T>
+inline void relocate_destroy_n(true_type, T*, size_t) noexcept { }
+
+template <class T>
+inline void relocate_destroy_n(false_type, T* from, size_t n) noexcept
+{
+    destroy_range(from, from + n);
+}
+
+} // close namespace internal
+
+// True if an object of type `T` can be moved to a new address by copying its
+// bytes, after which the original is treated as destroyed.  May be
+// specialized for types that are not trivially copyable but are trivially
+// relocatable.
+template <class T>
+struct is_trivially_relocatable : is_trivially_copyable<T> { };
+
+// Construct `n` objects of type `T` in the uninitialized storage starting at
+// `p`, each using uses-allocator construction with allocator `a` and
+// constructor arguments `args`.  The construction protocol and argument list
+// are computed once for the whole range.  Since the same arguments are used
+// for every element, they are always passed as lvalues (never moved from).
+// If a constructor throws, the objects already constructed are destroyed and
+// the exception is propagated.  Returns `p + n`.
+template <class T, class Alloc, class... Args>
+T* uninitialized_construct_n_using_allocator(T* p, size_t n,
+                                             const Alloc& a,
+                                             const Args&... args)
+{
+    using namespace internal;
+    return construct_n_from_args(is_bitwise_replicable<T, Alloc, Args...>(),
+                                 p, n,
+                      Cpp20::uses_allocator_construction_args<T>(a, args...));
+}
+
+// Value-initialize `n` objects of type `T` in the uninitialized storage
+// starting at `p` using uses-allocator construction with allocator `a`.
+// Types that do not use the allocator and whose value-initialized
+// representation is all zeros are initialized with a single `memset`.
+template <class T, class Alloc>
+T* uninitialized_construct_n_using_allocator(T* p, size_t n, const Alloc& a)
+{
+    using namespace internal;
+    return value_construct_n(is_zero_constructible<T, Alloc>(), p, n, a);
+}
+
+// Construct copies of `value` in the uninitialized range `[first, last)`
+// using uses-allocator construction with allocator `a`.  If a constructor
+// throws, the objects already constructed are destroyed and the exception is
+// propagated.
+template <class T, class Alloc>
+void uninitialized_fill_using_allocator(T* first, T* last, const Alloc& a,
+                                        const T& value)
+{
+    uninitialized_construct_n_using_allocator(first, size_t(last - first),
+                                              a, value);
+}
+
+// Construct copies of the elements of `[first, last)` in the uninitialized
+// storage starting at `result`, each using uses-allocator construction with
+// allocator `a`.  The constructor is selected once for the whole range
+// rather than per element, and if the elements are `T` objects that do not
+// use the allocator and are trivially copyable, their bytes are copied with
+// a single `memmove`.  If a constructor throws, the objects already
+// constructed are destroyed and the exception is propagated.  Returns the
+// end of the constructed range.
+template <class InputIt, class T, class Alloc>
+T* uninitialized_copy_using_allocator(InputIt first, InputIt last,
+                                      T* result, const Alloc& a)
+{
+    using namespace internal;
+    return construct_range(is_bitwise_copyable_range<InputIt, T, Alloc>(),
+                           first, last, result, a);
+}
+
+// Like `uninitialized_copy_using_allocator`, except that the objects are
+// constructed from rvalues of the elements of `[first, last)`.
+template <class InputIt, class T, class Alloc>
+T* uninitialized_move_using_allocator(InputIt first, InputIt last,
+                                      T* result, const Alloc& a)
+{
+    using namespace internal;
+    return move_construct_range(
+                           is_bitwise_copyable_range<InputIt, T, Alloc>(),
+                           first, last, result, a);
+}
+
+// Relocate the objects in the range `[first, last)`, whose storage is
+// managed by allocator `src_alloc`, to the uninitialized storage starting at
+// `result`, managed by `dst_alloc`, leaving `[first, last)` uninitialized.
+// If `T` is trivially relocatable and either does not use the allocator or
+// `src_alloc == dst_alloc`, the bytes are copied with a single `memcpy`.
+// Otherwise each object is constructed at `result` by uses-allocator
+// construction with `dst_alloc` (moved if that cannot throw, and copied
+// otherwise) and the originals are then destroyed; if a constructor throws,
+// the new objects are destroyed, the originals are left intact, and the
+// exception is propagated.  Returns the end of the relocated range.
+template <class T, class Alloc>
+T* uninitialized_relocate_using_allocator(T* first, T* last, T* result,
+                                          const Alloc& src_alloc,
+                                          const Alloc& dst_alloc)
+{
+    using namespace internal;
+    const size_t n = size_t(last - first);
+    if (is_trivially_relocatable<T>::value &&
+        (! has_allocator<T, Alloc>::value || src_alloc == dst_alloc)) {
+        relocate_construct_n(true_type(), first, n, result, dst_alloc);
+    }
+    else {
+        relocate_construct_n(false_type(), first, n, result, dst_alloc);
+        destroy_range(first, last);
+    }
+    return result + n;
+}
+
+namespace internal {
+
+// Destroy `[first, last)`, or do nothing if `T` is trivially destructible.
+template <class T>
+inline void destroy_range(true_type, T*, T*) noexcept { }
+
+template <class T>
+inline void destroy_range(false_type, T* first, T* last) noexcept
+{
+    destroy_range(first, last);
+}
+
+} // close namespace internal
+
+// Destroy the objects in the range `[first, last)`, which were constructed
+// by uses-allocator construction with allocator `a`, in reverse order.  As
+// with construction, the objects' destructors are invoked directly rather
+// than through `allocator_traits<Alloc>::destroy`.  If `T` is trivially
+// destructible, the range is not traversed at all.
+template <class T, class Alloc>
+inline void destroy_using_allocator(T* first, T* last, const Alloc&) noexcept
+{
+    internal::destroy_range(is_trivially_destructible<T>(), first, last);
+}
+
+// Destroy the `n` objects starting at `p` as by
+// `destroy_using_allocator(p, p + n, a)`.  Returns `p + n`.
+template <class T, class Alloc>
+inline T* destroy_n_using_allocator(T* p, size_t n, const Alloc& a) noexcept
+{
+    destroy_using_allocator(p, p + n, a);
+    return p + n;
+}
+
+// Destroy the `n` objects starting at the address held by the fancy
+// pointer `p`.  Returns `p + n`.
+template <class Ptr, class Alloc>
+inline enable_if_t<internal::is_fancy_pointer<Ptr>::value, Ptr>
+destroy_n_using_allocator(Ptr p, size_t n, const Alloc& a) noexcept
 {
-    return apply([p](auto&&... args2){
-            return ::new(static_cast<void*>(p))
-                T(forward<decltype(args2)>(args2)...);
-        }, uses_allocator_construction_args<T>(a, forward<Args>(args)...));
+    Cpp20::destroy_n_using_allocator(internal::to_raw_pointer(p), n, a);
+    return p + n;
 }
 
 } // close namespace Cpp20
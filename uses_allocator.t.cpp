@@ -6,70 +6,13 @@
 
 #include "uses_allocator.h"
 
+#include <memory_resource.h>
 #include <vector>
 #include <cstdlib>
 #include <test_assert.h>
 
-namespace std {
-
-inline namespace Cpp17 {
-
-enum class byte : unsigned char { };
-
-namespace pmr {
-
-struct memory_resource
-{
-    bool is_equal(const memory_resource& other) const noexcept
-        { return do_is_equal(other); }
-protected:
-    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
-};
-
-bool operator==(const memory_resource& a, const memory_resource& b)
-{
-    return a.is_equal(b);
-}
-
-bool operator!=(const memory_resource& a, const memory_resource& b)
-{
-    return ! (a == b);
-}
-
-} // close namespace pmr
-} // close namespace Cpp17
-
-inline namespace Cpp20 {
-namespace pmr {
-using namespace Cpp17::pmr;
-
-template <class T = std::byte>
-class polymorphic_allocator {
-    memory_resource *p_rsrc;
-public:
-    polymorphic_allocator(memory_resource *r) : p_rsrc(r) { }
-
-    memory_resource *resource() const { return p_rsrc; }
-};
-
-template <class T1, class T2>
-bool operator==(const polymorphic_allocator<T1>& a1,
-                const polymorphic_allocator<T2>& a2) {
-    return *a1.resource() == *a2.resource();
-}
-
-template <class T1, class T2>
-bool operator!=(const polymorphic_allocator<T1>& a1,
-                const polymorphic_allocator<T2>& a2) {
-    return ! (a1 == a2);
-}
-
-} // close namespace pmr
-} // close namespace Cpp20
-} // close namespace std
-
 namespace exp = std::Cpp20;
-namespace pmr = exp::pmr;
+namespace pmr = std::experimental::pmr;
 namespace internal = exp::internal;
 
 // STL-style test allocator (doesn't meet the Allocator requirements, but
@@ -99,8 +42,8 @@ inline bool operator!=(const MySTLAlloc<T>& a, const MySTLAlloc<T>& b)
     return a.id() != b.id();
 }
 
-// Memory resource (doesn't meet requirements in LFTS2, but that's not
-// important for this test).
+// Memory resource that forwards to `new_delete_resource` but has an
+// identity for testing allocator propagation.
 class MyMemResource : public pmr::memory_resource
 {
     int m_id;
@@ -110,6 +53,11 @@ public:
     int id() const { return m_id; }
 
 protected:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment)
+        { return pmr::new_delete_resource()->allocate(bytes, alignment); }
+    virtual void do_deallocate(void* p, std::size_t bytes,
+                               std::size_t alignment)
+        { pmr::new_delete_resource()->deallocate(p, bytes, alignment); }
     virtual bool do_is_equal(const pmr::memory_resource& other) const noexcept;
 };
 
@@ -563,6 +511,710 @@ void runTest()
         TEST_ASSERT((!usesMemRsrc && usesAlloc) == pY->match_allocator(A0));
         pY->~Obj();
     }
+
+    // Test range construction with allocator and value.
+    {
+        const std::size_t N = 5;
+        char rangeBuffer alignas(Obj) [N * sizeof(Obj)];
+        Obj *pRange = reinterpret_cast<Obj*>(rangeBuffer);
+
+        Obj *pEnd = exp::uninitialized_construct_n_using_allocator(pRange, N,
+                                                                   A1, 7);
+        TEST_ASSERT(pRange + N == pEnd);
+        for (Obj *p = pRange; p != pEnd; ++p) {
+            TEST_ASSERT(7 == p->value());
+            TEST_ASSERT(usesAlloc == p->match_allocator(A1));
+            TEST_ASSERT((!usesAlloc && usesMemRsrc) == p->match_resource(pR0));
+        }
+        internal::destroy_range(pRange, pEnd);
+
+        pEnd = exp::uninitialized_construct_n_using_allocator(pRange, N, pR1);
+        TEST_ASSERT(pRange + N == pEnd);
+        for (Obj *p = pRange; p != pEnd; ++p) {
+            TEST_ASSERT(0 == p->value());
+            TEST_ASSERT(usesMemRsrc == p->match_resource(pR1));
+            TEST_ASSERT((!usesMemRsrc && usesAlloc) == p->match_allocator(A0));
+        }
+        internal::destroy_range(pRange, pEnd);
+
+        const Obj value(9);
+        exp::uninitialized_fill_using_allocator(pRange, pRange + N, A1, value);
+        for (Obj *p = pRange; p != pRange + N; ++p) {
+            TEST_ASSERT(9 == p->value());
+            TEST_ASSERT(usesAlloc == p->match_allocator(A1));
+            TEST_ASSERT((!usesAlloc && usesMemRsrc) == p->match_resource(pR0));
+        }
+        internal::destroy_range(pRange, pRange + N);
+    }
+}
+
+// Type whose constructor throws after a configurable number of successful
+// constructions.  Keeps track of the number of live objects.
+class ThrowingType
+{
+    int m_value;
+
+public:
+    static int s_liveCount;
+    static int s_constructionsBeforeThrow;
+
+    explicit ThrowingType(int v = 0) : m_value(v) {
+        if (0 == s_constructionsBeforeThrow--)
+            throw s_liveCount;
+        ++s_liveCount;
+    }
+
+    ThrowingType(const ThrowingType& other) : ThrowingType(other.m_value) { }
+
+    ~ThrowingType() { --s_liveCount; }
+
+    int value() const { return m_value; }
+};
+
+int ThrowingType::s_liveCount = 0;
+int ThrowingType::s_constructionsBeforeThrow = -1;
+
+// Trivially copyable type whose constructors number the objects they
+// create.
+struct Serial
+{
+    static int s_count;
+
+    int m_id;
+
+    Serial() : m_id(++s_count) { }
+    explicit Serial(int) : m_id(++s_count) { }
+};
+
+int Serial::s_count = 0;
+
+void runRangeTest()
+{
+    typedef MySTLAlloc<int> IntAlloc;
+    IntAlloc A1(1);
+
+    // Value-initialization of scalars
+    {
+        int buffer[7];
+        for (int& v : buffer) v = -1;
+        int *pEnd = exp::uninitialized_construct_n_using_allocator(buffer, 6,
+                                                                   A1);
+        TEST_ASSERT(buffer + 6 == pEnd);
+        for (int i = 0; i < 6; ++i)
+            TEST_ASSERT(0 == buffer[i]);
+        TEST_ASSERT(-1 == buffer[6]);  // No overrun
+    }
+
+    // Value-initialization of pointers to members
+    {
+        typedef int TestTypeBase<NoAlloc>::*MemPtr;
+        MemPtr buffer[3];
+        exp::uninitialized_construct_n_using_allocator(buffer, 3, A1);
+        for (MemPtr mp : buffer)
+            TEST_ASSERT(nullptr == mp);
+    }
+
+    // Bitwise-copyable types, including sizes not a power of two
+    for (std::size_t n = 0; n < 20; ++n) {
+        struct Trivial { short a; char b; };
+        Trivial buffer[21];
+        buffer[n].a = -1;
+        const Trivial value = { 5, 'x' };
+        exp::uninitialized_fill_using_allocator(buffer, buffer + n, A1, value);
+        for (std::size_t i = 0; i < n; ++i)
+            TEST_ASSERT(5 == buffer[i].a && 'x' == buffer[i].b);
+        TEST_ASSERT(-1 == buffer[n].a);  // No overrun
+
+        char chars[21];
+        chars[n] = 'z';
+        exp::uninitialized_construct_n_using_allocator(chars, n, A1, 'q');
+        for (std::size_t i = 0; i < n; ++i)
+            TEST_ASSERT('q' == chars[i]);
+        TEST_ASSERT('z' == chars[n]);  // No overrun
+    }
+
+    // A user-provided constructor of a trivially copyable type runs once
+    // per element
+    {
+        Serial buffer[5];
+        Serial::s_count = 0;
+        exp::uninitialized_construct_n_using_allocator(buffer, 5, A1, 7);
+        TEST_ASSERT(5 == Serial::s_count);
+        for (int i = 0; i < 5; ++i)
+            TEST_ASSERT(i + 1 == buffer[i].m_id);
+
+        Serial::s_count = 0;
+        exp::uninitialized_construct_n_using_allocator(buffer, 5, A1);
+        TEST_ASSERT(5 == Serial::s_count);
+        for (int i = 0; i < 5; ++i)
+            TEST_ASSERT(i + 1 == buffer[i].m_id);
+
+        // Copies are still made bitwise
+        const Serial value(0);
+        exp::uninitialized_fill_using_allocator(buffer, buffer + 5, A1,
+                                                value);
+        TEST_ASSERT(6 == Serial::s_count);
+        for (int i = 0; i < 5; ++i)
+            TEST_ASSERT(6 == buffer[i].m_id);
+    }
+
+    // Pairs get the allocator piecewise
+    {
+        typedef TestType<IntAlloc, true> Elem;
+        typedef std::pair<Elem, int>     Obj;
+        char buffer alignas(Obj) [4 * sizeof(Obj)];
+        Obj *pRange = reinterpret_cast<Obj*>(buffer);
+        const Obj value(Elem(3), 4);
+
+        exp::uninitialized_fill_using_allocator(pRange, pRange + 4, A1, value);
+        for (Obj *p = pRange; p != pRange + 4; ++p) {
+            TEST_ASSERT(3 == p->first.value());
+            TEST_ASSERT(4 == p->second);
+            TEST_ASSERT(p->first.match_allocator(A1));
+        }
+        internal::destroy_range(pRange, pRange + 4);
+    }
+
+    // Exception in the middle of the range rolls back
+    {
+        typedef ThrowingType Obj;
+        char buffer alignas(Obj) [6 * sizeof(Obj)];
+        Obj *pRange = reinterpret_cast<Obj*>(buffer);
+
+        Obj::s_constructionsBeforeThrow = 3;
+        bool caught = false;
+        try {
+            exp::uninitialized_construct_n_using_allocator(pRange, 6, A1, 2);
+        }
+        catch (int liveCount) {
+            caught = true;
+            TEST_ASSERT(3 == liveCount);
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(0 == Obj::s_liveCount);
+
+        Obj::s_constructionsBeforeThrow = -1;
+        const Obj value(8);
+        Obj::s_constructionsBeforeThrow = 4;
+        caught = false;
+        try {
+            exp::uninitialized_fill_using_allocator(pRange, pRange + 6, A1,
+                                                    value);
+        }
+        catch (int liveCount) {
+            caught = true;
+            TEST_ASSERT(5 == liveCount);  // Includes `value`
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(1 == Obj::s_liveCount);
+        Obj::s_constructionsBeforeThrow = -1;
+    }
+}
+
+// Allocator-aware type that is declared trivially relocatable (below).
+// Counts its constructions and live objects.
+class RelocType
+{
+    MySTLAlloc<int> m_alloc;
+    int             m_value;
+
+public:
+    typedef MySTLAlloc<int> allocator_type;
+
+    static int s_constructions;
+    static int s_liveCount;
+
+    RelocType(int v, const allocator_type& a) : m_alloc(a), m_value(v)
+        { ++s_constructions; ++s_liveCount; }
+    RelocType(const RelocType& other, const allocator_type& a)
+        : RelocType(other.m_value, a) { }
+    RelocType(RelocType&& other, const allocator_type& a) noexcept
+        : RelocType(other.m_value, a) { }
+    ~RelocType() { --s_liveCount; }
+
+    int value() const { return m_value; }
+    int allocId() const { return m_alloc.id(); }
+};
+
+int RelocType::s_constructions = 0;
+int RelocType::s_liveCount = 0;
+
+namespace std {
+inline namespace Cpp20 {
+template <> struct is_trivially_relocatable<RelocType> : true_type { };
+}
+}
+
+void runRelocateTest()
+{
+    typedef MySTLAlloc<int> IntAlloc;
+    IntAlloc A1(1), A2(2);
+
+    // Trivially copyable types are copied bytewise
+    {
+        int from[5] = { 1, 2, 3, 4, 5 }, to[6];
+        to[5] = -1;
+        TEST_ASSERT(to + 5 == exp::uninitialized_relocate_using_allocator(
+                                  from, from + 5, to, A1, A2));
+        for (int i = 0; i < 5; ++i)
+            TEST_ASSERT(i + 1 == to[i]);
+        TEST_ASSERT(-1 == to[5]);  // No overrun
+    }
+
+    typedef RelocType Obj;
+    char fromBuf alignas(Obj) [4 * sizeof(Obj)];
+    char toBuf alignas(Obj) [4 * sizeof(Obj)];
+    Obj *from = reinterpret_cast<Obj*>(fromBuf);
+    Obj *to = reinterpret_cast<Obj*>(toBuf);
+
+    // Trivially relocatable objects are copied bytewise if the allocators
+    // are equal...
+    {
+        exp::uninitialized_construct_n_using_allocator(from, 4, A1, 7);
+        Obj::s_constructions = 0;
+        TEST_ASSERT(to + 4 == exp::uninitialized_relocate_using_allocator(
+                                  from, from + 4, to, A1, IntAlloc(1)));
+        TEST_ASSERT(0 == Obj::s_constructions);
+        TEST_ASSERT(4 == Obj::s_liveCount);
+        for (int i = 0; i < 4; ++i) {
+            TEST_ASSERT(7 == to[i].value());
+            TEST_ASSERT(1 == to[i].allocId());
+        }
+    }
+
+    // ...and otherwise rebuilt with the destination allocator.
+    {
+        TEST_ASSERT(from + 4 == exp::uninitialized_relocate_using_allocator(
+                                    to, to + 4, from, A1, A2));
+        TEST_ASSERT(4 == Obj::s_constructions);
+        TEST_ASSERT(4 == Obj::s_liveCount);
+        for (int i = 0; i < 4; ++i) {
+            TEST_ASSERT(7 == from[i].value());
+            TEST_ASSERT(2 == from[i].allocId());
+        }
+        internal::destroy_range(from, from + 4);
+        TEST_ASSERT(0 == Obj::s_liveCount);
+    }
+
+    // Other types are copied (as their moves may throw) and destroyed; an
+    // exception leaves the originals intact.
+    {
+        typedef ThrowingType Obj2;
+        char fromBuf2 alignas(Obj2) [4 * sizeof(Obj2)];
+        char toBuf2 alignas(Obj2) [4 * sizeof(Obj2)];
+        Obj2 *from2 = reinterpret_cast<Obj2*>(fromBuf2);
+        Obj2 *to2 = reinterpret_cast<Obj2*>(toBuf2);
+
+        exp::uninitialized_construct_n_using_allocator(from2, 4, A1, 3);
+        Obj2::s_constructionsBeforeThrow = 2;
+        bool caught = false;
+        try {
+            exp::uninitialized_relocate_using_allocator(from2, from2 + 4, to2,
+                                                        A1, A1);
+        }
+        catch (int) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(4 == Obj2::s_liveCount);
+        Obj2::s_constructionsBeforeThrow = -1;
+
+        exp::uninitialized_relocate_using_allocator(from2, from2 + 4, to2,
+                                                    A1, A1);
+        TEST_ASSERT(4 == Obj2::s_liveCount);
+        for (int i = 0; i < 4; ++i)
+            TEST_ASSERT(3 == to2[i].value());
+        internal::destroy_range(to2, to2 + 4);
+        TEST_ASSERT(0 == Obj2::s_liveCount);
+    }
+}
+
+void runDestroyTest()
+{
+    typedef MySTLAlloc<int> IntAlloc;
+    IntAlloc A1(1);
+
+    // Trivially destructible objects are left alone
+    {
+        int values[4] = { 1, 2, 3, 4 };
+        exp::destroy_using_allocator(values, values + 4, A1);
+        TEST_ASSERT(values + 4 == exp::destroy_n_using_allocator(values, 4,
+                                                                 A1));
+    }
+
+    typedef RelocType Obj;
+    char buf alignas(Obj) [4 * sizeof(Obj)];
+    Obj *p = reinterpret_cast<Obj*>(buf);
+
+    exp::uninitialized_construct_n_using_allocator(p, 4, A1, 7);
+    TEST_ASSERT(4 == Obj::s_liveCount);
+    exp::destroy_using_allocator(p + 2, p + 4, A1);
+    TEST_ASSERT(2 == Obj::s_liveCount);
+    TEST_ASSERT(p + 2 == exp::destroy_n_using_allocator(p, 2, A1));
+    TEST_ASSERT(0 == Obj::s_liveCount);
+}
+
+// Counts copies and moves, with and without an allocator argument.
+class CountedType
+{
+    MySTLAlloc<int> m_alloc;
+    int             m_value;
+
+public:
+    typedef MySTLAlloc<int> allocator_type;
+
+    static int s_copies;
+    static int s_moves;
+
+    explicit CountedType(int v, const allocator_type& a = allocator_type())
+        : m_alloc(a), m_value(v) { }
+    explicit CountedType(const allocator_type& a)
+        : m_alloc(a), m_value(0) { }
+    CountedType(const CountedType& other,
+                const allocator_type& a = allocator_type())
+        : m_alloc(a), m_value(other.m_value) { ++s_copies; }
+    CountedType(CountedType&& other,
+                const allocator_type& a = allocator_type())
+        : m_alloc(a), m_value(other.m_value) { ++s_moves; }
+
+    int value() const { return m_value; }
+    int allocId() const { return m_alloc.id(); }
+
+    static void reset() { s_copies = s_moves = 0; }
+};
+
+int CountedType::s_copies = 0;
+int CountedType::s_moves = 0;
+
+// Allocator-aware type that can be neither copied nor moved.
+class NonMovable
+{
+    MySTLAlloc<int> m_alloc;
+    int             m_value;
+
+public:
+    typedef MySTLAlloc<int> allocator_type;
+
+    NonMovable() : m_alloc(), m_value(0) { }
+    explicit NonMovable(int v) : m_alloc(), m_value(v) { }
+    NonMovable(std::allocator_arg_t, const allocator_type& a, int v = 0)
+        : m_alloc(a), m_value(v) { }
+    NonMovable(const NonMovable&) = delete;
+
+    int value() const { return m_value; }
+    int allocId() const { return m_alloc.id(); }
+};
+
+void runNestedPairTest()
+{
+    typedef MySTLAlloc<int>                     IntAlloc;
+    typedef CountedType                         Obj;
+    typedef std::pair<std::pair<Obj, Obj>, Obj> Nested;
+    using std::piecewise_construct;
+    using std::forward_as_tuple;
+
+    IntAlloc A1(1);
+    const Obj a(1), b(2), c(3);
+    char buf alignas(Nested) [sizeof(Nested)];
+    Nested *p = reinterpret_cast<Nested*>(buf);
+
+    // Copies from lvalues: one per member, as for hand-written piecewise
+    // construction, and no moves.
+    {
+        Obj::reset();
+        Nested expected(piecewise_construct,
+                        forward_as_tuple(piecewise_construct,
+                                         forward_as_tuple(a, A1),
+                                         forward_as_tuple(b, A1)),
+                        forward_as_tuple(c, A1));
+        TEST_ASSERT(3 == Obj::s_copies);
+        TEST_ASSERT(0 == Obj::s_moves);
+
+        Obj::reset();
+        Nested n = exp::make_obj_using_allocator<Nested>(A1,
+                        piecewise_construct,
+                        forward_as_tuple(piecewise_construct,
+                                         forward_as_tuple(a),
+                                         forward_as_tuple(b)),
+                        forward_as_tuple(c));
+        TEST_ASSERT(3 == Obj::s_copies);
+        TEST_ASSERT(0 == Obj::s_moves);
+        TEST_ASSERT(2 == n.first.second.value());
+        TEST_ASSERT(1 == n.first.first.allocId());
+        TEST_ASSERT(1 == n.first.second.allocId());
+        TEST_ASSERT(1 == n.second.allocId());
+
+        Obj::reset();
+        exp::uninitialized_construct_using_allocator(p, A1, n.first, c);
+        TEST_ASSERT(3 == Obj::s_copies);
+        TEST_ASSERT(0 == Obj::s_moves);
+        TEST_ASSERT(1 == p->first.first.value());
+        TEST_ASSERT(1 == p->first.first.allocId());
+        TEST_ASSERT(3 == p->second.value());
+        p->~Nested();
+    }
+
+    // Moves from rvalues: one per member, and no copies.
+    {
+        std::pair<Obj, Obj> ab(a, b);
+        Obj c2(c);
+
+        Obj::reset();
+        Nested expected(piecewise_construct,
+                        forward_as_tuple(piecewise_construct,
+                                         forward_as_tuple(
+                                             std::move(ab.first), A1),
+                                         forward_as_tuple(
+                                             std::move(ab.second), A1)),
+                        forward_as_tuple(std::move(c2), A1));
+        TEST_ASSERT(0 == Obj::s_copies);
+        TEST_ASSERT(3 == Obj::s_moves);
+
+        Obj::reset();
+        Nested n = exp::make_obj_using_allocator<Nested>(A1, std::move(ab),
+                                                         std::move(c2));
+        TEST_ASSERT(0 == Obj::s_copies);
+        TEST_ASSERT(3 == Obj::s_moves);
+        TEST_ASSERT(1 == n.first.second.allocId());
+
+        Obj::reset();
+        exp::uninitialized_construct_using_allocator(p, A1, std::move(n));
+        TEST_ASSERT(0 == Obj::s_copies);
+        TEST_ASSERT(3 == Obj::s_moves);
+        TEST_ASSERT(2 == p->first.second.value());
+        TEST_ASSERT(1 == p->first.second.allocId());
+        p->~Nested();
+    }
+
+    // Deeper nesting, constructed from the allocator alone
+    {
+        typedef std::pair<std::pair<Nested, Obj>, Nested> Deep;
+
+        Obj::reset();
+        Deep d = exp::make_obj_using_allocator<Deep>(A1);
+        TEST_ASSERT(0 == Obj::s_copies);
+        TEST_ASSERT(0 == Obj::s_moves);
+        TEST_ASSERT(1 == d.first.first.first.first.allocId());
+        TEST_ASSERT(1 == d.first.second.allocId());
+        TEST_ASSERT(1 == d.second.first.second.allocId());
+    }
+
+    // A member that can be neither copied nor moved, in a nested pair, is
+    // constructed in place.
+    {
+        typedef std::pair<std::pair<int, NonMovable>, Obj> Pinned;
+        char pbuf alignas(Pinned) [sizeof(Pinned)];
+        Pinned *pp = reinterpret_cast<Pinned*>(pbuf);
+
+        exp::uninitialized_construct_using_allocator(pp, A1,
+                        piecewise_construct,
+                        forward_as_tuple(piecewise_construct,
+                                         forward_as_tuple(4),
+                                         forward_as_tuple(5)),
+                        forward_as_tuple(c));
+        TEST_ASSERT(4 == pp->first.first);
+        TEST_ASSERT(5 == pp->first.second.value());
+        TEST_ASSERT(1 == pp->first.second.allocId());
+        TEST_ASSERT(1 == pp->second.allocId());
+        pp->~Pinned();
+    }
+}
+
+void runCopyMoveTest()
+{
+    typedef MySTLAlloc<int> IntAlloc;
+    IntAlloc A1(1), A2(2);
+
+    // Trivially copyable types are copied bytewise
+    {
+        const int from[5] = { 1, 2, 3, 4, 5 };
+        int to[6];
+        to[5] = -1;
+        TEST_ASSERT(to + 5 == exp::uninitialized_copy_using_allocator(
+                                  from, from + 5, to, A1));
+        for (int i = 0; i < 5; ++i)
+            TEST_ASSERT(i + 1 == to[i]);
+        TEST_ASSERT(-1 == to[5]);  // No overrun
+    }
+
+    // The allocator is passed with the protocol each type expects
+    {
+        typedef TestType<IntAlloc, true>  PrefixObj;
+        typedef TestType<IntAlloc, false> SuffixObj;
+        typedef std::pair<PrefixObj, int> PairObj;
+        const PrefixObj prefixFrom[3] = { 1, 2, 3 };
+        const SuffixObj suffixFrom[3] = { 1, 2, 3 };
+        const PairObj   pairFrom[3] = { { 1, 1 }, { 2, 2 }, { 3, 3 } };
+        const int       intFrom[3] = { 1, 2, 3 };
+        char prefixBuf alignas(PrefixObj) [3 * sizeof(PrefixObj)];
+        char suffixBuf alignas(SuffixObj) [3 * sizeof(SuffixObj)];
+        char pairBuf alignas(PairObj) [3 * sizeof(PairObj)];
+        PrefixObj *prefixTo = reinterpret_cast<PrefixObj*>(prefixBuf);
+        SuffixObj *suffixTo = reinterpret_cast<SuffixObj*>(suffixBuf);
+        PairObj   *pairTo = reinterpret_cast<PairObj*>(pairBuf);
+
+        exp::uninitialized_copy_using_allocator(prefixFrom, prefixFrom + 3,
+                                                prefixTo, A2);
+        exp::uninitialized_copy_using_allocator(suffixFrom, suffixFrom + 3,
+                                                suffixTo, A2);
+        exp::uninitialized_copy_using_allocator(pairFrom, pairFrom + 3,
+                                                pairTo, A2);
+        for (int i = 0; i < 3; ++i) {
+            TEST_ASSERT(i + 1 == prefixTo[i].value());
+            TEST_ASSERT(prefixTo[i].match_allocator(A2));
+            TEST_ASSERT(i + 1 == suffixTo[i].value());
+            TEST_ASSERT(suffixTo[i].match_allocator(A2));
+            TEST_ASSERT(i + 1 == pairTo[i].first.value());
+            TEST_ASSERT(pairTo[i].first.match_allocator(A2));
+        }
+        internal::destroy_range(prefixTo, prefixTo + 3);
+
+        // Elements of a different type are converted
+        exp::uninitialized_copy_using_allocator(intFrom, intFrom + 3,
+                                                prefixTo, A1);
+        for (int i = 0; i < 3; ++i) {
+            TEST_ASSERT(i + 1 == prefixTo[i].value());
+            TEST_ASSERT(prefixTo[i].match_allocator(A1));
+        }
+        internal::destroy_range(prefixTo, prefixTo + 3);
+        internal::destroy_range(suffixTo, suffixTo + 3);
+        internal::destroy_range(pairTo, pairTo + 3);
+    }
+
+    // Moving uses the allocator-extended move constructor
+    {
+        typedef RelocType Obj;
+        char fromBuf alignas(Obj) [3 * sizeof(Obj)];
+        char toBuf alignas(Obj) [3 * sizeof(Obj)];
+        Obj *from = reinterpret_cast<Obj*>(fromBuf);
+        Obj *to = reinterpret_cast<Obj*>(toBuf);
+
+        exp::uninitialized_construct_n_using_allocator(from, 3, A1, 5);
+        TEST_ASSERT(to + 3 == exp::uninitialized_move_using_allocator(
+                                  from, from + 3, to, A2));
+        TEST_ASSERT(6 == Obj::s_liveCount);
+        for (int i = 0; i < 3; ++i) {
+            TEST_ASSERT(5 == to[i].value());
+            TEST_ASSERT(2 == to[i].allocId());
+        }
+        internal::destroy_range(from, from + 3);
+        internal::destroy_range(to, to + 3);
+        TEST_ASSERT(0 == Obj::s_liveCount);
+    }
+
+    // Exception in the middle of the range rolls back
+    {
+        typedef ThrowingType Obj;
+        const Obj from[4] = { Obj(1), Obj(2), Obj(3), Obj(4) };
+        char buffer alignas(Obj) [4 * sizeof(Obj)];
+        Obj *to = reinterpret_cast<Obj*>(buffer);
+
+        Obj::s_constructionsBeforeThrow = 2;
+        bool caught = false;
+        try {
+            exp::uninitialized_copy_using_allocator(from, from + 4, to, A1);
+        }
+        catch (int) {
+            caught = true;
+        }
+        TEST_ASSERT(caught);
+        TEST_ASSERT(4 == Obj::s_liveCount);
+        Obj::s_constructionsBeforeThrow = -1;
+    }
+}
+
+// Type whose allocator-extended constructors are `noexcept` if `Nothrow` is
+// true, taking the allocator after `allocator_arg` if `Prefix` is true and
+// as a trailing argument otherwise.  The constructors that do not take an
+// allocator have the opposite exception specification, so that the tests
+// detect if the wrong constructor is checked.
+template <bool Nothrow, bool Prefix>
+struct NoexceptType
+{
+    typedef MySTLAlloc<int> allocator_type;
+
+    NoexceptType() noexcept(! Nothrow) { }
+    NoexceptType(int) noexcept(! Nothrow) { }
+    NoexceptType(const allocator_type&) noexcept(Nothrow) { }
+    NoexceptType(int, const allocator_type&) noexcept(Nothrow) { }
+};
+
+template <bool Nothrow>
+struct NoexceptType<Nothrow, true>
+{
+    typedef MySTLAlloc<int> allocator_type;
+
+    NoexceptType() noexcept(! Nothrow) { }
+    NoexceptType(int) noexcept(! Nothrow) { }
+    NoexceptType(std::allocator_arg_t, const allocator_type&)
+        noexcept(Nothrow) { }
+    NoexceptType(std::allocator_arg_t, const allocator_type&, int)
+        noexcept(Nothrow) { }
+};
+
+// Return true if `make_obj_using_allocator<T>(a, args...)` and
+// `uninitialized_construct_using_allocator(p, a, args...)` are `noexcept`,
+// after checking that they agree.
+template <class T, class Alloc, class... Args>
+bool isNothrowUsesAllocator(const Alloc& a, Args&&... args)
+{
+    const bool make = noexcept(exp::make_obj_using_allocator<T>(a,
+                                                 std::forward<Args>(args)...));
+    const bool construct = noexcept(
+        exp::uninitialized_construct_using_allocator(static_cast<T*>(nullptr),
+                                           a, std::forward<Args>(args)...));
+    TEST_ASSERT(make == construct);
+    return make;
+}
+
+void runNoexceptTest()
+{
+    typedef MySTLAlloc<int>            IntAlloc;
+    typedef NoexceptType<true, false>  NothrowSuffix;
+    typedef NoexceptType<true, true>   NothrowPrefix;
+    typedef NoexceptType<false, false> ThrowSuffix;
+    typedef NoexceptType<false, true>  ThrowPrefix;
+    IntAlloc A1(1);
+    int      i = 2;
+
+    // Building the argument tuple never throws
+    TEST_ASSERT((noexcept(exp::uses_allocator_construction_args<ThrowPrefix>(
+                             A1, 1))));
+    TEST_ASSERT((noexcept(exp::uses_allocator_construction_args<
+                             std::pair<ThrowSuffix, ThrowPrefix>>(A1))));
+
+    // The constructor selected by the allocator protocol is checked
+    TEST_ASSERT((  isNothrowUsesAllocator<NothrowSuffix>(A1)));
+    TEST_ASSERT((  isNothrowUsesAllocator<NothrowSuffix>(A1, 1)));
+    TEST_ASSERT((  isNothrowUsesAllocator<NothrowPrefix>(A1, i)));
+    TEST_ASSERT((! isNothrowUsesAllocator<ThrowSuffix>(A1, 1)));
+    TEST_ASSERT((! isNothrowUsesAllocator<ThrowPrefix>(A1)));
+    TEST_ASSERT((  isNothrowUsesAllocator<int>(A1, 1)));
+    TEST_ASSERT((! isNothrowUsesAllocator<ThrowingType>(A1, 1)));
+
+    // Pairs are checked member by member, however they are constructed
+    typedef std::pair<NothrowSuffix, NothrowPrefix> NothrowPair;
+    typedef std::pair<NothrowSuffix, ThrowPrefix>   ThrowPair;
+    TEST_ASSERT((  isNothrowUsesAllocator<NothrowPair>(A1)));
+    TEST_ASSERT((  isNothrowUsesAllocator<NothrowPair>(A1, 1, i)));
+    TEST_ASSERT((  isNothrowUsesAllocator<NothrowPair>(A1,
+                                           std::piecewise_construct,
+                                           std::make_tuple(1),
+                                           std::forward_as_tuple(i))));
+    TEST_ASSERT((! isNothrowUsesAllocator<ThrowPair>(A1)));
+    TEST_ASSERT((! isNothrowUsesAllocator<ThrowPair>(A1, 1, i)));
+    TEST_ASSERT((  isNothrowUsesAllocator<
+                      std::pair<NothrowPair, NothrowSuffix>>(A1)));
+    TEST_ASSERT((! isNothrowUsesAllocator<
+                      std::pair<ThrowPair, NothrowSuffix>>(A1)));
+
+    // Tuples are checked element by element
+    TEST_ASSERT((  isNothrowUsesAllocator<
+                      std::tuple<NothrowSuffix, int, NothrowPrefix>>(A1)));
+    TEST_ASSERT((  isNothrowUsesAllocator<
+                      std::tuple<NothrowSuffix, NothrowPrefix>>(A1, 1, i)));
+    TEST_ASSERT((! isNothrowUsesAllocator<
+                      std::tuple<NothrowSuffix, ThrowPrefix>>(A1, 1, i)));
 }
 
 template <class Alloc1, bool Prefix1, bool usesAlloc1, bool usesMemRsrc1,
@@ -1147,6 +1799,302 @@ void runPairTest()
 }
 
 
+// The type returned by `uses_allocator_construction_args<T>` for an
+// allocator of type `Alloc` and arguments of types `Args`.
+template <class T, class Alloc, class... Args>
+using ArgsTuple = decltype(exp::uses_allocator_construction_args<T>(
+                               std::declval<const Alloc&>(),
+                               std::declval<Args>()...));
+
+// The `if constexpr` implementation (C++17 and later) and the tag-dispatched
+// overloads (C++14, or `USES_ALLOCATOR_TAG_DISPATCH`) must return exactly
+// the same types.  The Makefile builds this driver in both modes.
+namespace args_types {
+
+using std::allocator_arg_t;
+using std::is_same;
+using std::pair;
+using std::piecewise_construct_t;
+using std::tuple;
+
+typedef MySTLAlloc<int>             A;
+typedef TestType<NoAlloc>           NoA;
+typedef TestType<A, false>          SufA;
+typedef TestType<A, true>           PreA;
+typedef tuple<allocator_arg_t, const A&> PreArgs;
+
+// Non-pair types
+static_assert(is_same<ArgsTuple<NoA, A, int&>, tuple<int&>>::value, "");
+static_assert(is_same<ArgsTuple<SufA, A, const int&>,
+                      tuple<const int&, const A&>>::value, "");
+static_assert(is_same<ArgsTuple<PreA, A, int>,
+                      tuple<allocator_arg_t, const A&, int&&>>::value, "");
+
+// Pairs, in each form of pair construction
+typedef pair<SufA, PreA> P;
+static_assert(is_same<ArgsTuple<pair<NoA, int>, A>, tuple<>>::value, "");
+static_assert(is_same<ArgsTuple<P, A>,
+                      tuple<piecewise_construct_t, tuple<const A&>,
+                            PreArgs>>::value, "");
+static_assert(is_same<ArgsTuple<P, A, int, int&>,
+                      tuple<piecewise_construct_t, tuple<int&&, const A&>,
+                            tuple<allocator_arg_t, const A&, int&>>>::value,
+              "");
+static_assert(is_same<ArgsTuple<P, A, pair<int, long>&>,
+                      tuple<piecewise_construct_t,
+                            tuple<const int&, const A&>,
+                            tuple<allocator_arg_t, const A&,
+                                  const long&>>>::value, "");
+static_assert(is_same<ArgsTuple<P, A, pair<int, long>>,
+                      tuple<piecewise_construct_t, tuple<int&&, const A&>,
+                            tuple<allocator_arg_t, const A&,
+                                  long&&>>>::value, "");
+static_assert(is_same<ArgsTuple<P, A, const piecewise_construct_t&,
+                                tuple<int>, tuple<>>,
+                      tuple<piecewise_construct_t, tuple<int&&, const A&>,
+                            PreArgs>>::value, "");
+
+// Nested pair
+static_assert(is_same<ArgsTuple<pair<P, int>, A>,
+                      tuple<piecewise_construct_t,
+                            tuple<piecewise_construct_t, tuple<const A&>,
+                                  PreArgs>,
+                            tuple<>>>::value, "");
+
+// Tuples whose elements all accept the allocator-extended constructor
+typedef tuple<SufA, int> T2;
+static_assert(is_same<ArgsTuple<T2, A>, PreArgs>::value, "");
+static_assert(is_same<ArgsTuple<T2, A, int, long&>,
+                      tuple<allocator_arg_t, const A&, int&&,
+                            long&>>::value, "");
+static_assert(is_same<ArgsTuple<T2, A, tuple<int, long>&>,
+                      tuple<allocator_arg_t, const A&, const int&,
+                            const long&>>::value, "");
+static_assert(is_same<ArgsTuple<T2, A, tuple<int, long>>,
+                      tuple<allocator_arg_t, const A&, int&&,
+                            long&&>>::value, "");
+
+} // close namespace args_types
+
+template <class Alloc1, bool Prefix1, bool usesAlloc1, bool usesMemRsrc1,
+          class Alloc2, bool Prefix2, bool usesAlloc2, bool usesMemRsrc2>
+void runTupleTest()
+{
+    using std::get;
+    using std::pair;
+    using std::tuple;
+
+    typedef TestType<Alloc1, Prefix1>        Elem1;
+    typedef TestType<Alloc2, Prefix2>        Elem2;
+    typedef tuple<Elem1, int, Elem2>         Obj;
+    typedef MySTLAlloc<int>                  IntAlloc;
+    typedef MyMemResource*                   MyPmrPtr;
+
+    char objBuffer alignas(Obj) [sizeof(Obj)];
+    Obj *pUninitObj = reinterpret_cast<Obj*>(objBuffer);
+
+    constexpr bool usesAlloc   = usesAlloc1 || usesAlloc2;
+    constexpr bool usesMemRsrc = usesMemRsrc1 || usesMemRsrc2;
+
+    int   val1 = 3;  // Value stored into first element of constructed tuples
+    short val2 = 7;  // Value stored into third element of constructed tuples
+
+    IntAlloc A0; // Default
+    IntAlloc A1(1);
+    MyPmrPtr pR0 = &DefaultResource;
+    MyMemResource R1(1); MyPmrPtr pR1 = &R1;
+
+    // A tuple uses the allocator only if one of its elements does.
+    TEST_ASSERT(usesAlloc ==
+                (exp::internal::has_allocator<Obj, IntAlloc>::value));
+    TEST_ASSERT(usesMemRsrc ==
+                (exp::internal::has_allocator<Obj, MyPmrPtr>::value));
+
+    // Test with allocator and no constructor arguments
+    {
+        auto args = exp::uses_allocator_construction_args<Obj>(A1);
+        const std::size_t numArgs = std::tuple_size<decltype(args)>::value;
+        TEST_ASSERT((usesAlloc ? 2 : 0) == numArgs);
+
+        Obj X = exp::make_obj_using_allocator<Obj>(A1);
+        TEST_ASSERT(0 == get<0>(X).value());
+        TEST_ASSERT(0 == get<1>(X));
+        TEST_ASSERT(0 == get<2>(X).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(X).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<2>(X).match_allocator(A1));
+        TEST_ASSERT((!usesAlloc1 && usesMemRsrc1) ==
+                    get<0>(X).match_resource(pR0));
+        TEST_ASSERT((!usesAlloc2 && usesMemRsrc2) ==
+                    get<2>(X).match_resource(pR0));
+    }
+
+    // Test with allocator and one value per element
+    {
+        Obj X = exp::make_obj_using_allocator<Obj>(A1, val1, 5, val2);
+        TEST_ASSERT(val1 == get<0>(X).value());
+        TEST_ASSERT(5 == get<1>(X));
+        TEST_ASSERT(val2 == get<2>(X).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(X).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<2>(X).match_allocator(A1));
+
+        Obj *pY = exp::uninitialized_construct_using_allocator(pUninitObj,
+                                                               A1, val1,
+                                                               5, val2);
+        TEST_ASSERT(val1 == get<0>(*pY).value());
+        TEST_ASSERT(val2 == get<2>(*pY).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(*pY).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<2>(*pY).match_allocator(A1));
+        pY->~Obj();
+    }
+
+    // Test with allocator and lvalue and rvalue tuple values
+    {
+        const tuple<int, int, short> cval(val1, 5, val2);
+        tuple<int, int, short> val(cval);
+
+        Obj X = exp::make_obj_using_allocator<Obj>(A1, cval);
+        TEST_ASSERT(val1 == get<0>(X).value());
+        TEST_ASSERT(val2 == get<2>(X).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(X).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<2>(X).match_allocator(A1));
+
+        Obj Y = exp::make_obj_using_allocator<Obj>(A1, val);
+        TEST_ASSERT(val1 == get<0>(Y).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(Y).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<2>(Y).match_allocator(A1));
+
+        Obj Z = exp::make_obj_using_allocator<Obj>(A1, std::move(val));
+        TEST_ASSERT(val1 == get<0>(Z).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(Z).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<2>(Z).match_allocator(A1));
+    }
+
+    // Test with memory_resource and one value per element
+    {
+        Obj X = exp::make_obj_using_allocator<Obj>(pR1, val1, 5, val2);
+        TEST_ASSERT(val1 == get<0>(X).value());
+        TEST_ASSERT(val2 == get<2>(X).value());
+        TEST_ASSERT(usesMemRsrc1 == get<0>(X).match_resource(pR1));
+        TEST_ASSERT(usesMemRsrc2 == get<2>(X).match_resource(pR1));
+        TEST_ASSERT((!usesMemRsrc1 && usesAlloc1) ==
+                    get<0>(X).match_allocator(A0));
+        TEST_ASSERT((!usesMemRsrc2 && usesAlloc2) ==
+                    get<2>(X).match_allocator(A0));
+    }
+
+    // Pair and tuple elements of a tuple, and a tuple inside a pair
+    {
+        typedef tuple<pair<Elem1, Elem2>, tuple<Elem2>> Obj2;
+
+        Obj2 X = exp::make_obj_using_allocator<Obj2>(A1,
+                                                    std::make_pair(val1, val2),
+                                                    std::make_tuple(val2));
+        TEST_ASSERT(val1 == get<0>(X).first.value());
+        TEST_ASSERT(val2 == get<0>(X).second.value());
+        TEST_ASSERT(val2 == get<0>(get<1>(X)).value());
+        TEST_ASSERT(usesAlloc1 == get<0>(X).first.match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<0>(X).second.match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<0>(get<1>(X)).match_allocator(A1));
+
+        typedef pair<tuple<Elem1, Elem2>, Elem2> Obj3;
+
+        Obj3 Y = exp::make_obj_using_allocator<Obj3>(A1);
+        TEST_ASSERT(usesAlloc1 == get<0>(Y.first).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == get<1>(Y.first).match_allocator(A1));
+        TEST_ASSERT(usesAlloc2 == Y.second.match_allocator(A1));
+    }
+}
+
+
+// Allocator-aware type with an unconstrained converting constructor.
+class Greedy
+{
+    MySTLAlloc<int> m_alloc;
+    int             m_value;
+
+public:
+    typedef MySTLAlloc<int> allocator_type;
+
+    template <class U>
+    explicit Greedy(U&& v, const allocator_type& a = allocator_type())
+        : m_alloc(a), m_value(static_cast<int>(v)) { }
+
+    int value() const { return m_value; }
+    int allocId() const { return m_alloc.id(); }
+};
+
+void runTupleElementTest()
+{
+    using std::get;
+    typedef MySTLAlloc<int> IntAlloc;
+
+    IntAlloc A1(1);
+    const CountedType a(1), b(2);
+
+    // Elements are constructed in place: one copy from each lvalue or one
+    // move from each rvalue, and nothing else.
+    {
+        typedef std::tuple<CountedType, int, CountedType> Obj;
+
+        CountedType::reset();
+        Obj x = exp::make_obj_using_allocator<Obj>(A1, a, 5, b);
+        TEST_ASSERT(2 == CountedType::s_copies);
+        TEST_ASSERT(0 == CountedType::s_moves);
+        TEST_ASSERT(1 == get<0>(x).value());
+        TEST_ASSERT(2 == get<2>(x).value());
+        TEST_ASSERT(1 == get<0>(x).allocId());
+        TEST_ASSERT(1 == get<2>(x).allocId());
+
+        Obj src(a, 5, b);
+        CountedType::reset();
+        Obj y = exp::make_obj_using_allocator<Obj>(A1, std::move(src));
+        TEST_ASSERT(0 == CountedType::s_copies);
+        TEST_ASSERT(2 == CountedType::s_moves);
+        TEST_ASSERT(2 == get<2>(y).value());
+        TEST_ASSERT(1 == get<2>(y).allocId());
+
+        char buf alignas(Obj) [sizeof(Obj)];
+        CountedType::reset();
+        Obj* p = exp::uninitialized_construct_using_allocator(
+            reinterpret_cast<Obj*>(buf), A1, x);
+        TEST_ASSERT(2 == CountedType::s_copies);
+        TEST_ASSERT(0 == CountedType::s_moves);
+        TEST_ASSERT(1 == get<0>(*p).allocId());
+        p->~Obj();
+    }
+
+    // Elements that can be neither copied nor moved
+    {
+        typedef std::tuple<NonMovable, int> Obj;
+        char buf alignas(Obj) [sizeof(Obj)];
+
+        Obj* p = exp::uninitialized_construct_using_allocator(
+            reinterpret_cast<Obj*>(buf), A1, 3, 4);
+        TEST_ASSERT(3 == get<0>(*p).value());
+        TEST_ASSERT(1 == get<0>(*p).allocId());
+        TEST_ASSERT(4 == get<1>(*p));
+        p->~Obj();
+
+        p = exp::uninitialized_construct_using_allocator(
+            reinterpret_cast<Obj*>(buf), A1);
+        TEST_ASSERT(0 == get<0>(*p).value());
+        TEST_ASSERT(1 == get<0>(*p).allocId());
+        p->~Obj();
+    }
+
+    // Elements with an unconstrained converting constructor
+    {
+        typedef std::tuple<Greedy, Greedy> Obj;
+
+        Obj x = exp::make_obj_using_allocator<Obj>(A1, 3, 4);
+        TEST_ASSERT(3 == get<0>(x).value());
+        TEST_ASSERT(4 == get<1>(x).value());
+        TEST_ASSERT(1 == get<0>(x).allocId());
+        TEST_ASSERT(1 == get<1>(x).allocId());
+    }
+}
+
+
 int main()
 {
     typedef MySTLAlloc<int>       IntAlloc;
@@ -1201,5 +2149,57 @@ int main()
     PAIR_TEST(EraseAlloc, 1, 1, 1, PolyAlloc,  1, 0, 1);
     PAIR_TEST(EraseAlloc, 0, 1, 1, EraseAlloc, 1, 1, 1);
 
+#define TUPLE_TEST(Alloc1, Prefix1, expUsesAlloc1, expUsesMemRsrc1,     \
+                   Alloc2, Prefix2, expUsesAlloc2, expUsesMemRsrc2) do { \
+        TestContext tc(__FILE__, __LINE__,                              \
+                       "tuple<TestType<" #Alloc1 "," #Prefix1 ">, int, " \
+                       "TestType<" #Alloc2 "," #Prefix2 ">>");          \
+        runTupleTest<Alloc1, Prefix1, expUsesAlloc1, expUsesMemRsrc1,   \
+                     Alloc2, Prefix2, expUsesAlloc2, expUsesMemRsrc2>(); \
+    } while (false)
+
+    TUPLE_TEST(NoAlloc,    0, 0, 0, NoAlloc,    0, 0, 0);
+    TUPLE_TEST(NoAlloc,    0, 0, 0, IntAlloc,   1, 1, 0);
+    TUPLE_TEST(IntAlloc,   0, 1, 0, IntAlloc,   1, 1, 0);
+    TUPLE_TEST(IntAlloc,   1, 1, 0, PolyAlloc,  0, 0, 1);
+    TUPLE_TEST(PolyAlloc,  1, 0, 1, NoAlloc,    0, 0, 0);
+    TUPLE_TEST(PolyAlloc,  0, 0, 1, EraseAlloc, 1, 1, 1);
+    TUPLE_TEST(EraseAlloc, 1, 1, 1, IntAlloc,   0, 1, 0);
+
+    {
+        TestContext tc(__FILE__, __LINE__, "tuple elements");
+        runTupleElementTest();
+    }
+
+    {
+        TestContext tc(__FILE__, __LINE__, "range construction");
+        runRangeTest();
+    }
+
+    {
+        TestContext tc(__FILE__, __LINE__, "copy and move");
+        runCopyMoveTest();
+    }
+
+    {
+        TestContext tc(__FILE__, __LINE__, "relocation");
+        runRelocateTest();
+    }
+
+    {
+        TestContext tc(__FILE__, __LINE__, "nested pairs");
+        runNestedPairTest();
+    }
+
+    {
+        TestContext tc(__FILE__, __LINE__, "destruction");
+        runDestroyTest();
+    }
+
+    {
+        TestContext tc(__FILE__, __LINE__, "noexcept");
+        runNoexceptTest();
+    }
+
     return errorCount();
 }
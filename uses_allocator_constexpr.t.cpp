@@ -0,0 +1,142 @@
+/* uses_allocator_constexpr.t.cpp                  -*-C++-*-
+ *
+ * Copyright (C) 2016 Pablo Halpern <phalpern@halpernwightsoftware.com>
+ * Distributed under the Boost Software License - Version 1.0
+ *
+ * Test driver for the C++20 build mode of `uses_allocator.h` and
+ * `make_from_tuple.h`, in which uses-allocator construction can be
+ * evaluated at compile time.  Must be compiled with `-std=c++20`.
+ */
+
+#include <uses_allocator.h>
+
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <test_assert.h>
+
+#if __cplusplus <= 201703L
+#error "uses_allocator_constexpr.t.cpp requires C++20"
+#endif
+
+namespace exp = std::Cpp20;
+
+// Literal allocator type identified by an integer.
+template <class T>
+struct IdAlloc
+{
+    typedef T value_type;
+
+    int m_id;
+
+    constexpr explicit IdAlloc(int id) : m_id(id) { }
+
+    template <class U>
+    constexpr IdAlloc(const IdAlloc<U>& other) : m_id(other.m_id) { }
+};
+
+// Literal type that takes the allocator as a trailing constructor argument.
+struct Trailing
+{
+    typedef IdAlloc<char> allocator_type;
+
+    int m_value;
+    int m_allocId;
+
+    constexpr Trailing(int v, const allocator_type& a)
+        : m_value(v), m_allocId(a.m_id) { }
+    constexpr explicit Trailing(const allocator_type& a)
+        : m_value(0), m_allocId(a.m_id) { }
+};
+
+// Literal type that takes the allocator after `allocator_arg`.
+struct Prefix
+{
+    typedef IdAlloc<char> allocator_type;
+
+    int m_value;
+    int m_allocId;
+
+    constexpr Prefix(std::allocator_arg_t, const allocator_type& a, int v)
+        : m_value(v), m_allocId(a.m_id) { }
+};
+
+constexpr IdAlloc<char> k_alloc(7);
+
+// `make_obj_using_allocator` for the two protocols and for pair and tuple
+// members, all evaluated at compile time.
+constexpr Trailing k_trailing =
+    exp::make_obj_using_allocator<Trailing>(k_alloc, 1);
+static_assert(1 == k_trailing.m_value && 7 == k_trailing.m_allocId, "");
+
+constexpr Prefix k_prefix = exp::make_obj_using_allocator<Prefix>(k_alloc, 2);
+static_assert(2 == k_prefix.m_value && 7 == k_prefix.m_allocId, "");
+
+constexpr std::pair<Trailing, int> k_pair =
+    exp::make_obj_using_allocator<std::pair<Trailing, int>>(k_alloc, 3, 4);
+static_assert(7 == k_pair.first.m_allocId && 4 == k_pair.second, "");
+
+constexpr auto k_tuple =
+    exp::make_obj_using_allocator<std::tuple<Prefix, Trailing, int>>(
+        k_alloc, 5, 6, 8);
+static_assert(7 == std::get<0>(k_tuple).m_allocId, "");
+static_assert(7 == std::get<1>(k_tuple).m_allocId, "");
+static_assert(6 == std::get<1>(k_tuple).m_value, "");
+
+// `uses_allocator_construction_args` and `make_from_tuple`
+static_assert(9 == std::make_from_tuple<Trailing>(
+                  exp::uses_allocator_construction_args<Trailing>(k_alloc, 9))
+              .m_value, "");
+
+// Build a table of pairs in storage obtained from `std::allocator` at
+// compile time with `uninitialized_construct_using_allocator`, and return
+// the sum of the values and allocator ids.
+constexpr int buildTable(int n)
+{
+    typedef std::pair<Prefix, Trailing> Entry;
+    std::allocator<Entry> sa;
+    Entry* table = sa.allocate(n);
+    for (int i = 0; i < n; ++i)
+        exp::uninitialized_construct_using_allocator(table + i, k_alloc,
+                                                     i, 10 * i);
+    int sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += table[i].first.m_value + table[i].second.m_value +
+               table[i].first.m_allocId + table[i].second.m_allocId;
+    std::destroy(table, table + n);
+    sa.deallocate(table, n);
+    return sum;
+}
+
+static_assert(11 * (0 + 1 + 2 + 3) + 4 * 14 == buildTable(4), "");
+
+// `uninitialized_construct_from_tuple`
+constexpr int fromTuple()
+{
+    std::allocator<Trailing> sa;
+    Trailing* p = sa.allocate(1);
+    std::Cpp17::uninitialized_construct_from_tuple(
+        p, std::make_tuple(3, k_alloc));
+    const int ret = p->m_value + p->m_allocId;
+    std::destroy_at(p);
+    sa.deallocate(p, 1);
+    return ret;
+}
+
+static_assert(10 == fromTuple(), "");
+
+int main()
+{
+    // The same functions remain usable at run time.
+    TEST_ASSERT(11 * (0 + 1 + 2 + 3 + 4) + 5 * 14 == buildTable(5));
+    TEST_ASSERT(10 == fromTuple());
+
+    IdAlloc<char> a(3);
+    std::pair<Trailing, Prefix> p =
+        exp::make_obj_using_allocator<std::pair<Trailing, Prefix>>(a, 1, 2);
+    TEST_ASSERT(3 == p.first.m_allocId);
+    TEST_ASSERT(3 == p.second.m_allocId);
+    TEST_ASSERT(2 == p.second.m_value);
+
+    return errorCount();
+}